@@ -43,6 +43,9 @@
 #   define XR_PROFILE_FEATURES_ENABLED 1
 #endif
 
+// XR_BENCHMARK_FEATURES_ENABLED is deliberately left undefined, define it
+// (cmake -DXR_BENCHMARKS=ON) to build the benchmarks into the unit tests.
+
 
 // Add additional configuration options here.
 
@@ -161,6 +161,31 @@ public:
     /*-------------------------------------------------------------------*/
     size_t Clear();
 
+    /*-------------------------------------------------------------------*/
+    /// A position in the allocator, see GetMarker. Opaque.
+    /*-------------------------------------------------------------------*/
+    struct Marker{
+        void    * mBucket;
+        uint8_t * mCurrent;
+    };
+    /*-------------------------------------------------------------------*/
+    /// The current position, to give back everything allocated after it
+    /// with Rollback.
+    /*-------------------------------------------------------------------*/
+    XR_FORCE_INLINE
+    Marker GetMarker() const
+    {
+        Marker marker = { mCurrentBucket, mCurrentBucket->mCurrent };
+        return marker;
+    }
+    /*-------------------------------------------------------------------*/
+    /// Frees everything allocated since \a marker was taken (and the
+    /// overflow buckets it needed). Markers nest: rolling back to one
+    /// invalidates those taken after it. Does not update the high water
+    /// mark.
+    /*-------------------------------------------------------------------*/
+    void Rollback(const Marker & marker);
+
     /*-------------------------------------------------------------------*/
     /// This returns the higher amount of bytes used at the time of a clear.
     /*-------------------------------------------------------------------*/
@@ -205,5 +230,39 @@ private:
     LinearAllocator & operator= (const LinearAllocator & other);
 };
 
+// ***************************************************************************************** - TYPE
+/*! Rolls \a allocator back to where it was at construction when the
+    scope is left. Does nothing for a nullptr allocator.
+*/
+// ***************************************************************************************** - TYPE
+class LinearAllocatorScope{
+public:
+    /*-------------------------------------------------------------------*/
+    /*-------------------------------------------------------------------*/
+    XR_INLINE
+    explicit LinearAllocatorScope(LinearAllocator * allocator) : mAllocator(allocator)
+    {
+        if(allocator != nullptr)
+        {
+            mMarker = allocator->GetMarker();
+        }
+    }
+    /*-------------------------------------------------------------------*/
+    /*-------------------------------------------------------------------*/
+    XR_INLINE
+    ~LinearAllocatorScope()
+    {
+        if(mAllocator != nullptr)
+        {
+            mAllocator->Rollback(mMarker);
+        }
+    }
+private:
+    LinearAllocatorScope(const LinearAllocatorScope &);
+    LinearAllocatorScope & operator= (const LinearAllocatorScope &);
+    LinearAllocator         * mAllocator;
+    LinearAllocator::Marker   mMarker;
+};
+
 }}
 #endif //#ifndef XR_CORE_ALLOCATORS_LINEAR_H
@@ -58,6 +58,11 @@ protected:
     // ------------------------------------------------------------------------------------  MEMBER
     size_t InsertionLock();
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Same as InsertionLock but does not wait. Returns 0 (and does not
+    /// hold the lock) if nothing can be inserted.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t TryInsertionLock();
+    // ------------------------------------------------------------------------------------  MEMBER
     /// Pass in the number of entries actually inserted
     // ------------------------------------------------------------------------------------  MEMBER
     void InsertionUnLock( size_t numInserted );
@@ -66,6 +71,11 @@ protected:
     // ------------------------------------------------------------------------------------  MEMBER
     size_t RemovalLock( );
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Same as RemovalLock but does not wait. Returns 0 (and does not hold
+    /// the lock) if nothing can be removed.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t TryRemovalLock( );
+    // ------------------------------------------------------------------------------------  MEMBER
     /// pass in the number of entries actually removed
     // ------------------------------------------------------------------------------------  MEMBER
     void RemovalUnLock( size_t numRemoved );
@@ -76,6 +76,7 @@ extern "C" {
     extern long __cdecl _InterlockedIncrement (long volatile *);
     extern long __cdecl _InterlockedDecrement (long volatile *);
     extern long __cdecl _InterlockedExchangeAdd (long volatile *, long);
+    extern void __cdecl _ReadWriteBarrier(void);
 
 #if defined(XR_CPU_X64)
     unsigned char __cdecl _InterlockedCompareExchange128(__int64 volatile * Destination, __int64 ExchangeHigh,__int64 ExchangeLow, __int64 * ComparandResult);
@@ -91,6 +92,7 @@ extern "C" {
 #   pragma intrinsic(_InterlockedIncrement)
 #   pragma intrinsic(_InterlockedDecrement)
 #   pragma intrinsic(_InterlockedExchangeAdd)
+#   pragma intrinsic(_ReadWriteBarrier)
 #endif
 
 #if defined(XR_CPU_X64)
@@ -331,6 +333,36 @@ inline T AtomicSubtract(T volatile* __ptr, T value)
     static_assert( sizeof(T) == 4 || sizeof(T) == 8, "Size Check Failed");
     return detail::AtomicSub<T, sizeof(T)>::DoIt(__ptr, value);
 }
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+inline T AtomicLoadAcquire(T const volatile* __ptr)
+{
+    static_assert( sizeof(T) <= XR_PLATFORM_PTR_SIZE, "Size Check Failed");
+    // Volatile accesses have acquire / release semantics on x86 / x64 with
+    // the microsoft compiler, only need to keep the compiler in line.
+    T value = *__ptr;
+    _ReadWriteBarrier();
+    return value;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+inline void AtomicStoreRelease(T volatile* __ptr, T value)
+{
+    static_assert( sizeof(T) <= XR_PLATFORM_PTR_SIZE, "Size Check Failed");
+    _ReadWriteBarrier();
+    *__ptr = value;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+inline void AtomicFence()
+{
+    // Same approach as MemoryBarrier() from winnt.h, a locked operation
+    // on a stack value is a full fence.
+    long volatile barrier = 0;
+    _InterlockedExchangeAdd(&barrier, 0);
+}
 // ######################################################################################### - FILE
 // ######################################################################################### - FILE
 #elif defined(XR_COMPILER_GCC)
@@ -361,6 +393,26 @@ inline T AtomicSubtract(T volatile* __ptr, T value)
 {
     return __sync_fetch_and_sub( (__ptr), (value) );
 }
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+inline T AtomicLoadAcquire(T const volatile* __ptr)
+{
+    return __atomic_load_n( (__ptr), __ATOMIC_ACQUIRE );
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+inline void AtomicStoreRelease(T volatile* __ptr, T value)
+{
+    __atomic_store_n( (__ptr), (value), __ATOMIC_RELEASE );
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+inline void AtomicFence()
+{
+    __sync_synchronize();
+}
 
 namespace detail
 {
@@ -507,6 +559,38 @@ inline T AtomicSubtract(T volatile* __ptr, T value)
 //@}
 // --------------------------------------------------------------------------------------  FUNCTION
 /*!
+Reads a value with acquire semantics, no later read or write may be moved
+before it. Only for values up to pointer size.
+*/
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+inline T AtomicLoadAcquire(T const volatile* __ptr)
+{
+    return *__ptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!
+Writes a value with release semantics, no earlier read or write may be moved
+after it. Only for values up to pointer size. Use this to publish data to
+another thread which reads the value with AtomicLoadAcquire.
+*/
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+inline void AtomicStoreRelease(T volatile* __ptr, T value)
+{
+    *__ptr = value;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!
+Full memory fence. Prevents stores before it from being reordered with loads
+after it, which acquire / release alone do not guarantee.
+*/
+// --------------------------------------------------------------------------------------  FUNCTION
+inline void AtomicFence()
+{
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!
 Performs an atomic "compare and swap" on the specified address. This works on
 4, 8 byte values, and 16 byte values on 64-bit architectures.
 
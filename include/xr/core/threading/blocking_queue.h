@@ -94,10 +94,20 @@ public:
     // ------------------------------------------------------------------------------------  MEMBER
     void Dequeue(XR_OUT_COUNT(count) T * itemList, size_t count);
     // ------------------------------------------------------------------------------------  MEMBER
+    /*! Remove an entry if one is available, returns false without blocking
+        if the queue is empty. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool TryDequeue(T * item);
+    // ------------------------------------------------------------------------------------  MEMBER
     /*! Block until the item can be inserted . */
     // ------------------------------------------------------------------------------------  MEMBER
     void Enqueue(const T & item);
     // ------------------------------------------------------------------------------------  MEMBER
+    /*! Insert the item if there is room, returns false without blocking
+        if the queue is full. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool TryEnqueue(const T & item);
+    // ------------------------------------------------------------------------------------  MEMBER
     /*! Block until the items can be inserted. */
     // ------------------------------------------------------------------------------------  MEMBER
     void Enqueue(XR_IN_COUNT(count) const T * itemList, size_t count);
@@ -207,6 +217,21 @@ T BlockingQueue<T>::Dequeue()
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 template<typename T>
+bool BlockingQueue<T>::TryDequeue(T * item)
+{
+    if(TryRemovalLock() == 0)
+    {
+        return false;
+    }
+
+    *item = DequeueInternal();
+
+    RemovalUnLock(1);
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
 void BlockingQueue<T>::Dequeue(XR_OUT_COUNT(count) T * itemList, size_t count)
 {
     T * itemCurrent = itemList;
@@ -240,6 +265,20 @@ void BlockingQueue<T>::Enqueue(const T &item)
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 template<typename T>
+bool BlockingQueue<T>::TryEnqueue(const T &item)
+{
+    if(TryInsertionLock() == 0)
+    {
+        return false;
+    }
+
+    EnqueueInternal(item);
+    InsertionUnLock(1);
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
 void BlockingQueue<T>::Enqueue(XR_IN_COUNT(count) const T * itemList, size_t count)
 {
     const T * itemCurrent = itemList;
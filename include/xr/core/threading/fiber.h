@@ -0,0 +1,126 @@
+// ######################################################################################### - FILE
+/*! \file
+    \brief User mode execution contexts (fibers).
+
+A Fiber is a stack plus the registers needed to resume execution on it.
+Switching between fibers is cooperative and happens entirely on the
+calling thread: SwitchTo saves the caller into one Fiber and continues the
+other where it last left off (or at its entry point the first time).
+
+A thread's own stack is made a Fiber with AttachToThread, so there is
+somewhere to switch back to. A fiber created with Create may be resumed
+by any thread, but only by one at a time, and never while it is running.
+
+Implemented with the Windows fiber API, with a few lines of assembly on
+x64 Linux, and with ucontext elsewhere. swapcontext also saves and
+restores the signal mask, a system call per switch, so that fallback is
+several times slower than the others.
+
+Posix stacks are mapped whole pages with an inaccessible guard page below,
+Windows reserves its own; overflowing either faults rather than corrupting
+memory, still size them for the deepest call chain that runs on them.
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+// Guard
+// ######################################################################################### - FILE
+#ifndef XR_CORE_THREADING_FIBER_H
+#define XR_CORE_THREADING_FIBER_H
+
+#if defined( _MSC_VER )
+#pragma once
+#endif
+// ######################################################################################### - FILE
+/* Public Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#error "Must include xr/defines.h first!"
+#endif
+// ######################################################################################### - FILE
+/* Public Macros */
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Declarations */
+// ######################################################################################### - FILE
+namespace xr { namespace Core {
+
+// ***************************************************************************************** - TYPE
+/*! \copydoc fiber.h
+*/
+// ***************************************************************************************** - TYPE
+class Fiber{
+public:
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Where a created fiber starts. It must never return, switch away
+    /// for the last time instead.
+    // ------------------------------------------------------------------------------------  MEMBER
+    typedef void (*EntryPoint)(void * context);
+
+    Fiber();
+    ~Fiber();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Allocates a stack of at least \a stackSize bytes (whole pages on
+    /// posix, see GetStackSize), \a entry(\a context) runs
+    /// on it the first time the fiber is switched to. Returns false if the
+    /// system refused.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool Create(EntryPoint entry, void * context, size_t stackSize);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Makes this Fiber stand for the calling thread's own stack. Detach
+    /// (on the same thread) before the thread exits.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void AttachToThread();
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void DetachFromThread();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Saves the calling context in \a from (which must be what is running)
+    /// and continues \a to. Returns when something switches back to \a from.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static void Switch(Fiber & from, Fiber & to);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// True once Create or AttachToThread succeeded.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool IsValid() const { return mContext != nullptr; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t GetStackSize() const { return mStackSize; }
+
+private:
+    Fiber(const Fiber &);
+    Fiber & operator=(const Fiber &);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Calls mEntry, bridges the platform's entry signature.
+    // ------------------------------------------------------------------------------------  MEMBER
+#if defined(XR_PLATFORM_WINDOWS)
+    static void __stdcall Start(void * fiber);
+#else
+    static void Start(void * fiber);
+    static void Start(unsigned int high, unsigned int low);
+#endif
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The fiber handle on Windows, the saved stack pointer on x64 Linux,
+    /// a ucontext_t elsewhere.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void       * mContext;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// nullptr for an attached thread (and on Windows, which owns it).
+    // ------------------------------------------------------------------------------------  MEMBER
+    void       * mStack;
+    size_t       mStackSize;
+    EntryPoint   mEntry;
+    void       * mEntryContext;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// AttachToThread converted the thread (Windows), undo it on detach.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool         mConverted;
+};
+
+}}//namespace xr::Core
+
+#endif //#ifndef XR_CORE_THREADING_FIBER_H
@@ -103,6 +103,13 @@ public:
     void Wait(XR_IN xr::Core::Mutex & mutex) const ;
     void Wait(XR_IN xr::Core::RecursiveMutex & mutex) const ;
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Wait for Signal or until \a microSeconds have passed, returns false
+    /// on timeout. Windows rounds the timeout up to whole milliseconds.
+    /// Measured on a monotonic clock, wall clock changes do not move it.
+    /// \warning Caller must have *already* locked the passed mutex!
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool Wait(XR_IN xr::Core::Mutex & mutex, uint64_t microSeconds) const ;
+    // ------------------------------------------------------------------------------------  MEMBER
     /// Signal a single Thread
     // ------------------------------------------------------------------------------------  MEMBER
     void Signal() const ;
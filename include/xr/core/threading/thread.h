@@ -84,6 +84,20 @@ public:
     /// Platform independent Thread priority type
     // ------------------------------------------------------------------------------------  MEMBER
     typedef uintptr_t ThreadPriority;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// SetAffinity value meaning the OS picks the processor.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t kNoAffinity = ~size_t(0);
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// One logical processor the process may run on, see GetProcessorInfo
+    // ------------------------------------------------------------------------------------  MEMBER
+    struct ProcessorInfo
+    {
+        uint32_t mProcessor;    ///< Index to pass to SetAffinity
+        uint32_t mCore;         ///< Physical core, processors sharing one are SMT siblings
+        uint32_t mNode;         ///< NUMA node, 0 if unknown
+    };
 
 
     // ------------------------------------------------------------------------------------  MEMBER
@@ -170,6 +184,18 @@ public:
     // ------------------------------------------------------------------------------------  MEMBER
     void SetPriority(ThreadPriority newPriority);
 
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// \brief Pin the thread to a single logical processor.
+    /// \note Must be called before Start, the new thread applies it to
+    ///       itself before Run. Ignored where the system has no support.
+    /// \param processor ProcessorInfo::mProcessor or kNoAffinity
+    // ------------------------------------------------------------------------------------  MEMBER
+    void SetAffinity(size_t processor) { mAffinity = processor; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// \brief Return the processor passed to SetAffinity (kNoAffinity by default)
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t GetAffinity() const { return mAffinity; }
+
     // ------------------------------------------------------------------------------------  MEMBER
     /// \brief Call this to request a cooperative quit. Client code should check this value periodically
     /// \sa IsQuitRequested
@@ -211,6 +237,13 @@ public:
     /// then is requested. For consistent results, use a better mechanism (Mutex, semaphore, etc)
     // ------------------------------------------------------------------------------------  MEMBER
     static void YieldCurrentThread(uint32_t timeout_ms);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// \brief Describe the logical processors available to this process.
+    /// \param[out] info may be nullptr if maxCount is 0
+    /// \return The number of processors, which may be more than maxCount
+    ///         (only maxCount entries are written).
+    // ------------------------------------------------------------------------------------  MEMBER
+    static size_t GetProcessorInfo(ProcessorInfo * info, size_t maxCount);
 
 protected:
     // ------------------------------------------------------------------------------------  MEMBER
@@ -280,6 +313,11 @@ private:
     // ------------------------------------------------------------------------------------  MEMBER
     volatile bool mHasRequestedQuit;
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Processor to pin to, applied in ThreadEntry
+    /// /sa SetAffinity
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t        mAffinity;
+    // ------------------------------------------------------------------------------------  MEMBER
     // This is an internal object that is created when you call
     // GetCurrentThread from a thread not created via this system.
     // ------------------------------------------------------------------------------------  MEMBER
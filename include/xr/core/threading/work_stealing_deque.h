@@ -0,0 +1,229 @@
+// ######################################################################################### - FILE
+/*! \file
+Bounded work stealing deque (Chase-Lev). A single owner thread pushes and
+pops at the bottom (LIFO), any number of other threads steal from the top
+(FIFO). Nothing takes a lock. Push is plain stores (the bottom with release).
+Pop must order its claim of the bottom before reading the top, which needs
+a full fence whichever way it is written; it uses one locked decrement
+(about the cost of a fence, tens of cycles on x86), plus a compare and swap
+when racing a thief for the last entry. Steal uses a fence and a single
+compare and swap.
+
+Unlike BlockingQueue this never blocks, Push fails when the deque is full and
+Pop / Steal fail when it is empty. The caller decides what to do instead
+(typically fall back to a shared queue or look elsewhere for work).
+
+Only pointer sized (or smaller) POD values can be stored, entries are read
+by thieves while the owner may be writing the slot of a later index.
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+// Guard
+// ######################################################################################### - FILE
+#ifndef XR_CORE_THREADING_WORK_STEALING_DEQUE_H
+#define XR_CORE_THREADING_WORK_STEALING_DEQUE_H
+
+#if defined( _MSC_VER )
+#pragma once
+#endif
+// ######################################################################################### - FILE
+/* Public Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#error "Must include xr/defines.h first!"
+#endif
+#ifndef XR_CORE_THREADING_ATOMIC_H
+#include "xr/core/threading/atomic.h"
+#endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+
+#include <type_traits>
+
+// ######################################################################################### - FILE
+/* Public Macros */
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Forward Declarations */
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Declarations */
+// ######################################################################################### - FILE
+namespace xr { namespace Core {
+
+/*######################################################################*/
+/*!  Work stealing deque. Push / Pop may only be called from the owning
+        thread. Steal may be called from any thread. The capacity is
+        rounded up to a power of two.
+        */
+/*######################################################################*/
+template<typename T>
+class WorkStealingDeque{
+public:
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*! Allocates storage for at least \a capacity entries. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    WorkStealingDeque(size_t capacity, const char * name = "WorkStealingDeque");
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    ~WorkStealingDeque() { XR_FREE((void*)mContents); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*! Owner only. Returns false if the deque is full. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool Push(const T & item);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*! Owner only. Removes the most recently pushed entry, returns false
+        if the deque is empty. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool Pop(T * item);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*! Any thread. Removes the oldest entry, returns false if the deque
+        is empty or another thread won the race for the entry. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool Steal(T * item);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*! Number of entries at that instant, may be stale by the time it returns. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline size_t UnsafeGetCount() const
+    {
+        intptr_t count = mBottom - mTop;
+        return count > 0 ? size_t(count) : 0;
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline size_t GetCapacity() const { return size_t(kMask) + 1; }
+private:
+    /// \internal Prevent copy / assignment.
+    WorkStealingDeque( const WorkStealingDeque & );
+    WorkStealingDeque & operator=( const WorkStealingDeque & );
+
+    static_assert( std::is_pod<T>::value || std::is_integral<T>::value, "Contained types must be POD or integral");
+    static_assert( sizeof(T) <= sizeof(uintptr_t), "Contained types must be pointer sized or smaller");
+
+    static const size_t kCacheLineSize = 64;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Steal end, only ever incremented (by CAS).
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile intptr_t mTop;
+    uint8_t           mPadTop[kCacheLineSize - sizeof(intptr_t)];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Owner end, only written by the owner.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile intptr_t mBottom;
+    uint8_t           mPadBottom[kCacheLineSize - sizeof(intptr_t)];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Capacity - 1
+    // ------------------------------------------------------------------------------------  MEMBER
+    const intptr_t    kMask;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Array of entries
+    // ------------------------------------------------------------------------------------  MEMBER
+    T volatile      * mContents;
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Rounds the requested capacity up to the next power of two.
+// --------------------------------------------------------------------------------------  FUNCTION
+inline size_t WorkStealingDequeRoundCapacity(size_t capacity)
+{
+    size_t rounded = 2;
+    while(rounded < capacity)
+    {
+        rounded <<= 1;
+    }
+    return rounded;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity, const char * name) :
+    mTop(0),
+    mBottom(0),
+    kMask(intptr_t(WorkStealingDequeRoundCapacity(capacity)) - 1)
+{
+    mContents = (T volatile *)XR_ALLOC_ALIGN(sizeof(T) * size_t(kMask + 1), name, kCacheLineSize);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+bool WorkStealingDeque<T>::Push(const T &item)
+{
+    intptr_t b = mBottom;
+    intptr_t t = AtomicLoadAcquire(&mTop);
+    if(b - t > kMask)
+    {
+        return false;
+    }
+
+    mContents[b & kMask] = item;
+
+    // Publish the entry before the new bottom.
+    AtomicStoreRelease(&mBottom, b + 1);
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+bool WorkStealingDeque<T>::Pop(T * item)
+{
+    // Claim the bottom entry. The locked decrement doubles as the fence
+    // ordering the bottom store against the top load below.
+    intptr_t b = AtomicDecrement(&mBottom) - 1;
+    intptr_t t = mTop;
+
+    if(t > b)
+    {
+        // Was empty, restore.
+        mBottom = b + 1;
+        return false;
+    }
+
+    *item = mContents[b & kMask];
+
+    if(t != b)
+    {
+        // More than one entry, no thief can reach this one.
+        return true;
+    }
+
+    // Last entry, race any thieves for it.
+    bool won = AtomicCompareAndSwap(&mTop, t, t + 1) == t;
+    mBottom = b + 1;
+    return won;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template<typename T>
+bool WorkStealingDeque<T>::Steal(T * item)
+{
+    intptr_t t = AtomicLoadAcquire(&mTop);
+    AtomicFence();
+    intptr_t b = AtomicLoadAcquire(&mBottom);
+
+    if(t >= b)
+    {
+        return false;
+    }
+
+    // Read before the CAS, once top moves the owner may reuse the slot.
+    T temp = mContents[t & kMask];
+    if(AtomicCompareAndSwap(&mTop, t, t + 1) != t)
+    {
+        return false;
+    }
+    *item = temp;
+    return true;
+}
+
+}} // namespace
+#endif //#ifndef XR_CORE_THREADING_WORK_STEALING_DEQUE_H
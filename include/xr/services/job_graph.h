@@ -0,0 +1,185 @@
+// ######################################################################################### - FILE
+/*!
+
+\page job_graph Job Graphs
+A JobGraph records a DAG of jobs once and launches it any number of times.
+Intended for work submitted every frame / tick with the same shape, where
+building the dependencies with InsertBlocked / InsertAfter each time would
+cost a JobInstance, an XID and a successor link per job and edge.
+
+\par Recording
+Nodes are added with AddNode (a Runnable and Arguments, or a lambda which
+the graph keeps) and ordered with AddEdge. The first Launch after an edit
+builds the successor arrays and antecedent counts, later launches reuse
+them.
+
+\par Launching
+Launch copies the antecedent counts into the per launch counters in one go
+and queues the roots. A node that finishes decrements its successors'
+counters directly, runs the first successor it enabled itself (when that
+is not of a lower priority) and queues the rest, so a chain of nodes costs
+one job. The returned handle completes once every node has run. A graph
+can only be running once at a time, and must not be edited or destroyed
+while running.
+
+\file
+\brief Recordable, replayable job graphs
+\copydoc job_graph
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+// Guard
+// ######################################################################################### - FILE
+#ifndef XR_SERVICES_JOB_GRAPH_H
+#define XR_SERVICES_JOB_GRAPH_H
+
+#if defined( _MSC_VER )
+#pragma once
+#endif
+// ######################################################################################### - FILE
+/* Public Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#error "Must include xr/defines.h first!"
+#endif
+#ifndef XR_SERVICES_SCHEDULING_H
+#include "xr/services/scheduling.h"
+#endif
+#ifndef XR_CORE_CONTAINERS_VECTOR
+#include "xr/core/containers/vector.h"
+#endif
+// ######################################################################################### - FILE
+/* Public Macros */
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Declarations */
+// ######################################################################################### - FILE
+namespace xr { namespace Scheduling {
+
+// ***************************************************************************************** - TYPE
+/*! \copydoc job_graph
+    */
+// ***************************************************************************************** - TYPE
+class JobGraph
+{
+public:
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobGraph();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Must not be running.
+    // ------------------------------------------------------------------------------------  MEMBER
+    ~JobGraph();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Adds a node running \a r with a copy of \a args. Returns its index.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t AddNode(Core::Runnable r, const Core::Arguments * args = nullptr, Priority priority = kPriorityNormal);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Adds a node running \a lambda, which the graph keeps (and calls once
+    /// per launch) until it is destroyed. Returns its index.
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline size_t AddNode(T lambda, Priority priority = kPriorityNormal);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Type erased form of the lambda AddNode, moves \a object into the graph.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t AddNodePayload(const detail::PayloadType * type, void * object, Priority priority);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Node \a after will not start before node \a before is complete.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void AddEdge(size_t before, size_t after);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runs every node on \a manager, returns a handle which completes once
+    /// they all have. The graph must not be running.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle Launch(IManager * manager);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// True from Launch until every node has run.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool IsRunning() const;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline size_t GetNodeCount() const { return mNodeCount; }
+
+private:
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    struct Node
+    {
+        Core::Runnable  mRunnable;
+        uintptr_t       mArguments[4];              ///< Core::Arguments is not POD, see Core::Vector
+        void          * mPayload;                   ///< Lambda nodes, the graph's copy (also in a0)
+        void          (*mDestroy)(void * object);   ///< Lambda nodes, nullptr when trivially destructible
+        uint32_t        mSuccessorBegin;            ///< Into mSuccessors
+        uint32_t        mSuccessorCount;
+        uint32_t        mPriority;
+    };
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    struct Edge
+    {
+        uint32_t mBefore;
+        uint32_t mAfter;
+    };
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Builds the successor arrays, antecedent counts and roots.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Compile();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Queues \a nodeIndex as a job on mManager.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Start(size_t nodeIndex);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Job entry point. a0 = graph, a1 = node.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static void RunNodes(const Core::Arguments * args);
+
+    Core::Vector<Node>      mNodes;
+    Core::Vector<Edge>      mEdges;
+    Core::Vector<uint32_t>  mSuccessors;
+    Core::Vector<uint32_t>  mRoots;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Antecedents of each node, copied to mRemaining by Launch.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::Vector<uint32_t>  mAntecedentCounts;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Per launch antecedent counters, one per node.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uint32_t     * mRemaining;
+    size_t                  mNodeCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Nodes of the current launch yet to finish.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile size_t         mRemainingNodes;
+    bool                    mCompiled;
+    IManager              * mManager;
+    JobHandleBlocked        mDone;
+
+    // Prevent copies
+    JobGraph(const JobGraph &);
+    JobGraph & operator= (const JobGraph &);
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline
+size_t JobGraph::AddNode(T lambda, Priority priority)
+{
+    typedef void (T::*ExpectedFunctionType)() const;
+
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
+
+    return AddNodePayload(detail::PayloadTypeOf<T>::Get(), &lambda, priority);
+}
+
+}}
+
+#endif //#ifndef XR_SERVICES_JOB_GRAPH_H
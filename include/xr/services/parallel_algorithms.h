@@ -0,0 +1,453 @@
+// ######################################################################################### - FILE
+/*!
+
+\page parallel_algorithms Parallel Algorithms
+Reduction, inclusive scan and sort of arrays on an IManager's workers.
+Each returns a JobHandle which completes once the result is written and
+splits the work into chunks of \a grainSize elements. An input of
+\a grainSize elements or less is done inline (serially) before returning,
+with an already completed handle. The arrays must stay valid, and the
+output untouched, until the handle completes.
+
+Element types must be trivially copyable, partial results and scratch
+space are plain memory from the general allocator. Operators are copied
+and called from several workers at once, they must be associative (and
+free of side effects), the order of elements they see is the array order
+so floating point results do not depend on the thread count.
+
+\par Reduce
+Every chunk is folded by one job, the chunk results are then folded in
+order by a continuation.
+
+\par Scan
+Three passes: chunk totals, a serial scan over the (few) totals, then
+every chunk scanned from its carry. Reads each input element twice, the
+output may be the input.
+
+\par Sort
+Merge sort: chunks are sorted by std::sort in parallel, then runs are
+merged pairwise until one is left. Each merge pass splits the output in
+grain sized pieces (finding where a piece starts in both runs by binary
+search, the merge path), so the last passes, with a couple of long runs,
+keep every worker busy too. Passes alternate between the array and an
+equally sized scratch buffer, the chunk sort starts in whichever one
+makes the last pass land in the array. Not stable.
+
+\file
+\brief Parallel reduce, scan and sort on the scheduler
+\copydoc parallel_algorithms
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+// Guard
+// ######################################################################################### - FILE
+#ifndef XR_SERVICES_PARALLEL_ALGORITHMS_H
+#define XR_SERVICES_PARALLEL_ALGORITHMS_H
+
+#if defined( _MSC_VER )
+#pragma once
+#endif
+// ######################################################################################### - FILE
+/* Public Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#error "Must include xr/defines.h first!"
+#endif
+#ifndef XR_SERVICES_SCHEDULING_H
+#include "xr/services/scheduling.h"
+#endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
+#include <algorithm>
+#include <type_traits>
+// ######################################################################################### - FILE
+/* Public Macros */
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Declarations */
+// ######################################################################################### - FILE
+namespace xr { namespace Scheduling {
+
+// ------------------------------------------------------------------------------------------  MEMBER
+/// Default elements per chunk.
+// ------------------------------------------------------------------------------------------  MEMBER
+static const size_t kParallelGrainSize = 4096;
+
+namespace detail {
+// ***************************************************************************************** - TYPE
+/// operator< as a functor, the default ordering of ParallelSort.
+// ***************************************************************************************** - TYPE
+template <class T>
+struct DefaultLess
+{
+    bool operator()(const T & a, const T & b) const { return a < b; }
+};
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  Folds the \a count elements of \a data with \a op (called as
+        op(const T &, const T &) and returning T) into \a *result. An
+        empty array gives \a identity.
+*/
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T, class Op>
+inline
+JobHandle ParallelReduce(
+    IManager * manager,
+    const T * data,
+    size_t count,
+    const T & identity,
+    const Op & op,
+    T * result,
+    size_t grainSize = kParallelGrainSize,
+    Priority priority = kPriorityNormal);
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  output[i] = input[0] op input[1] op ... op input[i] for the \a count
+        elements. \a output may be \a input.
+*/
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T, class Op>
+inline
+JobHandle ParallelInclusiveScan(
+    IManager * manager,
+    const T * input,
+    T * output,
+    size_t count,
+    const Op & op,
+    size_t grainSize = kParallelGrainSize,
+    Priority priority = kPriorityNormal);
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  Sorts the \a count elements of \a data in place by \a less (a strict
+        weak ordering, operator< by default). Not stable.
+*/
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T, class Less = detail::DefaultLess<T> >
+inline
+JobHandle ParallelSort(
+    IManager * manager,
+    T * data,
+    size_t count,
+    const Less & less = Less(),
+    size_t grainSize = kParallelGrainSize,
+    Priority priority = kPriorityNormal);
+
+
+// ######################################################################################### - FILE
+/* Implementation */
+// ######################################################################################### - FILE
+namespace detail {
+// ***************************************************************************************** - TYPE
+/*! Shared by the jobs of one ParallelReduce / ParallelInclusiveScan. The
+    last continuation deletes it. */
+// ***************************************************************************************** - TYPE
+template <class T, class Op>
+struct ChunkedState
+{
+    ChunkedState(IManager * manager, const T * input, size_t count, size_t grainSize, const Op & op, Priority priority) :
+        mManager(manager), mInput(input), mOutput(nullptr), mCount(count), mGrainSize(grainSize),
+        mChunkCount((count - 1) / grainSize + 1), mPriority(priority), mOp(op)
+    {
+        mPartials = (T *)XR_ALLOC_ALIGN(sizeof(T) * mChunkCount, "ParallelAlgorithms", std::alignment_of<T>::value < 16 ? 16 : std::alignment_of<T>::value);
+    }
+    ~ChunkedState() { XR_FREE(mPartials); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Folds chunk \a chunk of mInput.
+    // ------------------------------------------------------------------------------------  MEMBER
+    T FoldChunk(size_t chunk) const
+    {
+        const T * it  = mInput + chunk * mGrainSize;
+        const T * end = mInput + (chunk == mChunkCount - 1 ? mCount : (chunk + 1) * mGrainSize);
+        T value = *it;
+        for(++it; it != end; ++it)
+        {
+            value = mOp(value, *it);
+        }
+        return value;
+    }
+
+    IManager       * mManager;
+    const T        * mInput;
+    T              * mOutput;
+    size_t           mCount;
+    size_t           mGrainSize;
+    size_t           mChunkCount;
+    Priority         mPriority;
+    Op               mOp;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// One per chunk: its fold, then (scan) the fold of every chunk before it.
+    // ------------------------------------------------------------------------------------  MEMBER
+    T              * mPartials;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Scan only, released by the last pass.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandleBlocked mDone;
+private:
+    ChunkedState & operator=(const ChunkedState &);
+};
+// ***************************************************************************************** - TYPE
+/*! Shared by the jobs of one ParallelSort, deleted by the last pass. */
+// ***************************************************************************************** - TYPE
+template <class T, class Less>
+struct SortState
+{
+    SortState(IManager * manager, T * data, size_t count, size_t grainSize, const Less & less, Priority priority) :
+        mManager(manager), mData(data), mCount(count), mGrainSize(grainSize), mWidth(grainSize), mPriority(priority), mLess(less)
+    {
+        mScratch = (T *)XR_ALLOC_ALIGN(sizeof(T) * count, "ParallelSort", std::alignment_of<T>::value < 16 ? 16 : std::alignment_of<T>::value);
+        // The chunk sort goes where an even number of merge passes leaves
+        // the result in mData.
+        size_t passes = 0;
+        for(size_t width = grainSize; width < count; width *= 2)
+        {
+            ++passes;
+        }
+        mSource = (passes & 1) != 0 ? mScratch : mData;
+        mTarget = (passes & 1) != 0 ? mData : mScratch;
+    }
+    ~SortState() { XR_FREE(mScratch); }
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Elements of the \a na long run \a a among the first \a k of the
+    /// merge of runs \a a and \a b (ties taken from \a a first, as
+    /// std::merge does).
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t CoRank(size_t k, const T * a, size_t na, const T * b, size_t nb) const
+    {
+        size_t low  = k > nb ? k - nb : 0;
+        size_t high = k < na ? k : na;
+        while(low < high)
+        {
+            const size_t i = low + (high - low) / 2;
+            const size_t j = k - i;
+            // a[i] precedes b[j - 1] in the merge, so more of a is needed.
+            if(j > 0 && !mLess(b[j - 1], a[i]))
+            {
+                low = i + 1;
+            }
+            else
+            {
+                high = i;
+            }
+        }
+        return low;
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Writes mTarget[begin, end) of the current pass.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Merge(size_t begin, size_t end) const
+    {
+        const size_t pairWidth = mWidth * 2;
+        for(size_t pair = begin - begin % pairWidth; pair < end; pair += pairWidth)
+        {
+            const size_t mid  = std::min(pair + mWidth, mCount);
+            const size_t high = std::min(pair + pairWidth, mCount);
+            const size_t from = std::max(begin, pair) - pair;
+            const size_t to   = std::min(end, high) - pair;
+
+            const T * a = mSource + pair;
+            const T * b = mSource + mid;
+            const size_t na = mid - pair;
+            const size_t nb = high - mid;
+            const size_t i0 = CoRank(from, a, na, b, nb);
+            const size_t i1 = CoRank(to,   a, na, b, nb);
+            std::merge(a + i0, a + i1, b + (from - i0), b + (to - i1), mTarget + pair + from, mLess);
+        }
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Launches the merge pass for mWidth, its continuation the next one.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static void Pass(SortState * state)
+    {
+        state->mManager->ParallelFor(0, state->mCount, state->mGrainSize, [state] (size_t begin, size_t end)
+        {
+            state->Merge(begin, end);
+        }, state->mPriority).Then([state] ()
+        {
+            std::swap(state->mSource, state->mTarget);
+            state->mWidth *= 2;
+            if(state->mWidth < state->mCount)
+            {
+                Pass(state);
+                return;
+            }
+            JobHandleBlocked done = state->mDone;
+            SortState * temp = state;
+            XR_DELETE(temp);
+            done.ReleaseBarrier();
+        }, state->mPriority);
+    }
+
+    IManager       * mManager;
+    T              * mData;
+    T              * mScratch;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The current pass merges runs of mWidth from mSource into mTarget.
+    // ------------------------------------------------------------------------------------  MEMBER
+    T              * mSource;
+    T              * mTarget;
+    size_t           mCount;
+    size_t           mGrainSize;
+    size_t           mWidth;
+    Priority         mPriority;
+    Less             mLess;
+    JobHandleBlocked mDone;
+private:
+    SortState & operator=(const SortState &);
+};
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T, class Op>
+inline
+JobHandle ParallelReduce(IManager * manager, const T * data, size_t count, const T & identity, const Op & op, T * result, size_t grainSize, Priority priority)
+{
+    static_assert( std::is_trivially_copyable<T>::value, "Parallel algorithms need trivially copyable elements." );
+    grainSize = grainSize == 0 ? 1 : grainSize;
+    if(count <= grainSize)
+    {
+        T value = identity;
+        for(size_t i = 0; i < count; ++i)
+        {
+            value = op(value, data[i]);
+        }
+        *result = value;
+        return IManager::GetCompletedHandle();
+    }
+
+    typedef detail::ChunkedState<T, Op> State;
+    State * state = XR_NEW("ParallelReduce") State(manager, data, count, grainSize, op, priority);
+    state->mOutput = result;
+    return manager->ParallelFor(0, state->mChunkCount, 1, [state] (size_t begin, size_t end)
+    {
+        for(size_t chunk = begin; chunk < end; ++chunk)
+        {
+            state->mPartials[chunk] = state->FoldChunk(chunk);
+        }
+    }, priority).Then([state] ()
+    {
+        T value = state->mPartials[0];
+        for(size_t chunk = 1; chunk < state->mChunkCount; ++chunk)
+        {
+            value = state->mOp(value, state->mPartials[chunk]);
+        }
+        *state->mOutput = value;
+        State * temp = state;
+        XR_DELETE(temp);
+    }, priority);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T, class Op>
+inline
+JobHandle ParallelInclusiveScan(IManager * manager, const T * input, T * output, size_t count, const Op & op, size_t grainSize, Priority priority)
+{
+    static_assert( std::is_trivially_copyable<T>::value, "Parallel algorithms need trivially copyable elements." );
+    grainSize = grainSize == 0 ? 1 : grainSize;
+    if(count <= grainSize)
+    {
+        if(count != 0)
+        {
+            T value = input[0];
+            output[0] = value;
+            for(size_t i = 1; i < count; ++i)
+            {
+                value = op(value, input[i]);
+                output[i] = value;
+            }
+        }
+        return IManager::GetCompletedHandle();
+    }
+
+    typedef detail::ChunkedState<T, Op> State;
+    State * state = XR_NEW("ParallelInclusiveScan") State(manager, input, count, grainSize, op, priority);
+    state->mOutput = output;
+    state->mDone = manager->InsertBlocked((Core::Runnable)nullptr, nullptr, priority);
+    const JobHandle done = state->mDone;
+
+    manager->ParallelFor(0, state->mChunkCount, 1, [state] (size_t begin, size_t end)
+    {
+        for(size_t chunk = begin; chunk < end; ++chunk)
+        {
+            state->mPartials[chunk] = state->FoldChunk(chunk);
+        }
+    }, priority).Then([state] ()
+    {
+        // Now the fold of everything before the chunk (chunk 0 has none).
+        T carry = state->mPartials[0];
+        for(size_t chunk = 1; chunk < state->mChunkCount; ++chunk)
+        {
+            const T total = state->mPartials[chunk];
+            state->mPartials[chunk] = carry;
+            carry = state->mOp(carry, total);
+        }
+
+        state->mManager->ParallelFor(0, state->mChunkCount, 1, [state] (size_t begin, size_t end)
+        {
+            for(size_t chunk = begin; chunk < end; ++chunk)
+            {
+                const size_t first = chunk * state->mGrainSize;
+                const size_t last  = chunk == state->mChunkCount - 1 ? state->mCount : first + state->mGrainSize;
+                T value = chunk == 0 ? state->mInput[first] : state->mOp(state->mPartials[chunk], state->mInput[first]);
+                state->mOutput[first] = value;
+                for(size_t i = first + 1; i < last; ++i)
+                {
+                    value = state->mOp(value, state->mInput[i]);
+                    state->mOutput[i] = value;
+                }
+            }
+        }, state->mPriority).Then([state] ()
+        {
+            JobHandleBlocked temp = state->mDone;
+            State * s = state;
+            XR_DELETE(s);
+            temp.ReleaseBarrier();
+        }, state->mPriority);
+    }, priority);
+    return done;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T, class Less>
+inline
+JobHandle ParallelSort(IManager * manager, T * data, size_t count, const Less & less, size_t grainSize, Priority priority)
+{
+    static_assert( std::is_trivially_copyable<T>::value, "Parallel algorithms need trivially copyable elements." );
+    grainSize = grainSize == 0 ? 1 : grainSize;
+    if(count <= grainSize)
+    {
+        std::sort(data, data + count, less);
+        return IManager::GetCompletedHandle();
+    }
+
+    typedef detail::SortState<T, Less> State;
+    State * state = XR_NEW("ParallelSort") State(manager, data, count, grainSize, less, priority);
+    state->mDone = manager->InsertBlocked((Core::Runnable)nullptr, nullptr, priority);
+    const JobHandle done = state->mDone;
+
+    // Runs of one chunk, sorted where the first pass reads them.
+    manager->ParallelFor(0, count, grainSize, [state] (size_t begin, size_t end)
+    {
+        T * run = state->mSource;
+        if(run != state->mData)
+        {
+            std::copy(state->mData + begin, state->mData + end, run + begin);
+        }
+        std::sort(run + begin, run + end, state->mLess);
+    }, priority).Then([state] ()
+    {
+        State::Pass(state);
+    }, priority);
+    return done;
+}
+
+}}//namespace xr::Scheduling
+
+#endif //#ifndef XR_SERVICES_PARALLEL_ALGORITHMS_H
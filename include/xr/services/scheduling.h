@@ -15,12 +15,162 @@ short in duration (a few mS). Since they do not have a fixed thread context they
 are much faster to create then a thread, but if a job takes 100's or 1000's of
 mS, then a thread may be better suited.
 
+\par Priorities
+Every insert takes an optional Priority. Each level has its own ready lane
+(shared list and per worker deques). Workers take from the highest lane
+that has work, except that every InitializeOptions::mStarvationInterval
+picks they look bottom up so background work keeps moving.
+IManager::GetReadyCount reports the depth of each lane.
+
+\par Job Groups
+Tenants sharing one scheduler can be kept from starving each other with
+groups. IManager::CreateGroup returns a named JobGroup with a weight and
+an optional cap on how many of its jobs run at once. Jobs inserted while a
+JobGroupScope is open on the thread belong to its group, as do the jobs
+those jobs insert (like CancellationScope). A group's ready jobs wait in
+its own lanes, which every worker serves by deficit round robin (each
+lane on its own, priorities still come first): in turn
+each group may run jobs until it has used weight times
+IManager::kGroupQuantumMicroSeconds of that worker's time, and a job that
+overruns is paid back on the group's next turns. Within a lane, groups
+come before the shared ready list and stealing (ungrouped jobs a worker
+forked itself come first). When no group has a turn left but one has
+work, it runs anyway, idle workers are never held back. GetGroupStats
+reports each group's queue depth, running jobs and run time.
+
+\par Placement
+By default workers float. InitializeOptions can pin them to processors
+(an explicit list, or one per logical processor, optionally skipping SMT
+siblings). With mNumaAware workers are placed node by node and an idle
+worker tries the workers on its own node before crossing to another one.
+
+\par Data Parallel Loops
+IManager::ParallelFor splits an index range into grain sized chunks which a
+fixed number of jobs (at most one per worker) claim until the range is used
+up. Its lambda takes the chunk as (begin, end) and is copied to the heap
+for the duration.
+
+\par Continuations
+JobHandle::Then queues a lambda to run once a job is complete and
+IManager::WhenAll gives one handle for a set of jobs, so pipelines can be
+written as h.Then(...).Then(...). Attaching a successor to a job is lock
+free (as is InsertAfter), no scheduler mutex is taken anywhere along a chain
+of dependent jobs.
+
+\par Cancellation
+JobHandle::Cancel marks a job that has not completed yet. When a worker
+gets to it the runnable is skipped, its payload destroyed and the instance
+freed at once, then successors are notified as if it had run or, with
+kCancelSuccessors, cancelled the same way (transitively). A job already
+running is not interrupted. To cancel a group of jobs, insert them inside
+a CancellationScope: every job inserted on that thread while the scope is
+open, and every job those jobs insert, checks the scope's
+CancellationToken right before it would run.
+
+\par Timers
+IManager::InsertDelayed queues a job once a delay has passed and
+InsertPeriodic runs one every period until CancelPeriodic. Both live in a
+hierarchical timer wheel (4 levels of 256 slots, InitializeOptions::
+mTimerTickMicroSeconds per slot at the bottom) with constant time insert
+and cancel. There is no timer thread: workers check the wheel between
+jobs, and one parked worker sleeps only until the next deadline. A job
+never starts early. It may start up to a tick late, or later still if
+every worker is busy in a long job. A delayed job holds a JobInstance
+while it waits. Cancelling it through its handle removes its timer and
+completes it straight away, without running it.
+
+\par Blocking Jobs
+Work that blocks in the system (file reads, sockets, waiting on another
+process) should not occupy a worker, nothing would take its place. Insert
+it with IManager::InsertBlocking instead: it runs on a separate pool of
+threads which grows while every one of them is busy (up to
+InitializeOptions::mMaxBlockingThreads) and shrinks back to
+mBlockingThreads once they have been idle for mBlockingIdleMicroSeconds.
+The workers stay one per core. A blocking job is a job like any other, it
+can wait on antecedents and be one, be cancelled and waited on. Blocking
+jobs run in insert order and have no priority. Jobs they enable are handed
+back to the workers.
+
+\par Fiber Jobs
+A job which waits on other jobs half way through its work can be inserted
+with IManager::InsertFiber. It runs on one of a pool of small stacks
+(InitializeOptions::mFiberCount of mFiberStackSize bytes) instead of the
+worker's own, and a JobHandle::WaitOn inside it switches the stack out
+rather than holding the worker: the worker goes on with other jobs, and the
+fiber is resumed, by whichever worker gets to it, as a successor of the job
+it waited on. Only WaitOn (on this scheduler's jobs) switches, locks and
+other blocking calls still hold the worker. A fiber job may therefore move
+between threads while it runs, do not keep thread local state across a
+wait. When every fiber is in use (or mFiberCount is 0) a fiber job runs on
+the worker's stack and waits like any other job.
+
+\par Scratch Memory
+GetJobScratch returns a linear allocator for memory a job only needs
+while it runs. Each worker owns one (each fiber too), allocating is a
+pointer bump and everything is given back when the job returns, so hot
+jobs need not touch the general allocator. Nested scopes can roll back
+sooner with Core::LinearAllocatorScope. The arena starts at
+InitializeOptions::mJobScratchSize bytes and overflows into the general
+allocator. Memory from it must not be handed to other jobs, nor kept
+across a coroutine's co_await (which resumes as another job).
+
+\par Saturation
+By default an insert which finds no free JobInstance, or a full ready list,
+waits for one, which can deadlock if every worker is waiting too. With
+InitializeOptions::mFreeListGrowSize the pool grows by that many instances
+instead (up to mFreeListMaxSize). TryInsertReady and TryInsertAfter never
+wait, they return an invalid handle. InitializeOptions::mBackpressure is
+called whenever an insert finds either resource exhausted, so producers
+can shed or delay load.
+
+\par Idle Workers
+A worker that runs out of work spins (with a CPU pause) looking for more,
+then yields a few times, then parks. Waking a parked worker costs a kernel
+round trip, so short gaps between bursts of small jobs are better covered
+by spinning. Each worker tracks the recent gaps between its jobs and only
+spins as long as they suggest work will show up, up to
+InitializeOptions::mSpinMicroSeconds. New work wakes one parked worker per
+job, and none while a spinning worker can take it.
+
+\par Elastic Workers
+By default the scheduler keeps InitializeOptions::mNumThreads workers.
+With mMaxThreads above it (or mMinThreads below it) the pool follows the
+load. When work is queued with every worker busy, and has been queueing
+that way for mGrowLatencyMicroSeconds without any worker running out, one
+more worker is added (up to mMaxThreads). This covers workers held up by
+long or blocking jobs. The newest worker retires once it has been parked for
+mRetireIdleMicroSeconds, down to mMinThreads. A retired worker keeps its
+thread, asleep and out of the wake set: stray jobs no longer wake it, and
+reviving it is a signal rather than a thread start. Threads are only
+created the first time the pool grows that far. Every resize is counted
+in GetStats and reported to mResize.
+
+\par Statistics
+IManager::GetStats takes a snapshot of per worker counters (jobs run, time
+busy / idle / blocked, steals, waits) and of the high water marks used to
+size InitializeOptions::mReadyListSize and mFreeListSize. Workers update
+their own counters without atomics, a snapshot is taken while they run so
+the values are only loosely consistent with each other.
+
+\par Tracing
+With InitializeOptions::mTraceEventCount set, each worker keeps a ring of
+its last jobs (XID, runnable, start / end time and the XID of the job whose
+completion made it ready). Recording is started and stopped with
+SetTracing, WriteTrace exports the rings as Chrome trace_event JSON (also
+read by Perfetto): one lane per worker, with a flow arrow from each job to
+the successors it enabled, which makes the critical path of a DAG visible.
+While not recording the cost is one branch per job run.
+
 \par Interaction
 There are three ways to submit work to the scheduler.
 \li Via Static functions of Type "Runnable" with an "Arguments" parameter
-\li Via lambda function which captures no more than "Arguments" size of data from caller
-\li Via a functor object which defines a operator() function and whose size is no more 
-than the size of an "Arguments" object
+\li Via lambda function, captures of any size or type
+\li Via a functor object which defines a operator() const function
+
+Lambdas and functors are moved into the job and destroyed right after they
+run. Small ones (IManager::kInlinePayloadSize) are stored inside the job
+instance, larger ones in a per worker payload arena, so neither costs a
+general allocator call.
 
 Note that in all cases one should take great care to ensure the data passed does not 
 go out of scope or get freed before the completion of the job. The job system will 
@@ -54,8 +204,13 @@ user to ensure they are not deleted.
 #ifndef XR_CORE_RUNNABLE_H
 #include "xr/core/runnable.h"
 #endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
 
 #include <type_traits>
+#include <new>
+#include <utility>
 
 #if defined(_MSC_VER)
 #pragma warning(push)
@@ -69,17 +224,41 @@ user to ensure they are not deleted.
 // ######################################################################################### - FILE
 /* Forward Declarations */
 // ######################################################################################### - FILE
+namespace xr { namespace Core {
+class LinearAllocator;
+}}
 namespace xr { namespace Scheduling {
 class IManager;
 class JobInstance;
 class JobHandle;
 class JobThread;
+namespace detail { struct PayloadType; }
 }}
 // ######################################################################################### - FILE
 /* Declarations */
 // ######################################################################################### - FILE
 namespace xr { namespace Scheduling {
 
+// ***************************************************************************************** - TYPE
+/*! Ready lane a job is queued in. Lower values run first. */
+// ***************************************************************************************** - TYPE
+enum Priority
+{
+    kPriorityHigh = 0,      ///< Latency critical
+    kPriorityNormal,        ///< Default
+    kPriorityBackground,    ///< Bulk work, runs when nothing else is ready (see mStarvationInterval)
+    kPriorityCount
+};
+
+// ***************************************************************************************** - TYPE
+/*! What a cancelled job does to its successors. */
+// ***************************************************************************************** - TYPE
+enum CancelPolicy
+{
+    kCancelReleaseSuccessors = 0,   ///< Successors are notified as if the job had run
+    kCancelSuccessors               ///< Successors are cancelled too (transitively)
+};
+
 // ***************************************************************************************** - TYPE
 /*! Job based Completion specialization.
     */
@@ -93,6 +272,10 @@ public:
     bool           IsDone()  const;
     // ------------------------------------------------------------------------------------  MEMBER
     /// This returns only once the job is completed.
+    /// Called from a worker of the job's scheduler it runs other ready
+    /// jobs while waiting (newest local work first) instead of blocking the
+    /// worker, so jobs may safely wait on jobs they spawned. In a fiber job
+    /// (IManager::InsertFiber) it switches the fiber out instead.
     // ------------------------------------------------------------------------------------  MEMBER
     void           WaitOn()  const;
     // ------------------------------------------------------------------------------------  MEMBER
@@ -104,10 +287,28 @@ public:
     // ------------------------------------------------------------------------------------  MEMBER
     inline void    Invalidate();
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Asks for the job to be skipped. Returns false if it is already
+    /// complete. A job that has started runs to completion regardless,
+    /// see \ref scheduling "Cancellation".
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool           Cancel(CancelPolicy policy = kCancelReleaseSuccessors) const;
+    // ------------------------------------------------------------------------------------  MEMBER
     /// Adds an Runnable event to the conclusion of th job. (may run
     /// immediately).
     // ------------------------------------------------------------------------------------  MEMBER
     inline void    AddCompletionRunnable(::xr::Core::Runnable runnable);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runs \a lambda once this job is complete, as
+    /// IManager::InsertAfter(lambda, this, 1) would. On
+    /// IManager::GetCompletedHandle() it runs inline as there is no
+    /// scheduler to queue it on.
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline JobHandle Then(T lambda, Priority priority = kPriorityNormal) const;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Type erased form of Then.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle      ThenPayload(const detail::PayloadType * type, void * object, Priority priority) const;
 
     // ------------------------------------------------------------------------------------  MEMBER
     /// internally used sentinel
@@ -173,6 +374,158 @@ private:
 
 };
 
+// ***************************************************************************************** - TYPE
+/*! Identifies a periodic timer, see IManager::InsertPeriodic. */
+// ***************************************************************************************** - TYPE
+class PeriodicHandle
+{
+public:
+    PeriodicHandle() : mTimer(nullptr), mID(0) {}
+    PeriodicHandle(void * timer, uint64_t id) : mTimer(timer), mID(id) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline bool IsValid() const { return mTimer != nullptr; }
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Internal timer, and its ID (timers are reused).
+    // ------------------------------------------------------------------------------------  MEMBER
+    void     * mTimer;
+    uint64_t   mID;
+};
+
+// ***************************************************************************************** - TYPE
+/*! Identifies a job group, see IManager::CreateGroup. Valid until the
+    scheduler is shut down. */
+// ***************************************************************************************** - TYPE
+class JobGroup
+{
+public:
+    JobGroup() : mGroup(nullptr) {}
+    explicit JobGroup(void * group) : mGroup(group) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline bool IsValid() const { return mGroup != nullptr; }
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Internal group.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void     * mGroup;
+};
+
+// ***************************************************************************************** - TYPE
+/*! Cancels every job inserted under it (see CancellationScope) at once.
+    Must outlive those jobs. Cancelling is sticky until Reset. */
+// ***************************************************************************************** - TYPE
+class CancellationToken
+{
+public:
+    CancellationToken() : mState(0) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void         Cancel(CancelPolicy policy = kCancelReleaseSuccessors) { mState = uintptr_t(policy) + 1; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline bool         IsCancelled() const { return mState != 0; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Only meaningful once cancelled.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline CancelPolicy GetPolicy() const { return CancelPolicy(mState - 1); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Jobs not yet checked run normally after this.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void         Reset() { mState = 0; }
+private:
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// 0 or CancelPolicy + 1.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t mState;
+};
+
+// ***************************************************************************************** - TYPE
+/*! Jobs inserted by this thread while the scope exists belong to \a token
+    (nullptr for none), as do jobs those jobs insert. Scopes nest. */
+// ***************************************************************************************** - TYPE
+class CancellationScope
+{
+public:
+    explicit CancellationScope(CancellationToken * token);
+    ~CancellationScope();
+private:
+    CancellationScope(const CancellationScope &);
+    CancellationScope & operator=(const CancellationScope &);
+    CancellationToken * mPrevious;
+};
+
+// ***************************************************************************************** - TYPE
+/*! Jobs inserted by this thread while the scope exists belong to \a group
+    (an invalid one for none), as do jobs those jobs insert. Scopes nest.
+    A group only applies to jobs of the scheduler that created it. */
+// ***************************************************************************************** - TYPE
+class JobGroupScope
+{
+public:
+    explicit JobGroupScope(JobGroup group);
+    ~JobGroupScope();
+private:
+    JobGroupScope(const JobGroupScope &);
+    JobGroupScope & operator=(const JobGroupScope &);
+    void * mPrevious;
+};
+
+// ######################################################################################### - FILE
+// internal
+// ######################################################################################### - FILE
+namespace detail {
+// ***************************************************************************************** - TYPE
+/*! Type erased lambda / functor stored in a job (see PayloadTypeOf). */
+// ***************************************************************************************** - TYPE
+struct PayloadType
+{
+    size_t          mSize;
+    Core::Runnable  mRun;                           ///< Object is at the Arguments address (stored inline)
+    Core::Runnable  mRunIndirect;                   ///< Arguments::a0 points at the object (stored in the arena)
+    void          (*mMove)(void * dst, void * src); ///< Move construct into dst
+    void          (*mDestroy)(void * object);       ///< nullptr when trivially destructible
+};
+// ***************************************************************************************** - TYPE
+// ***************************************************************************************** - TYPE
+template <class T>
+struct PayloadTypeOf
+{
+    static void Run(const Core::Arguments * a)          { (*(const T *)(const void *)a)(); }
+    static void RunIndirect(const Core::Arguments * a)  { (*(const T *)a->a0)(); }
+    static void Move(void * dst, void * src)            { new (dst) T(std::move(*(T *)src)); }
+    static void Destroy(void * object)                  { ((T *)object)->~T(); }
+    static const PayloadType * Get()
+    {
+        static const PayloadType sType = {
+            sizeof(T), &Run, &RunIndirect, &Move,
+            std::is_trivially_destructible<T>::value ? nullptr : &Destroy };
+        return &sType;
+    }
+};
+// ***************************************************************************************** - TYPE
+/*! Type erased loop body for ParallelFor. Deleted by the scheduler once
+    the last chunk has run. */
+// ***************************************************************************************** - TYPE
+class ParallelForBody{
+public:
+    virtual ~ParallelForBody() {}
+    virtual void Run(size_t begin, size_t end) const = 0;
+};
+// ***************************************************************************************** - TYPE
+// ***************************************************************************************** - TYPE
+template <class T>
+class ParallelForLambda : public ParallelForBody{
+public:
+    ParallelForLambda(const T & lambda) : mLambda(lambda) {}
+    void Run(size_t begin, size_t end) const XR_OVERRIDE { mLambda(begin, end); }
+private:
+    ParallelForLambda & operator=(const ParallelForLambda &);
+    T mLambda;
+};
+}
+
 // ***************************************************************************************** - TYPE
 /*! \copydoc scheduling
     */
@@ -187,20 +540,21 @@ public:
     // ------------------------------------------------------------------------------------  MEMBER
     virtual JobHandle InsertReady(
         Core::Runnable r,
-        const Core::Arguments *args) = 0;
+        const Core::Arguments *args,
+        Priority priority = kPriorityNormal) = 0;
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*! Create a ready job for this runnable. */
     // ------------------------------------------------------------------------------------  MEMBER
     template <class T>
     inline 
-    JobHandle InsertReady(T lambda);
+    JobHandle InsertReady(T lambda, Priority priority = kPriorityNormal);
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*! Create a ready job for this runnable. */
     // ------------------------------------------------------------------------------------  MEMBER
     inline 
-    JobHandle InsertReady(xr::Core::Runnable r);
+    JobHandle InsertReady(xr::Core::Runnable r, Priority priority = kPriorityNormal);
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*!  Create Ready jobs for the array of Runnable Objects. \a r0 is a pointer to
@@ -213,27 +567,29 @@ public:
         size_t runnableCount,
         Core::Runnable* runnableArray,
         size_t argumentsCount = 0,                  ///< Can be 0 (no args), 1 (same args for every runnable), or runnableCount (each has it's own)
-        const Core::Arguments * argsArray = nullptr) = 0;
+        const Core::Arguments * argsArray = nullptr,
+        Priority priority = kPriorityNormal) = 0;
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*!  Insert the runnable, but make sure it does not run until enabled. */
     // ------------------------------------------------------------------------------------  MEMBER
     virtual JobHandleBlocked InsertBlocked(
         Core::Runnable r,
-        const Core::Arguments *args) = 0;
+        const Core::Arguments *args,
+        Priority priority = kPriorityNormal) = 0;
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*!  Insert the runnable, but make sure it does not run until enabled. */
     // ------------------------------------------------------------------------------------  MEMBER
     template <class T>
     inline 
-    JobHandleBlocked InsertBlocked(T lambda);
+    JobHandleBlocked InsertBlocked(T lambda, Priority priority = kPriorityNormal);
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*!  Insert the runnable, but make sure it does not run until enabled. */
     // ------------------------------------------------------------------------------------  MEMBER
     inline 
-    JobHandleBlocked InsertBlocked(xr::Core::Runnable r);
+    JobHandleBlocked InsertBlocked(xr::Core::Runnable r, Priority priority = kPriorityNormal);
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*!  Create Ready jobs for the array of Runnable Objects. \a r0 is a pointer to
@@ -246,7 +602,8 @@ public:
         size_t runnableCount,
         Core::Runnable* runnableArray,
         size_t argumentsCount = 0,                  ///< Can be 0 (no args), 1 (same args for every runnable), or runnableCount (each has it's own)
-        const Core::Arguments * argsArray = nullptr) = 0;
+        const Core::Arguments * argsArray = nullptr,
+        Priority priority = kPriorityNormal) = 0;
 
     // ------------------------------------------------------------------------------------  MEMBER
     /*!  Insert the runnable, but make sure it does not run until after
@@ -259,7 +616,8 @@ public:
         Core::Runnable r,
         const Core::Arguments *args,
         JobHandle * antecedentArray,
-        size_t arrayCount) = 0;
+        size_t arrayCount,
+        Priority priority = kPriorityNormal) = 0;
     // ------------------------------------------------------------------------------------  MEMBER
     /*!  Insert the runnable, but make sure it does not run until after
             the passed JobHandle objects are complete. \a handle0 is an array
@@ -272,15 +630,437 @@ public:
     JobHandle InsertAfter(
         T lambda,
         JobHandle * antecedentArray,
-        size_t arrayCount);
+        size_t arrayCount,
+        Priority priority = kPriorityNormal);
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  InsertReady which never waits. Returns an invalid handle (see
+            JobHandle::IsValid) if there is no free JobInstance, after
+            growing the pool if allowed, or no room in the ready list.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle TryInsertReady(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority = kPriorityNormal) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Lambda form of TryInsertReady. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline
+    JobHandle TryInsertReady(T lambda, Priority priority = kPriorityNormal);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  InsertAfter which never waits. Returns an invalid handle if there
+            is no free JobInstance, or if every antecedent is already
+            complete (or there are none) and there is no room in the ready
+            list. Otherwise the job is queued like any other once the last
+            antecedent completes, by the thread completing it.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle TryInsertAfter(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority = kPriorityNormal) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Lambda form of TryInsertAfter. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline
+    JobHandle TryInsertAfter(
+        T lambda,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority = kPriorityNormal);
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Insert a job which may block (IO, sleeps, waits outside the
+            scheduler). It runs on the blocking pool instead of a worker
+            once the \a arrayCount antecedents in \a antecedentArray (if
+            any) are complete.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle InsertBlocking(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        JobHandle * antecedentArray = nullptr,
+        size_t arrayCount = 0) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Lambda form of InsertBlocking. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline
+    JobHandle InsertBlocking(T lambda, JobHandle * antecedentArray = nullptr, size_t arrayCount = 0);
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Insert a job which runs on a pooled fiber stack, so it can WaitOn
+            other jobs without holding its worker (see \ref scheduling
+            "Fiber Jobs"). Ready once the \a arrayCount antecedents in
+            \a antecedentArray (if any) are complete.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle InsertFiber(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        JobHandle * antecedentArray = nullptr,
+        size_t arrayCount = 0,
+        Priority priority = kPriorityNormal) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Lambda form of InsertFiber. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline
+    JobHandle InsertFiber(T lambda, JobHandle * antecedentArray = nullptr, size_t arrayCount = 0, Priority priority = kPriorityNormal);
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Insert a job which becomes ready \a delayMicroSeconds from now. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle InsertDelayed(
+        uint64_t delayMicroSeconds,
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority = kPriorityNormal) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Lambda form of InsertDelayed. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline
+    JobHandle InsertDelayed(uint64_t delayMicroSeconds, T lambda, Priority priority = kPriorityNormal);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Runs \a r as a job every \a periodMicroSeconds, the first time one
+            period from now. Deadlines are multiples of the period from
+            the start, a run which is still going (or late) when the next
+            deadline passes makes that one be skipped rather than queued.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual PeriodicHandle InsertPeriodic(
+        uint64_t periodMicroSeconds,
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority = kPriorityNormal) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Lambda form of InsertPeriodic. The lambda is kept (and run in
+            place) until the timer is cancelled.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class T>
+    inline
+    PeriodicHandle InsertPeriodic(uint64_t periodMicroSeconds, T lambda, Priority priority = kPriorityNormal);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Stops a periodic timer. A run already started finishes, none start
+            after this returns. Returns false if it was already cancelled.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual bool CancelPeriodic(PeriodicHandle handle) = 0;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Runs \a lambda over [\a begin, \a end) in chunks of at most
+            \a grainSize indices. \a lambda is called as
+            lambda(size_t chunkBegin, size_t chunkEnd) from any number of
+            workers at once. Uses one JobInstance per worker (plus one for
+            the returned handle) however large the range is. A range of
+            \a grainSize or less runs inline before returning.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    template<typename T>
+    inline
+    JobHandle ParallelFor(
+        size_t begin,
+        size_t end,
+        size_t grainSize,
+        const T & lambda,
+        Priority priority = kPriorityNormal);
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Type erased ParallelFor, takes ownership of \a body. An empty range,
+            or one of \a grainSize or less, is handled inline as above. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle ParallelFor(
+        size_t begin,
+        size_t end,
+        size_t grainSize,
+        detail::ParallelForBody * body,
+        Priority priority = kPriorityNormal) = 0;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Type erased form of the lambda inserts. Moves \a object into a new
+            job which waits for \a barrierCount ReleaseBarrier calls and the
+            \a arrayCount antecedents. The object is destroyed right after
+            it runs.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle InsertPayload(
+        const detail::PayloadType * type,
+        void * object,
+        size_t barrierCount,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Type erased form of the lambda TryInserts. \a object is moved from
+            whether or not it succeeds.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle TryInsertPayload(
+        const detail::PayloadType * type,
+        void * object,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Type erased form of the lambda InsertBlocking. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle InsertBlockingPayload(
+        const detail::PayloadType * type,
+        void * object,
+        JobHandle * antecedentArray,
+        size_t arrayCount) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Type erased form of the lambda InsertFiber. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle InsertFiberPayload(
+        const detail::PayloadType * type,
+        void * object,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Type erased forms of the lambda timers. */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle InsertDelayedPayload(
+        uint64_t delayMicroSeconds,
+        const detail::PayloadType * type,
+        void * object,
+        Priority priority) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual PeriodicHandle InsertPeriodicPayload(
+        uint64_t periodMicroSeconds,
+        const detail::PayloadType * type,
+        void * object,
+        Priority priority) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Returns a handle which completes once all of the \a arrayCount
+            jobs in \a antecedentArray have. Costs one JobInstance with no
+            work of its own.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobHandle WhenAll(JobHandle * antecedentArray, size_t arrayCount) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Largest lambda / functor stored inside the job instance itself,
+            larger ones go to the payload arena.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+#if XR_PLATFORM_PTR_SIZE == 4
+    static const size_t kInlinePayloadSize = 32;
+#else
+    static const size_t kInlinePayloadSize = 80;
+#endif
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Number of ready (not yet started) jobs in the \a priority lane,
+            shared list plus every worker's deque. Only a snapshot.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual size_t GetReadyCount(Priority priority) const = 0;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Most groups one scheduler can have.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t kMaxGroups = 16;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Worker time a group of weight 1 gets per turn, see "Job Groups".
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t kGroupQuantumMicroSeconds = 100;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Adds a job group (see "Job Groups" above). \a weight is its share
+            relative to the other groups (at least 1), \a maxConcurrency
+            the most of its jobs running at once (0 = no limit). \a name is
+            copied. Returns an invalid group once there are kMaxGroups.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual JobGroup CreateGroup(const char * name, size_t weight = 1, size_t maxConcurrency = 0) = 0;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Returns a handle which is already complete. Useful as a result for
+            work done inline, it can be waited on or used as an antecedent.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    static JobHandle GetCompletedHandle();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  The scheduler whose worker is calling, nullptr on any other thread
+            (including the blocking pool's).
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    static IManager * GetCurrent();
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Counters of one worker since the scheduler started, see GetStats.
+    // ------------------------------------------------------------------------------------  MEMBER
+    struct WorkerStats{
+        uint64_t mJobsRun;              ///< Including jobs run while helping in WaitOn
+        uint64_t mBusyMicroSeconds;     ///< From finding work until there is none left (includes mBlockedMicroSeconds)
+        uint64_t mIdleMicroSeconds;     ///< Parked, nothing to do
+        uint64_t mBlockedMicroSeconds;  ///< In WaitOn with nothing else to run
+        uint64_t mSteals;               ///< Jobs taken from other workers' deques
+        uint64_t mParks;                ///< Times the worker went to sleep
+        uint64_t mWaitCalls;            ///< WaitOn calls on this worker that had to wait
+        uint64_t mDequeHighWater;       ///< Most jobs in any one of its deques at once (compare with mReadyListSize)
+        uint64_t mSpinHits;             ///< Times spinning or yielding found work before the worker parked
+        uint64_t mJobsCancelled;        ///< Jobs skipped because they were cancelled (also counted in mJobsRun)
+        uint64_t mFiberWaits;           ///< WaitOn calls in fiber jobs which switched the fiber out
+    };
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Scheduler wide counters, see GetStats.
+    // ------------------------------------------------------------------------------------  MEMBER
+    struct Stats{
+        size_t   mWorkerCount;
+        uint64_t mReadyListHighWater[kPriorityCount];   ///< Most jobs in each lane's shared ready list at once (compare with mReadyListSize)
+        uint64_t mFreeListLowWater;     ///< Fewest instances left in the shared free list (worker caches not counted, compare with mFreeListSize)
+        uint64_t mFreeListExhausted;    ///< Inserts that found every instance in use (then waited, grew the pool or failed)
+        uint64_t mSuccessorChunks;      ///< Successor chunks allocated (jobs with many successors)
+        uint64_t mWaitCalls;            ///< WaitOn calls from non worker threads that had to wait
+        uint64_t mFreeListSize;         ///< Instances in the pool, including those added by mFreeListGrowSize
+        uint64_t mBlockingThreads;      ///< Threads in the blocking pool right now
+        uint64_t mBlockingThreadsHighWater; ///< Most threads the blocking pool has had at once
+        uint64_t mBlockingJobsRun;      ///< Jobs run by the blocking pool (not counted in WorkerStats)
+        uint64_t mFibersExhausted;      ///< Fiber jobs run on a worker's own stack because every fiber was in use
+        uint64_t mActiveWorkers;        ///< Workers not retired right now (mWorkerCount is every worker there can be)
+        uint64_t mActiveWorkersHighWater; ///< Most workers active at once
+        uint64_t mWorkersAdded;         ///< Times the pool grew, see "Elastic Workers"
+        uint64_t mWorkersRetired;       ///< Times the pool shrank
+    };
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Snapshot of the scheduler's counters, taken without stopping the
+            workers. Fills \a stats (if not nullptr) and the first
+            \a maxWorkers entries of \a workers. Returns the number of workers.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual size_t GetStats(Stats * stats, WorkerStats * workers, size_t maxWorkers) const = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Counters of one job group, see GetGroupStats.
+    // ------------------------------------------------------------------------------------  MEMBER
+    struct GroupStats{
+        const char * mName;             ///< Owned by the scheduler
+        size_t   mWeight;
+        size_t   mMaxConcurrency;       ///< 0 = no limit
+        uint64_t mQueued;               ///< Ready jobs waiting in the group's lanes right now
+        uint64_t mQueuedHighWater;      ///< Most jobs in any one of its lanes at once (compare with mReadyListSize)
+        uint64_t mRunning;              ///< Jobs of the group running right now
+        uint64_t mRunningHighWater;     ///< Most of its jobs running at once
+        uint64_t mJobsRun;              ///< Jobs run, blocking ones not counted
+        uint64_t mRunMicroSeconds;      ///< Worker time those jobs took (a job in WaitOn includes the jobs it helped with)
+    };
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Snapshot of \a group's counters, same consistency as GetStats.
+            Returns false if \a group is not one of ours.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual bool GetGroupStats(JobGroup group, GroupStats * stats) const = 0;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Starts or stops recording jobs into the trace rings. Has no effect
+    /// when InitializeOptions::mTraceEventCount is 0.
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual void SetTracing(bool enable) = 0;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Receives WriteTrace output, \a text is not null terminated.
+    // ------------------------------------------------------------------------------------  MEMBER
+    typedef void (*TraceWriter)(void * context, const char * text, size_t length);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /*!  Writes the recorded jobs as Chrome trace_event JSON through
+            \a writer. Stop recording first, jobs recorded meanwhile may be
+            torn. Returns the number of jobs written.
+    */
+    // ------------------------------------------------------------------------------------  MEMBER
+    virtual size_t WriteTrace(TraceWriter writer, void * context) const = 0;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// What an insert found exhausted, see InitializeOptions::mBackpressure.
+    // ------------------------------------------------------------------------------------  MEMBER
+    enum Backpressure
+    {
+        kBackpressureFreeList,      ///< No free JobInstance (before growing the pool, waiting, or failing)
+        kBackpressureReadyList      ///< A ready list is full (before waiting, or failing)
+    };
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Called on the inserting thread, which may be a worker. Must not
+    /// insert jobs itself.
+    // ------------------------------------------------------------------------------------  MEMBER
+    typedef void (*BackpressureCallback)(void * context, Backpressure what);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Called after the pool grew (\a grew) or shrank to \a activeWorkers,
+    /// on the thread which resized it (an inserting thread or the retiring
+    /// worker). Must not insert jobs itself.
+    // ------------------------------------------------------------------------------------  MEMBER
+    typedef void (*ResizeCallback)(void * context, size_t activeWorkers, bool grew);
 
     // ------------------------------------------------------------------------------------  MEMBER
     /// Wraps initialization options for Manager object
     // ------------------------------------------------------------------------------------  MEMBER
     struct InitializeOptions{
-        size_t mNumThreads;         ///< Number of threads the Scheduler should create (may be ignored depending on system)
-        size_t mReadyListSize;      ///< Maximum Number of outstanding jobs at any instant (if too low will cause blocking, and potentially deadlock)
-        size_t mFreeListSize;       ///< Number of job instances to create in total.
+        size_t mNumThreads;         ///< Number of threads the Scheduler should create (may be ignored depending on system), see mMinThreads / mMaxThreads
+        size_t mReadyListSize;      ///< Capacity of each lane's shared ready list (jobs from non worker threads) and of each worker's deques (if too low will cause blocking, and potentially deadlock, see TryInsertReady)
+        size_t mFreeListSize;       ///< Number of job instances to create up front.
+        size_t mFreeListGrowSize;   ///< When no instance is free, add this many instead of waiting. 0 = wait.
+        size_t mFreeListMaxSize;    ///< Limit on growth (total instances), 0 = none
+        BackpressureCallback mBackpressure;  ///< Optional, see Backpressure
+        void * mBackpressureContext;
+        size_t mStarvationInterval; ///< Every Nth pick a worker looks at the lanes lowest priority first. 0 = strict priority.
+        const size_t * mProcessors; ///< Optional logical processors to pin workers to (worker i gets mProcessors[i % mProcessorCount]). nullptr = choose from Core::Thread::GetProcessorInfo.
+        size_t mProcessorCount;     ///< Entries in mProcessors
+        bool   mPinThreads;         ///< Pin each worker to a logical processor (implied by mProcessors)
+        bool   mSkipSmtSiblings;    ///< When choosing processors use at most one per physical core (workers wrap if there are more workers than cores)
+        bool   mNumaAware;          ///< Place workers node by node and have them steal from their own node first
+        size_t mTraceEventCount;    ///< Jobs each worker's trace ring holds, 0 = no tracing (see SetTracing)
+        size_t mSpinMicroSeconds;   ///< Longest an idle worker spins before yielding, the budget adapts below this. 0 = no spinning.
+        size_t mYieldCount;         ///< Yields (each followed by a look for work) between spinning and parking
+        size_t mTimerTickMicroSeconds; ///< Resolution of InsertDelayed / InsertPeriodic
+        size_t mBlockingThreads;    ///< Threads the blocking pool keeps even when idle (see InsertBlocking). 0 = none until a blocking job is inserted
+        size_t mMaxBlockingThreads; ///< Most threads the blocking pool grows to, further blocking jobs queue
+        size_t mBlockingIdleMicroSeconds; ///< How long a blocking thread above mBlockingThreads waits for work before it exits
+        size_t mFiberCount;         ///< Fibers (stacks) created up front for InsertFiber jobs, 0 = fiber jobs run like any other
+        size_t mFiberStackSize;     ///< Bytes of stack per fiber, rounded up to whole pages
+        size_t mJobScratchSize;     ///< Bytes of GetJobScratch arena per worker (and per fiber) before it overflows into the general allocator
+        size_t mMinThreads;         ///< Workers the pool shrinks to when idle, at least 1. 0 = mNumThreads (see "Elastic Workers")
+        size_t mMaxThreads;         ///< Workers the pool grows to under load. 0 = mNumThreads
+        size_t mGrowLatencyMicroSeconds; ///< How long work may keep queueing with every worker busy before one is added
+        size_t mRetireIdleMicroSeconds;  ///< How long the newest worker stays parked before it retires
+        ResizeCallback mResize;     ///< Optional, see ResizeCallback
+        void * mResizeContext;
+
+        InitializeOptions() :
+            mNumThreads(4),
+            mReadyListSize(256),
+            mFreeListSize(1024),
+            mFreeListGrowSize(0),
+            mFreeListMaxSize(0),
+            mBackpressure(nullptr),
+            mBackpressureContext(nullptr),
+            mStarvationInterval(16),
+            mProcessors(nullptr),
+            mProcessorCount(0),
+            mPinThreads(false),
+            mSkipSmtSiblings(false),
+            mNumaAware(false),
+            mTraceEventCount(0),
+            mSpinMicroSeconds(50),
+            mYieldCount(4),
+            mTimerTickMicroSeconds(100),
+            mBlockingThreads(0),
+            mMaxBlockingThreads(16),
+            mBlockingIdleMicroSeconds(1000000),
+            mFiberCount(0),
+            mFiberStackSize(64 * 1024),
+            mJobScratchSize(64 * 1024),
+            mMinThreads(0),
+            mMaxThreads(0),
+            mGrowLatencyMicroSeconds(2000),
+            mRetireIdleMicroSeconds(1000000),
+            mResize(nullptr),
+            mResizeContext(nullptr)
+        {}
     };
     // ------------------------------------------------------------------------------------  MEMBER
     /*! Initializes the a scheduler instance with the passed \a options.
@@ -294,139 +1074,184 @@ public:
     static void Shutdown(IManager * sched);
 };
 
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  Scratch arena of the job running on the calling thread (see
+        "Scratch Memory" above), rolled back when the job returns. nullptr
+        when the caller is not a worker (blocking jobs included).
+*/
+// --------------------------------------------------------------------------------------  FUNCTION
+Core::LinearAllocator * GetJobScratch();
+
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 template <class T>
 inline 
-JobHandle IManager::InsertReady(T lambda)
+JobHandle IManager::InsertReady(T lambda, Priority priority)
 {
     typedef void (T::*ExpectedFunctionType)() const;
 
     // Compile time type validation
-    static_assert( sizeof(T) <= sizeof(xr::Core::Arguments), "Object size exceed the size of the \"Arguments\" Object. In the case of Lamba functions, this consists of captured variables" );
     static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
-    static_assert( std::is_trivially_destructible<T>::value, "Can only pass trivially destructed object types to job." );
-
-    // This is not supported by GCC at this time.
-    //static_assert( std::is_trivially_copyable<T>::value, "Types must be trivially copyable to pass to job.");
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
-    xr::Core::Arguments a;
+    return InsertPayload(detail::PayloadTypeOf<T>::Get(), &lambda, 0, nullptr, 0, priority);
+}
 
-    // This casts to the arguments.
-    uintptr_t * x = (uintptr_t *)&lambda;
 
-    if(sizeof(lambda) >0)
-        a.a0 = x[0];
-    if(sizeof(lambda) > sizeof(uintptr_t))
-        a.a1 = x[1];
-    if(sizeof(lambda) > (sizeof(uintptr_t)*2))
-        a.a2 = x[2];
-    if(sizeof(lambda) > (sizeof(uintptr_t)*3))
-        a.a3 = x[3];
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+inline 
+JobHandle IManager::InsertReady(xr::Core::Runnable r, Priority priority)
+{
+    return InsertReady( r, nullptr, priority);
+}
 
-    ExpectedFunctionType f = &T::operator();
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline 
+JobHandleBlocked IManager::InsertBlocked(T lambda, Priority priority)
+{
+    typedef void (T::*ExpectedFunctionType)() const;
 
-    //This casts to the function pointer
-    union {
-        ExpectedFunctionType e;
-        Core::Runnable       r;
-    } u;
-    u.e = f;
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
-    // This inserts the pair
-    return InsertReady( u.r, &a);
+    // Starts with one barrier, see JobHandleBlocked.
+    return JobHandleBlocked(InsertPayload(detail::PayloadTypeOf<T>::Get(), &lambda, 1, nullptr, 0, priority));
 }
-
-
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 inline 
-JobHandle IManager::InsertReady(xr::Core::Runnable r)
+JobHandleBlocked IManager::InsertBlocked(xr::Core::Runnable r, Priority priority)
 {
-    return InsertReady( r, nullptr);
+    return InsertBlocked( r, nullptr, priority);
 }
 
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 template <class T>
 inline 
-JobHandleBlocked IManager::InsertBlocked(T lambda)
+JobHandle IManager::InsertAfter(T lambda, JobHandle * antecedentArray,size_t arrayCount, Priority priority)
 {
     typedef void (T::*ExpectedFunctionType)() const;
-    static_assert( sizeof(T) <= sizeof(xr::Core::Arguments), "Captured variables exceed the size of the \"Arguments\" Object. Refactor and capture less data" );
-    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
-    static_assert( std::is_trivially_destructible<T>::value, "Can only pass trivially destructed object types to job." );
 
-    xr::Core::Arguments a;
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
-    // This casts to the arguments.
-    uintptr_t * x = (uintptr_t *)&lambda;
+    return InsertPayload(detail::PayloadTypeOf<T>::Get(), &lambda, 0, antecedentArray, arrayCount, priority);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline
+JobHandle IManager::InsertBlocking(T lambda, JobHandle * antecedentArray, size_t arrayCount)
+{
+    typedef void (T::*ExpectedFunctionType)() const;
 
-    if(sizeof(lambda) >0)
-        a.a0 = x[0];
-    if(sizeof(lambda) > sizeof(uintptr_t))
-        a.a1 = x[1];
-    if(sizeof(lambda) > (sizeof(uintptr_t)*2))
-        a.a2 = x[2];
-    if(sizeof(lambda) > (sizeof(uintptr_t)*3))
-        a.a3 = x[3];
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
-    ExpectedFunctionType f = &T::operator();
+    return InsertBlockingPayload(detail::PayloadTypeOf<T>::Get(), &lambda, antecedentArray, arrayCount);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline
+JobHandle IManager::InsertFiber(T lambda, JobHandle * antecedentArray, size_t arrayCount, Priority priority)
+{
+    typedef void (T::*ExpectedFunctionType)() const;
 
-    //This casts to the function pointer
-    union {
-        ExpectedFunctionType e;
-        Core::Runnable       r;
-    } u;
-    u.e = f;
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
-    // This inserts the pair
-    return InsertBlocked( u.r, &a);
+    return InsertFiberPayload(detail::PayloadTypeOf<T>::Get(), &lambda, antecedentArray, arrayCount, priority);
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-inline 
-JobHandleBlocked IManager::InsertBlocked(xr::Core::Runnable r)
+template <class T>
+inline
+JobHandle IManager::InsertDelayed(uint64_t delayMicroSeconds, T lambda, Priority priority)
 {
-    return InsertBlocked( r, nullptr);
+    typedef void (T::*ExpectedFunctionType)() const;
+
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
+
+    return InsertDelayedPayload(delayMicroSeconds, detail::PayloadTypeOf<T>::Get(), &lambda, priority);
 }
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline
+PeriodicHandle IManager::InsertPeriodic(uint64_t periodMicroSeconds, T lambda, Priority priority)
+{
+    typedef void (T::*ExpectedFunctionType)() const;
+
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
+    return InsertPeriodicPayload(periodMicroSeconds, detail::PayloadTypeOf<T>::Get(), &lambda, priority);
+}
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 template <class T>
-inline 
-JobHandle IManager::InsertAfter(T lambda, JobHandle * antecedentArray,size_t arrayCount)
+inline
+JobHandle IManager::TryInsertReady(T lambda, Priority priority)
 {
     typedef void (T::*ExpectedFunctionType)() const;
-    static_assert( sizeof(T) <= sizeof(xr::Core::Arguments), "Captured variables exceed the size of the \"Arguments\" Object. Refactor and capture less data" );
+
+    // Compile time type validation
     static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
-    static_assert( std::is_trivially_destructible<T>::value, "Can only pass trivially destructed object types to job." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
-    xr::Core::Arguments a;
+    return TryInsertPayload(detail::PayloadTypeOf<T>::Get(), &lambda, nullptr, 0, priority);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline
+JobHandle IManager::TryInsertAfter(T lambda, JobHandle * antecedentArray, size_t arrayCount, Priority priority)
+{
+    typedef void (T::*ExpectedFunctionType)() const;
 
-    // This casts to the arguments.
-    uintptr_t * x = (uintptr_t *)&lambda;
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
 
-    if(sizeof(lambda) >0)
-        a.a0 = x[0];
-    if(sizeof(lambda) > sizeof(uintptr_t))
-        a.a1 = x[1];
-    if(sizeof(lambda) > (sizeof(uintptr_t)*2))
-        a.a2 = x[2];
-    if(sizeof(lambda) > (sizeof(uintptr_t)*3))
-        a.a3 = x[3];
+    return TryInsertPayload(detail::PayloadTypeOf<T>::Get(), &lambda, antecedentArray, arrayCount, priority);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline
+JobHandle IManager::ParallelFor(size_t begin, size_t end, size_t grainSize, const T & lambda, Priority priority)
+{
+    typedef void (T::*ExpectedFunctionType)(size_t, size_t) const;
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "ParallelFor takes a lambda of the form (size_t begin, size_t end)." );
 
-    ExpectedFunctionType f = &T::operator();
+    if(end <= begin)
+    {
+        return GetCompletedHandle();
+    }
 
-    //This casts to the function pointer
-    union {
-        ExpectedFunctionType e;
-        Core::Runnable       r;
-    } u;
-    u.e = f;
+    // Too small to be worth a job.
+    if(end - begin <= grainSize)
+    {
+        lambda(begin, end);
+        return GetCompletedHandle();
+    }
 
-    // This inserts the pair
-    return InsertAfter( u.r, &a, antecedentArray, arrayCount);
+    // Through the base pointer, otherwise this template is the better match.
+    detail::ParallelForBody * body = XR_NEW("ParallelFor") detail::ParallelForLambda<T>(lambda);
+    return ParallelFor(begin, end, grainSize, body, priority);
 }
 
 // ***************************************************************************************** - TYPE
@@ -438,6 +1263,20 @@ bool           JobHandle::IsValid() const { return mXID != kJobInstanceHandleInv
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 void           JobHandle::Invalidate() { mXID = kJobInstanceHandleInvalid; }
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+inline
+JobHandle      JobHandle::Then(T lambda, Priority priority) const
+{
+    typedef void (T::*ExpectedFunctionType)() const;
+
+    // Compile time type validation
+    static_assert( std::is_convertible<ExpectedFunctionType,decltype(&T::operator())>::value, "Scheduler cannot take Lambdas with arguments, use captures instead." );
+    static_assert( std::alignment_of<T>::value <= 16, "Captured types can not require more than 16 byte alignment." );
+
+    return ThenPayload(detail::PayloadTypeOf<T>::Get(), &lambda, priority);
+}
 
 
 
@@ -0,0 +1,372 @@
+// ######################################################################################### - FILE
+/*!
+
+\page task Coroutine Tasks
+With C++20 coroutines, jobs can be written as straight line code instead
+of chains of Then / InsertAfter. A function returning Task<T> is a
+coroutine which starts running at once on the calling thread and moves to
+the scheduler's workers at its first suspension.
+
+\par Awaiting
+co_await on a JobHandle suspends the coroutine and resumes it, as a job,
+once the handle completes. The resume job is a successor of the awaited
+one, added exactly like InsertAfter adds one, so no worker sits in WaitOn
+meanwhile. co_await on a Task<T> does the same with the task's completion
+and gives the value the task co_returned. co_await Schedule(manager) moves
+the coroutine onto a worker, ScheduleBlocking(manager) onto the blocking
+pool (see IManager::InsertBlocking).
+
+\par Completion
+Every task owns one blocked job which is released when the coroutine
+finishes, Task::GetHandle returns it, so ordinary jobs can depend on a
+task. The value lives in the coroutine frame, which the Task object owns:
+destroying a Task which has not finished waits for it first.
+
+\par Scheduler
+The scheduler is taken from the coroutine's first parameter when that is
+an IManager * (or IManager &), otherwise it is IManager::GetCurrent(), the
+scheduler of the calling worker.
+
+Only available when the compiler supports coroutines (C++20),
+XR_SCHEDULING_TASK_ENABLED is defined to 1 then.
+
+\file
+\brief C++20 coroutines on top of the scheduler
+\copydoc task
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+// Guard
+// ######################################################################################### - FILE
+#ifndef XR_SERVICES_TASK_H
+#define XR_SERVICES_TASK_H
+
+#if defined( _MSC_VER )
+#pragma once
+#endif
+// ######################################################################################### - FILE
+/* Public Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#error "Must include xr/defines.h first!"
+#endif
+#ifndef XR_SERVICES_SCHEDULING_H
+#include "xr/services/scheduling.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#include <new>
+#include <utility>
+#define XR_SCHEDULING_TASK_ENABLED 1
+#endif
+#endif
+// ######################################################################################### - FILE
+/* Public Macros */
+// ######################################################################################### - FILE
+#if !defined(XR_SCHEDULING_TASK_ENABLED)
+#define XR_SCHEDULING_TASK_ENABLED 0
+#endif
+
+#if XR_SCHEDULING_TASK_ENABLED
+// ######################################################################################### - FILE
+/* Declarations */
+// ######################################################################################### - FILE
+namespace xr { namespace Scheduling {
+
+template <class T> class Task;
+
+// ***************************************************************************************** - TYPE
+/*! co_await on a JobHandle, resumes as a successor job of the handle. */
+// ***************************************************************************************** - TYPE
+class JobAwaiter
+{
+public:
+    JobAwaiter(const JobHandle & handle, Priority priority) : mHandle(handle), mPriority(priority) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// An invalid handle counts as complete.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool await_ready() const { return !mHandle.IsValid() || mHandle.IsDone(); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The resume job may run (on another worker) before this returns,
+    /// nothing here is touched after Then.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void await_suspend(std::coroutine_handle<> coroutine) const
+    {
+        mHandle.Then([coroutine] () { coroutine.resume(); }, mPriority);
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void await_resume() const {}
+private:
+    JobHandle   mHandle;
+    Priority    mPriority;
+};
+
+// ***************************************************************************************** - TYPE
+/*! co_await Schedule / ScheduleBlocking, resumes as a new job. */
+// ***************************************************************************************** - TYPE
+class ScheduleAwaiter
+{
+public:
+    ScheduleAwaiter(IManager * manager, Priority priority, bool blocking) : mManager(manager), mPriority(priority), mBlocking(blocking) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool await_ready() const { return false; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void await_suspend(std::coroutine_handle<> coroutine) const
+    {
+        if(mBlocking)
+        {
+            mManager->InsertBlocking([coroutine] () { coroutine.resume(); });
+        }
+        else
+        {
+            mManager->InsertReady([coroutine] () { coroutine.resume(); }, mPriority);
+        }
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void await_resume() const {}
+private:
+    IManager  * mManager;
+    Priority    mPriority;
+    bool        mBlocking;
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/// co_await handle
+// --------------------------------------------------------------------------------------  FUNCTION
+inline JobAwaiter operator co_await(const JobHandle & handle)
+{
+    return JobAwaiter(handle, kPriorityNormal);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// co_await Resume(handle, priority), when the rest of the coroutine
+/// should not run at normal priority.
+// --------------------------------------------------------------------------------------  FUNCTION
+inline JobAwaiter Resume(const JobHandle & handle, Priority priority)
+{
+    return JobAwaiter(handle, priority);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// co_await Schedule(manager) continues on one of \a manager's workers.
+// --------------------------------------------------------------------------------------  FUNCTION
+inline ScheduleAwaiter Schedule(IManager * manager, Priority priority = kPriorityNormal)
+{
+    return ScheduleAwaiter(manager, priority, false);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// co_await ScheduleBlocking(manager) continues on \a manager's blocking
+/// pool, co_await Schedule to come back.
+// --------------------------------------------------------------------------------------  FUNCTION
+inline ScheduleAwaiter ScheduleBlocking(IManager * manager)
+{
+    return ScheduleAwaiter(manager, kPriorityNormal, true);
+}
+
+namespace detail {
+// ***************************************************************************************** - TYPE
+/*! Everything a Task promise has whatever T is. */
+// ***************************************************************************************** - TYPE
+class TaskPromiseBase
+{
+public:
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Picks the scheduler, see \ref task "Scheduler".
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class... Args>
+    TaskPromiseBase(IManager * manager, Args &&...) : mDone(Block(manager)) {}
+    template <class... Args>
+    TaskPromiseBase(IManager & manager, Args &&...) : mDone(Block(&manager)) {}
+    template <class... Args>
+    TaskPromiseBase(Args &&...) : mDone(Block(IManager::GetCurrent())) {}
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Released once the coroutine has suspended for the last time, after
+    /// which the frame is only touched by its Task.
+    // ------------------------------------------------------------------------------------  MEMBER
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        template <class P>
+        void await_suspend(std::coroutine_handle<P> coroutine) const noexcept
+        {
+            JobHandleBlocked done = coroutine.promise().mDone;
+            done.ReleaseBarrier();
+        }
+        void await_resume() const noexcept {}
+    };
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    std::suspend_never initial_suspend() const noexcept { return std::suspend_never(); }
+    FinalAwaiter       final_suspend() const noexcept   { return FinalAwaiter(); }
+    void               unhandled_exception() const      { XR_ALWAYS_UNEXPECTED(); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Coroutine frames come from the general allocator like everything
+    /// else, the global new is not meant to be used.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static void *      operator new(size_t size)        { return XR_ALLOC_ALIGN(size, "Scheduling::Task", 16); }
+    static void        operator delete(void * frame)    { XR_FREE(frame); }
+
+    JobHandleBlocked   mDone;
+private:
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    static JobHandleBlocked Block(IManager * manager)
+    {
+        XR_ASSERT_ALWAYS_NE_M(manager, (IManager *)nullptr, "Task needs an IManager parameter or to be started on a worker");
+        // Only forwards the completion, get it out of the way quickly.
+        return manager->InsertBlocked((Core::Runnable)nullptr, nullptr, kPriorityHigh);
+    }
+};
+// ***************************************************************************************** - TYPE
+/*! The value is kept in the promise (in the coroutine frame). */
+// ***************************************************************************************** - TYPE
+template <class T>
+class TaskPromise : public TaskPromiseBase
+{
+public:
+    template <class... Args>
+    TaskPromise(Args &&... args) : TaskPromiseBase(std::forward<Args>(args)...), mHasValue(false) {}
+    ~TaskPromise()
+    {
+        if(mHasValue)
+        {
+            GetValue().~T();
+        }
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    template <class U>
+    void return_value(U && value)
+    {
+        new (mValue) T(std::forward<U>(value));
+        mHasValue = true;
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    T &  GetValue()  { return *reinterpret_cast<T *>(mValue); }
+    T    TakeValue() { return std::move(GetValue()); }
+private:
+    alignas(T) unsigned char mValue[sizeof(T)];
+    bool                     mHasValue;
+};
+// ***************************************************************************************** - TYPE
+// ***************************************************************************************** - TYPE
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+public:
+    template <class... Args>
+    TaskPromise(Args &&... args) : TaskPromiseBase(std::forward<Args>(args)...) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void return_void() {}
+    void GetValue()    {}
+    void TakeValue()   {}
+};
+} // namespace detail
+
+// ***************************************************************************************** - TYPE
+/*! \copydoc task
+    */
+// ***************************************************************************************** - TYPE
+template <class T>
+class Task
+{
+public:
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Required by the compiler.
+    // ------------------------------------------------------------------------------------  MEMBER
+    class promise_type : public detail::TaskPromise<T>
+    {
+    public:
+        template <class... Args>
+        promise_type(Args &&... args) : detail::TaskPromise<T>(std::forward<Args>(args)...) {}
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    };
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// co_await on a Task, yields the value it co_returned (moved out).
+    // ------------------------------------------------------------------------------------  MEMBER
+    class Awaiter : public JobAwaiter
+    {
+    public:
+        Awaiter(promise_type & promise) : JobAwaiter(promise.mDone, kPriorityNormal), mPromise(promise) {}
+        decltype(auto) await_resume() const { return mPromise.TakeValue(); }
+    private:
+        promise_type & mPromise;
+    };
+
+    Task() {}
+    Task(Task && other) : mCoroutine(other.mCoroutine) { other.mCoroutine = nullptr; }
+    Task & operator=(Task && other)
+    {
+        if(this != &other)
+        {
+            Release();
+            mCoroutine = other.mCoroutine;
+            other.mCoroutine = nullptr;
+        }
+        return *this;
+    }
+    Task(const Task &) = delete;
+    Task & operator=(const Task &) = delete;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Waits for the coroutine to finish, see \ref task "Completion".
+    // ------------------------------------------------------------------------------------  MEMBER
+    ~Task() { Release(); }
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Completes when the coroutine has finished, usable as an antecedent.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle GetHandle() const { return mCoroutine ? JobHandle(mCoroutine.promise().mDone) : JobHandle(); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool      IsDone() const    { return mCoroutine.promise().mDone.IsDone(); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Waits (see JobHandle::WaitOn) and returns the value, which stays in
+    /// the Task. For use outside coroutines, inside co_await the task.
+    // ------------------------------------------------------------------------------------  MEMBER
+    decltype(auto) Get()
+    {
+        mCoroutine.promise().mDone.WaitOn();
+        return mCoroutine.promise().GetValue();
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    Awaiter operator co_await() const { return Awaiter(mCoroutine.promise()); }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> coroutine) : mCoroutine(coroutine) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Release()
+    {
+        if(mCoroutine)
+        {
+            mCoroutine.promise().mDone.WaitOn();
+            mCoroutine.destroy();
+            mCoroutine = nullptr;
+        }
+    }
+
+    std::coroutine_handle<promise_type> mCoroutine;
+};
+
+}}//namespace xr
+#endif // #if XR_SCHEDULING_TASK_ENABLED
+
+#endif //#ifndef XR_SERVICES_TASK_H
@@ -96,6 +96,23 @@ XR_UNITTEST_TEST_FUNC( basic )
     SimpleTest(3);
     SimpleTest(4);
 }
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( tryEnqueue )
+{
+    xr::Core::BlockingQueue<int32_t> test(2);
+
+    XR_ASSERT_ALWAYS_EQ(test.TryEnqueue(1), true);
+    XR_ASSERT_ALWAYS_EQ(test.TryEnqueue(2), true);
+    XR_ASSERT_ALWAYS_EQ(test.TryEnqueue(3), false);
+    XR_ASSERT_ALWAYS_EQ(test.UnsafeGetAvailableCount(), 2);
+
+    XR_ASSERT_ALWAYS_EQ(test.Dequeue(), 1);
+    XR_ASSERT_ALWAYS_EQ(test.TryEnqueue(3), true);
+    XR_ASSERT_ALWAYS_EQ(test.Dequeue(), 2);
+    XR_ASSERT_ALWAYS_EQ(test.Dequeue(), 3);
+}
 
 template<typename T, size_t kCount>
 class ThreadDequeue : public xr::Core::Thread{
@@ -0,0 +1,164 @@
+// ######################################################################################### - FILE
+/*!
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#include "xr/defines.h"
+#endif
+#ifndef XR_CORE_THREADING_FIBER_H
+#include "xr/core/threading/fiber.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_TEST_H
+#include "xr/core/test.h"
+#endif
+#if defined(XR_CPU_X86)
+#include <xmmintrin.h>
+#endif
+
+// ######################################################################################### - FILE
+/* Unit Tests                                                                */
+// ######################################################################################### - FILE
+#if defined(XR_TEST_FEATURES_ENABLED)
+
+namespace {
+// ***************************************************************************************** - TYPE
+/// The thread and one created fiber taking turns.
+// ***************************************************************************************** - TYPE
+struct PingPong
+{
+    xr::Core::Fiber mThread;
+    xr::Core::Fiber mFiber;
+    volatile int    mTurns;
+    double          mSum;
+    volatile uintptr_t mAligned;
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Keeps locals live across switches, so they must come back in the
+/// registers or stack slots they left in.
+// --------------------------------------------------------------------------------------  FUNCTION
+void PingPongEntry(void * context)
+{
+    PingPong * pp = (PingPong *)context;
+    // The compiler trusts the ABI's stack alignment, so this is only
+    // aligned if the fiber started on a correctly aligned frame.
+    XR_ALIGN_PREFIX(16) double aligned[2] XR_ALIGN_POSTFIX(16);
+    pp->mAligned = uintptr_t(&aligned[0]);
+    double sum = 0.5;
+    int    local = 1000;
+    for(int i = 0; i < 100; ++i)
+    {
+        sum   += 0.25;
+        local += i;
+        pp->mTurns = pp->mTurns + 1;
+        xr::Core::Fiber::Switch(pp->mFiber, pp->mThread);
+    }
+    pp->mSum = sum + double(local);
+    // Never returns, the test never switches back.
+    xr::Core::Fiber::Switch(pp->mFiber, pp->mThread);
+}
+
+#if defined(XR_CPU_X86)
+// ***************************************************************************************** - TYPE
+/// What a fresh fiber sees of the floating point environment.
+// ***************************************************************************************** - TYPE
+struct FloatState
+{
+    xr::Core::Fiber     mThread;
+    xr::Core::Fiber     mFiber;
+    volatile uint32_t   mCsr;
+    volatile double     mThird;
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/// An inexact divide traps if the fiber started with exceptions unmasked.
+// --------------------------------------------------------------------------------------  FUNCTION
+void FloatStateEntry(void * context)
+{
+    FloatState * fs = (FloatState *)context;
+    volatile double one   = 1.0;
+    volatile double three = 3.0;
+    fs->mThird = one / three;
+    fs->mCsr   = _mm_getcsr();
+    xr::Core::Fiber::Switch(fs->mFiber, fs->mThread);
+}
+#endif
+}
+
+// ######################################################################################### - FILE
+// ######################################################################################### - FILE
+XR_UNITTEST_GROUP_BEGIN( Fiber )
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( FiberPingPong )
+{
+    PingPong pp;
+    pp.mTurns = 0;
+    pp.mSum   = 0.0;
+    pp.mAligned = 0;
+
+    pp.mThread.AttachToThread();
+    bool created = pp.mFiber.Create(&PingPongEntry, &pp, 16 * 1024);
+    XR_ASSERT_ALWAYS_EQ(created, true);
+    XR_ASSERT_ALWAYS_GE(pp.mFiber.GetStackSize(), size_t(16 * 1024));
+
+    double expected = 2.0;
+    for(int i = 0; i < 100; ++i)
+    {
+        expected *= 1.5;
+        xr::Core::Fiber::Switch(pp.mThread, pp.mFiber);
+        XR_ASSERT_ALWAYS_EQ(pp.mTurns, i + 1);
+    }
+    XR_ASSERT_ALWAYS_EQ(pp.mAligned % 16, uintptr_t(0));
+    xr::Core::Fiber::Switch(pp.mThread, pp.mFiber);
+
+    double check = 2.0;
+    for(int i = 0; i < 100; ++i)
+    {
+        check *= 1.5;
+    }
+    XR_ASSERT_ALWAYS_EQ(expected, check);
+    XR_ASSERT_ALWAYS_EQ(pp.mSum, 0.5 + 25.0 + 1000.0 + 4950.0);
+
+    pp.mThread.DetachFromThread();
+}
+
+#if defined(XR_CPU_X86)
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! A new fiber starts with the thread's rounding and exception masks. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( FiberFloatState )
+{
+    FloatState fs;
+    fs.mCsr   = 0;
+    fs.mThird = 0.0;
+
+    fs.mThread.AttachToThread();
+    bool created = fs.mFiber.Create(&FloatStateEntry, &fs, 16 * 1024);
+    XR_ASSERT_ALWAYS_EQ(created, true);
+    xr::Core::Fiber::Switch(fs.mThread, fs.mFiber);
+
+    // The low six bits are sticky exception flags, not configuration.
+    const uint32_t kFlags = 0x3F;
+    XR_ASSERT_ALWAYS_EQ(fs.mCsr & ~kFlags, _mm_getcsr() & ~kFlags);
+    XR_ASSERT_ALWAYS_LT(fs.mThird * 3.0 - 1.0, 1.0e-15);
+    XR_ASSERT_ALWAYS_GT(fs.mThird * 3.0 - 1.0, -1.0e-15);
+
+    fs.mThread.DetachFromThread();
+}
+#endif
+
+XR_UNITTEST_GROUP_END()
+
+#endif // #if defined(XR_TEST_FEATURES_ENABLED)
@@ -142,6 +142,36 @@ XR_UNITTEST_TEST_FUNC( simpleTest )
     XR_FREE(buffer);
 }
 
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Nested markers, rolling back across overflow buckets. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( rollbackTest )
+{
+    const size_t kTestUse = 256;
+    void * buffer = XR_ALLOC(kTestUse, "test");
+    xr::Core::LinearAllocator la("Test", buffer, kTestUse, 128 );
+
+    void * p0 = la.Alloc(16);
+    const xr::Core::LinearAllocator::Marker outer = la.GetMarker();
+    void * p1 = la.Alloc(16);
+    {
+        xr::Core::LinearAllocatorScope scope(&la);
+        la.Alloc(200);
+        // Overflows, twice.
+        XR_ASSERT_ALWAYS_NE(la.Alloc(300), (void *)nullptr);
+        XR_ASSERT_ALWAYS_NE(la.Alloc(300), (void *)nullptr);
+    }
+    XR_ASSERT_ALWAYS_EQ(la.Alloc(16), xr::Core::AddBytesToPtr(p1, 16));
+
+    la.Rollback(outer);
+    XR_ASSERT_ALWAYS_EQ(la.Alloc(16), p1);
+    XR_ASSERT_ALWAYS_EQ(la.Clear(), 32);
+    XR_ASSERT_ALWAYS_EQ(la.Alloc(16), p0);
+
+    la.Clear();
+    XR_FREE(buffer);
+}
+
 XR_UNITTEST_TEST_FUNC( comTest )
 {
 
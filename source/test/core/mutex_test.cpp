@@ -14,6 +14,15 @@
 #ifndef XR_CORE_THREADING_MUTEX_H
 #include "xr/core/threading/mutex.h"
 #endif
+#ifndef XR_CORE_THREADING_MONITOR_H
+#include "xr/core/threading/monitor.h"
+#endif
+#ifndef XR_CORE_THREADING_THREAD_H
+#include "xr/core/threading/thread.h"
+#endif
+#ifndef XR_CORE_TIME_H
+#include "xr/core/time.h"
+#endif
 #ifndef XR_CORE_ASSERT_H
 #include "xr/core/assert.h"
 #endif
@@ -44,6 +53,35 @@ XR_UNITTEST_TEST_FUNC( Mutex )
     m.Unlock();
 }
 
+// ***************************************************************************************** - TYPE
+/// Tries to take a mutex the test thread holds.
+// ***************************************************************************************** - TYPE
+class TryLockThread: public xr::Core::Thread
+{
+public:
+    TryLockThread(xr::Core::Mutex * m) : ::xr::Core::Thread("tryLockThread"), mMutex(m) {}
+    uintptr_t Run()
+    {
+        return mMutex->TryLock() ? 1 : 0;
+    }
+    xr::Core::Mutex * mMutex;
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  Held elsewhere, TryLock fails instead of asserting. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( MutexTryLockContended )
+{
+    xr::Core::Mutex m;
+
+    m.Lock();
+    TryLockThread t(&m);
+    t.Start();
+    t.Join();
+    XR_ASSERT_ALWAYS_EQ(t.GetReturnCode(), 0);
+    m.Unlock();
+}
+
 // --------------------------------------------------------------------------------------  FUNCTION
 /*!  */
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -57,6 +95,24 @@ XR_UNITTEST_TEST_FUNC( AutoProtectScope )
 }
 
 
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  Nobody signals, so the wait times out (not before it should). */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( MonitorTimedWait )
+{
+    xr::Core::Mutex m;
+    xr::Core::Monitor monitor;
+
+    m.Lock();
+    xr::Core::TimeStamp start = xr::Core::GetTimeStamp();
+    bool signaled = monitor.Wait(m, 2000);
+    xr::Core::TimeStamp end = xr::Core::GetTimeStamp();
+    m.Unlock();
+
+    XR_ASSERT_ALWAYS_EQ(signaled, false);
+    XR_ASSERT_ALWAYS_GE(xr::Core::TimeStampToMicroSeconds(end - start), 1900);
+}
+
 // --------------------------------------------------------------------------------------  FUNCTION
 /*!  */
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -20,6 +20,12 @@
 #ifndef XR_CORE_THREADING_MUTEX_H
 #include "xr/core/threading/mutex.h"
 #endif
+#ifndef XR_CORE_THREADING_FIBER_H
+#include "xr/core/threading/fiber.h"
+#endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
 #ifndef XR_CORE_TEST_H
 #include "xr/core/test.h"
 #endif
@@ -175,6 +181,86 @@ XR_UNITTEST_TEST_FUNC( Coverage )
 
 }
 
+// ***************************************************************************************** - TYPE
+/// Reports the affinity it was started with.
+// ***************************************************************************************** - TYPE
+class AffinityThread: public xr::Core::Thread
+{
+public:
+    AffinityThread() : ::xr::Core::Thread("affinityThread") {}
+    uintptr_t Run()
+    {
+        return GetAffinity();
+    }
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Affinity )
+{
+    size_t count = xr::Core::Thread::GetProcessorInfo(nullptr, 0);
+    XR_ASSERT_ALWAYS_GE(count, 1);
+
+    xr::Core::Thread::ProcessorInfo * info = (xr::Core::Thread::ProcessorInfo *)XR_ALLOC(sizeof(xr::Core::Thread::ProcessorInfo) * count, "Test");
+    XR_ASSERT_ALWAYS_EQ(xr::Core::Thread::GetProcessorInfo(info, count), count);
+    for(size_t i = 1; i < count; i++)
+    {
+        // Ascending and unique.
+        XR_ASSERT_ALWAYS_LT(info[i-1].mProcessor, info[i].mProcessor);
+    }
+
+    AffinityThread floating;
+    XR_ASSERT_ALWAYS_EQ(floating.GetAffinity(), xr::Core::Thread::kNoAffinity);
+    floating.Start();
+    floating.Join();
+    XR_ASSERT_ALWAYS_EQ(floating.GetReturnCode(), uintptr_t(xr::Core::Thread::kNoAffinity));
+
+    // Pin to the last processor, it still has to run.
+    AffinityThread pinned;
+    pinned.SetAffinity(info[count-1].mProcessor);
+    pinned.Start();
+    pinned.Join();
+    XR_ASSERT_ALWAYS_EQ(pinned.GetReturnCode(), info[count-1].mProcessor);
+
+    XR_FREE(info);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Ping pong between the thread and a fiber. */
+// --------------------------------------------------------------------------------------  FUNCTION
+struct FiberPingPong
+{
+    xr::Core::Fiber mThread;
+    xr::Core::Fiber mFiber;
+    size_t          mCount;
+
+    static void Main(void * context)
+    {
+        FiberPingPong * self = (FiberPingPong *)context;
+        for(;;)
+        {
+            self->mCount = self->mCount + 1;
+            xr::Core::Fiber::Switch(self->mFiber, self->mThread);
+        }
+    }
+};
+XR_UNITTEST_TEST_FUNC( Fiber )
+{
+    FiberPingPong test;
+    test.mCount = 0;
+    test.mThread.AttachToThread();
+    XR_ASSERT_ALWAYS_TRUE(test.mFiber.Create(&FiberPingPong::Main, &test, 16 * 1024));
+    XR_ASSERT_ALWAYS_EQ(test.mFiber.GetStackSize(), 16 * 1024);
+
+    for(size_t i = 1; i <= 100; ++i)
+    {
+        xr::Core::Fiber::Switch(test.mThread, test.mFiber);
+        XR_ASSERT_ALWAYS_EQ(test.mCount, i);
+    }
+    test.mThread.DetachFromThread();
+}
+
 XR_UNITTEST_GROUP_END()
 
 #endif // #if defined(XR_TEST_FEATURES_ENABLED)
@@ -0,0 +1,196 @@
+// ######################################################################################### - FILE
+/*!
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#include "xr/defines.h"
+#endif
+#ifndef XR_CORE_THREADING_WORK_STEALING_DEQUE_H
+#include "xr/core/threading/work_stealing_deque.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_TEST_H
+#include "xr/core/test.h"
+#endif
+#ifndef XR_CORE_THREADING_THREAD_H
+#include "xr/core/threading/thread.h"
+#endif
+#ifndef XR_CORE_THREADING_ATOMIC_H
+#include "xr/core/threading/atomic.h"
+#endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
+// ######################################################################################### - FILE
+/* Unit Tests                                                                */
+// ######################################################################################### - FILE
+#if defined(XR_TEST_FEATURES_ENABLED)
+
+// ######################################################################################### - FILE
+// ######################################################################################### - FILE
+XR_UNITTEST_GROUP_BEGIN( WorkStealingDeque )
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( basic )
+{
+    xr::Core::WorkStealingDeque<size_t> test(4);
+    XR_ASSERT_ALWAYS_EQ(test.GetCapacity(), 4);
+
+    size_t p = 0;
+    XR_ASSERT_ALWAYS_FALSE(test.Pop(&p));
+    XR_ASSERT_ALWAYS_FALSE(test.Steal(&p));
+
+    // Fill it.
+    for(size_t i = 0; i < 4; i++)
+    {
+        XR_ASSERT_ALWAYS_TRUE(test.Push(i));
+    }
+    XR_ASSERT_ALWAYS_FALSE(test.Push(size_t(4)));
+    XR_ASSERT_ALWAYS_EQ(test.UnsafeGetCount(), 4);
+
+    // Owner is LIFO
+    XR_ASSERT_ALWAYS_TRUE(test.Pop(&p));
+    XR_ASSERT_ALWAYS_EQ(p, 3);
+    // Thieves are FIFO
+    XR_ASSERT_ALWAYS_TRUE(test.Steal(&p));
+    XR_ASSERT_ALWAYS_EQ(p, 0);
+    XR_ASSERT_ALWAYS_TRUE(test.Steal(&p));
+    XR_ASSERT_ALWAYS_EQ(p, 1);
+    XR_ASSERT_ALWAYS_TRUE(test.Pop(&p));
+    XR_ASSERT_ALWAYS_EQ(p, 2);
+
+    XR_ASSERT_ALWAYS_FALSE(test.Pop(&p));
+    XR_ASSERT_ALWAYS_FALSE(test.Steal(&p));
+    XR_ASSERT_ALWAYS_EQ(test.UnsafeGetCount(), 0);
+
+    // Wrap around a few times.
+    for(size_t i = 0; i < 37; i++)
+    {
+        XR_ASSERT_ALWAYS_TRUE(test.Push(i));
+        XR_ASSERT_ALWAYS_TRUE(test.Push(i + 100));
+        XR_ASSERT_ALWAYS_TRUE(test.Steal(&p));
+        XR_ASSERT_ALWAYS_EQ(p, i);
+        XR_ASSERT_ALWAYS_TRUE(test.Pop(&p));
+        XR_ASSERT_ALWAYS_EQ(p, i + 100);
+    }
+}
+
+// ***************************************************************************************** - TYPE
+/// Marks every value taken from the deque, any value seen twice (or never)
+/// shows up in the counts.
+// ***************************************************************************************** - TYPE
+class ThreadThief : public xr::Core::Thread{
+public:
+    ThreadThief(xr::Core::WorkStealingDeque<size_t> *deque, volatile uint32_t * counts, volatile uint32_t * done): xr::Core::Thread("thief")
+    {
+        mDeque = deque;
+        mCounts = counts;
+        mDone = done;
+        mTaken = 0;
+    }
+
+    uintptr_t Run()
+    {
+        size_t p;
+        for(;;)
+        {
+            if(mDeque->Steal(&p))
+            {
+                xr::Core::AtomicIncrement(&mCounts[p]);
+                ++mTaken;
+            }
+            else if(*mDone != 0 && mDeque->UnsafeGetCount() == 0)
+            {
+                break;
+            }
+        }
+        return 0;
+    }
+
+    size_t mTaken;
+    xr::Core::WorkStealingDeque<size_t> *mDeque;
+    volatile uint32_t * mCounts;
+    volatile uint32_t * mDone;
+};
+
+template <size_t kNumThieves, size_t kDequeSize, size_t kLoadCount>
+void ThreadTest()
+{
+    xr::Core::WorkStealingDeque<size_t> test(kDequeSize);
+    volatile uint32_t * counts = (volatile uint32_t *)XR_ALLOC(sizeof(uint32_t) * kLoadCount, "Test");
+    for(size_t i = 0; i < kLoadCount; i++)
+    {
+        counts[i] = 0;
+    }
+    volatile uint32_t done = 0;
+
+    ThreadThief * thieves[kNumThieves];
+    for(size_t i = 0; i < kNumThieves; i++)
+    {
+        thieves[i] = XR_NEW( "thiefThread" ) ThreadThief(&test, counts, &done);
+        thieves[i]->Start();
+    }
+
+    // Owner pushes everything and pops every third push, racing the thieves
+    // for the last entry as often as possible.
+    size_t popped = 0;
+    size_t p;
+    for(size_t i = 0; i < kLoadCount; )
+    {
+        if(test.Push(i))
+        {
+            ++i;
+        }
+        if((i % 3) == 0 && test.Pop(&p))
+        {
+            xr::Core::AtomicIncrement(&counts[p]);
+            ++popped;
+        }
+    }
+    while(test.Pop(&p))
+    {
+        xr::Core::AtomicIncrement(&counts[p]);
+        ++popped;
+    }
+    done = 1;
+
+    size_t stolen = 0;
+    for(size_t i = 0; i < kNumThieves; i++)
+    {
+        thieves[i]->Join();
+        stolen += thieves[i]->mTaken;
+        XR_DELETE(thieves[i]);
+    }
+
+    XR_ASSERT_ALWAYS_EQ(popped + stolen, kLoadCount);
+    for(size_t i = 0; i < kLoadCount; i++)
+    {
+        XR_ASSERT_ALWAYS_EQ(counts[i], 1);
+    }
+    XR_FREE((void*)counts);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( basicThreadedTests )
+{
+    ThreadTest<1, 2, 1000>();
+    ThreadTest<4, 2, 10000>();
+    ThreadTest<4, 64, 100000>();
+    ThreadTest<16, 1024, 100000>();
+}
+
+XR_UNITTEST_GROUP_END()
+
+#endif // #if defined(XR_TEST_FEATURES_ENABLED)
@@ -0,0 +1,181 @@
+// ######################################################################################### - FILE
+/*!
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#include "xr/defines.h"
+#endif
+#ifndef XR_SERVICES_JOB_GRAPH_H
+#include "xr/services/job_graph.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_TEST_H
+#include "xr/core/test.h"
+#endif
+#ifndef XR_CORE_THREADING_ATOMIC_H
+#include "xr/core/threading/atomic.h"
+#endif
+#ifndef XR_CORE_THREADING_THREAD_H
+#include "xr/core/threading/thread.h"
+#endif
+// ######################################################################################### - FILE
+/* Unit Tests                                                                */
+// ######################################################################################### - FILE
+#if defined(XR_TEST_FEATURES_ENABLED)
+
+// ######################################################################################### - FILE
+// ######################################################################################### - FILE
+XR_UNITTEST_GROUP_BEGIN( JobGraph )
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Stamps the node's slot with the order it finished in.
+    a0 = stamp array, a1 = next stamp, a2 = node index. */
+// --------------------------------------------------------------------------------------  FUNCTION
+void StampRunnable(const xr::Core::Arguments * a)
+{
+    volatile size_t * stamps = (volatile size_t *)a->a0;
+    volatile size_t * next   = (volatile size_t *)a->a1;
+    stamps[a->a2] = xr::Core::AtomicIncrement(next) + 1;
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Layers of nodes, each depending on a few of the layer before, launched
+    repeatedly. Every node must run once per launch and after all of its
+    antecedents. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Replay )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    options.mReadyListSize = 1024;
+    options.mFreeListSize = 2048;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    const size_t kLayers = 20;
+    const size_t kWidth  = 100;
+    const size_t kNodes  = kLayers * kWidth;
+    static volatile size_t stamps[kNodes];
+    volatile size_t next = 0;
+
+    xr::Scheduling::JobGraph graph;
+    for(size_t i = 0; i < kNodes; ++i)
+    {
+        xr::Core::Arguments args((uintptr_t)stamps, (uintptr_t)&next, i);
+        XR_ASSERT_ALWAYS_EQ(graph.AddNode(&StampRunnable, &args, xr::Scheduling::Priority(i % xr::Scheduling::kPriorityCount)), i);
+    }
+    for(size_t layer = 1; layer < kLayers; ++layer)
+    {
+        for(size_t i = 0; i < kWidth; ++i)
+        {
+            const size_t after = layer * kWidth + i;
+            graph.AddEdge((layer - 1) * kWidth + i, after);
+            graph.AddEdge((layer - 1) * kWidth + (i * 7 + 3) % kWidth, after);
+        }
+    }
+    XR_ASSERT_ALWAYS_EQ(graph.GetNodeCount(), kNodes);
+
+    for(size_t launch = 0; launch < 10; ++launch)
+    {
+        next = 0;
+        for(size_t i = 0; i < kNodes; ++i)
+        {
+            stamps[i] = 0;
+        }
+
+        xr::Scheduling::JobHandle h = graph.Launch(p);
+        h.WaitOn();
+        XR_ASSERT_ALWAYS_EQ(graph.IsRunning(), false);
+        XR_ASSERT_ALWAYS_EQ(next, kNodes);
+
+        for(size_t layer = 1; layer < kLayers; ++layer)
+        {
+            for(size_t i = 0; i < kWidth; ++i)
+            {
+                const size_t after = layer * kWidth + i;
+                XR_ASSERT_ALWAYS_GT(stamps[after], stamps[(layer - 1) * kWidth + i]);
+                XR_ASSERT_ALWAYS_GT(stamps[after], stamps[(layer - 1) * kWidth + (i * 7 + 3) % kWidth]);
+            }
+        }
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Lambda nodes are kept by the graph, edits recompile, and an empty graph
+    is complete right away. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Lambdas )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 64;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    {
+        xr::Scheduling::JobGraph empty;
+        XR_ASSERT_ALWAYS_EQ(empty.Launch(p).IsDone(), true);
+    }
+
+    volatile size_t sum = 0;
+    {
+        xr::Scheduling::JobGraph graph;
+        size_t a = graph.AddNode([&sum] () { xr::Core::AtomicAdd(&sum, size_t(1)); });
+        size_t b = graph.AddNode([&sum] () { xr::Core::AtomicAdd(&sum, size_t(10)); });
+        graph.AddEdge(a, b);
+
+        graph.Launch(p).WaitOn();
+        graph.Launch(p).WaitOn();
+        XR_ASSERT_ALWAYS_EQ(sum, 22);
+
+        // Add to the graph between launches.
+        uint8_t padding[200] = {};
+        padding[199] = 100;
+        size_t c = graph.AddNode([&sum, padding] () { xr::Core::AtomicAdd(&sum, size_t(padding[199])); });
+        graph.AddEdge(b, c);
+        graph.Launch(p).WaitOn();
+        XR_ASSERT_ALWAYS_EQ(sum, 133);
+    }
+
+    // Relaunch as soon as IsRunning says it may: every launch's handle
+    // still completes.
+    {
+        xr::Scheduling::JobGraph graph;
+        size_t root = graph.AddNode([] () {});
+        for(size_t i = 0; i < 4; ++i)
+        {
+            graph.AddEdge(root, graph.AddNode([&sum] () { xr::Core::AtomicIncrement(&sum); }));
+        }
+        sum = 0;
+        const size_t kLaunches = 200;
+        static xr::Scheduling::JobHandle launches[kLaunches];
+        for(size_t i = 0; i < kLaunches; ++i)
+        {
+            launches[i] = graph.Launch(p);
+            while(graph.IsRunning())
+            {
+                xr::Core::Thread::YieldCurrentThread();
+            }
+        }
+        for(size_t i = 0; i < kLaunches; ++i)
+        {
+            launches[i].WaitOn();
+        }
+        XR_ASSERT_ALWAYS_EQ(sum, kLaunches * 4);
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+XR_UNITTEST_GROUP_END()
+
+#endif // #if defined(XR_TEST_FEATURES_ENABLED)
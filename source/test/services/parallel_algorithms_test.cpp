@@ -0,0 +1,262 @@
+// ######################################################################################### - FILE
+/*!
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#include "xr/defines.h"
+#endif
+#ifndef XR_SERVICES_PARALLEL_ALGORITHMS_H
+#include "xr/services/parallel_algorithms.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_TEST_H
+#include "xr/core/test.h"
+#endif
+#ifndef XR_CORE_TIME_H
+#include "xr/core/time.h"
+#endif
+#ifndef XR_CORE_BIT_UTILS_H
+#include "xr/core/bit_utils.h"
+#endif
+#ifndef XR_CORE_CONSOLE_H
+#include "xr/core/console.h"
+#endif
+// ######################################################################################### - FILE
+/* Unit Tests                                                                */
+// ######################################################################################### - FILE
+#if defined(XR_TEST_FEATURES_ENABLED)
+
+// ######################################################################################### - FILE
+// ######################################################################################### - FILE
+XR_UNITTEST_GROUP_BEGIN( ParallelAlgorithms )
+
+using xr::Scheduling::IManager;
+using xr::Scheduling::JobHandle;
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Repeatable values in [0, range), with plenty of duplicates for small ranges. */
+// --------------------------------------------------------------------------------------  FUNCTION
+static void Fill(uint32_t * data, size_t count, uint32_t range)
+{
+    uint32_t seed = 12345;
+    for(size_t i = 0; i < count; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (seed >> 8) % range;
+    }
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Serial (inline) and parallel results against a plain loop, sizes
+    around the grain. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( ReduceAndScan )
+{
+    IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    IManager * p = IManager::Initialize(&options);
+
+    const size_t kMax = 10000;
+    uint64_t * data = XR_NEW("ParallelAlgorithms") uint64_t[kMax];
+    uint64_t * scan = XR_NEW("ParallelAlgorithms") uint64_t[kMax];
+    for(size_t i = 0; i < kMax; ++i)
+    {
+        data[i] = i * 3 + 1;
+    }
+
+    const size_t counts[] = { 0, 1, 100, 101, 999, 1000, kMax };
+    for(size_t c = 0; c < XR_ARRAY_SIZE(counts); ++c)
+    {
+        const size_t count = counts[c];
+        uint64_t sum = 7;
+        JobHandle h = xr::Scheduling::ParallelReduce(p, data, count, uint64_t(0),
+            [] (uint64_t a, uint64_t b) { return a + b; }, &sum, 100);
+        h.WaitOn();
+        uint64_t expected = 0;
+        for(size_t i = 0; i < count; ++i)
+        {
+            expected += data[i];
+        }
+        XR_ASSERT_ALWAYS_EQ(sum, expected);
+
+        h = xr::Scheduling::ParallelInclusiveScan(p, data, scan, count,
+            [] (uint64_t a, uint64_t b) { return a + b; }, 100);
+        h.WaitOn();
+        expected = 0;
+        for(size_t i = 0; i < count; ++i)
+        {
+            expected += data[i];
+            XR_ASSERT_ALWAYS_EQ(scan[i], expected);
+        }
+    }
+
+    // Not commutative: the order of the elements must be kept.
+    {
+        uint64_t last = 0;
+        JobHandle h = xr::Scheduling::ParallelReduce(p, data, kMax, uint64_t(0),
+            [] (uint64_t, uint64_t b) { return b; }, &last, 64);
+        h.WaitOn();
+        XR_ASSERT_ALWAYS_EQ(last, data[kMax - 1]);
+    }
+
+    // In place.
+    xr::Scheduling::ParallelInclusiveScan(p, data, data, kMax,
+        [] (uint64_t a, uint64_t b) { return a > b ? a : b; }, 333).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(data[kMax - 1], (kMax - 1) * 3 + 1);
+
+    XR_DELETE_ARRAY(scan);
+    XR_DELETE_ARRAY(data);
+    IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Both pass parities, a partial last chunk, duplicates and a custom order. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Sort )
+{
+    IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    IManager * p = IManager::Initialize(&options);
+
+    const size_t kMax = 20000;
+    uint32_t * data = XR_NEW("ParallelAlgorithms") uint32_t[kMax];
+
+    const size_t counts[] = { 0, 1, 64, 65, 128, 300, 1000, kMax };
+    const uint32_t ranges[] = { 4, 1000000 };
+    for(size_t c = 0; c < XR_ARRAY_SIZE(counts); ++c)
+    {
+        for(size_t r = 0; r < XR_ARRAY_SIZE(ranges); ++r)
+        {
+            const size_t count = counts[c];
+            Fill(data, count, ranges[r]);
+            uint64_t sum = 0;
+            for(size_t i = 0; i < count; ++i)
+            {
+                sum += data[i];
+            }
+
+            xr::Scheduling::ParallelSort(p, data, count, xr::Scheduling::detail::DefaultLess<uint32_t>(), 64).WaitOn();
+            for(size_t i = 1; i < count; ++i)
+            {
+                XR_ASSERT_ALWAYS_LE(data[i - 1], data[i]);
+                sum -= data[i];
+            }
+            XR_ASSERT_ALWAYS_EQ(sum, count != 0 ? data[0] : 0);
+        }
+    }
+
+    Fill(data, kMax, 1000000);
+    xr::Scheduling::ParallelSort(p, data, kMax, [] (uint32_t a, uint32_t b) { return a > b; }, 1000).WaitOn();
+    for(size_t i = 1; i < kMax; ++i)
+    {
+        XR_ASSERT_ALWAYS_GE(data[i - 1], data[i]);
+    }
+
+    XR_DELETE_ARRAY(data);
+    IManager::Shutdown(p);
+}
+
+#if defined(XR_BENCHMARK_FEATURES_ENABLED)
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Times the serial loop / std::sort against each algorithm on 1, 2, 4, 8
+    and 16 workers and prints the results. Only correctness is asserted,
+    the numbers depend on the machine (and the parallel sort is not
+    guaranteed to beat std::sort). */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Benchmark )
+{
+    const size_t kCount = 1 << 20;
+    uint32_t * source = XR_NEW("ParallelAlgorithms") uint32_t[kCount];
+    uint32_t * data   = XR_NEW("ParallelAlgorithms") uint32_t[kCount];
+    uint64_t * wide   = XR_NEW("ParallelAlgorithms") uint64_t[kCount];
+    uint64_t * scan   = XR_NEW("ParallelAlgorithms") uint64_t[kCount];
+    Fill(source, kCount, 0xffffffffu);
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        wide[i] = source[i];
+    }
+    const auto add = [] (uint64_t a, uint64_t b) { return a + b; };
+
+    // Serial baselines.
+    uint64_t serialSum = 0;
+    xr::Core::TimeStamp start = xr::Core::GetTimeStamp();
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        serialSum += wide[i];
+    }
+    const uint64_t serialReduce = (uint64_t)xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start);
+
+    start = xr::Core::GetTimeStamp();
+    uint64_t running = 0;
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        running += wide[i];
+        scan[i] = running;
+    }
+    const uint64_t serialScan = (uint64_t)xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start);
+
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        data[i] = source[i];
+    }
+    start = xr::Core::GetTimeStamp();
+    std::sort(data, data + kCount);
+    const uint64_t serialSort = (uint64_t)xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start);
+
+    xr::Core::ConsolePrintf(xr::Core::kConsoleStdOut, XR_EOL "%u elements, serial: reduce %" XR_UINT64_PRINT "us, scan %" XR_UINT64_PRINT "us, sort %" XR_UINT64_PRINT "us" XR_EOL,
+        (unsigned int)kCount, serialReduce, serialScan, serialSort);
+
+    const size_t threads[] = { 1, 2, 4, 8, 16 };
+    for(size_t t = 0; t < XR_ARRAY_SIZE(threads); ++t)
+    {
+        IManager::InitializeOptions options;
+        options.mNumThreads = threads[t];
+        IManager * p = IManager::Initialize(&options);
+
+        uint64_t sum = 0;
+        start = xr::Core::GetTimeStamp();
+        xr::Scheduling::ParallelReduce(p, wide, kCount, uint64_t(0), add, &sum, 16384).WaitOn();
+        const uint64_t reduce = (uint64_t)xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start);
+        XR_ASSERT_ALWAYS_EQ(sum, serialSum);
+
+        start = xr::Core::GetTimeStamp();
+        xr::Scheduling::ParallelInclusiveScan(p, wide, scan, kCount, add, 16384).WaitOn();
+        const uint64_t inclusiveScan = (uint64_t)xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start);
+        XR_ASSERT_ALWAYS_EQ(scan[kCount - 1], serialSum);
+
+        for(size_t i = 0; i < kCount; ++i)
+        {
+            data[i] = source[i];
+        }
+        start = xr::Core::GetTimeStamp();
+        xr::Scheduling::ParallelSort(p, data, kCount).WaitOn();
+        const uint64_t sort = (uint64_t)xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start);
+        for(size_t i = 1; i < kCount; ++i)
+        {
+            XR_ASSERT_ALWAYS_LE(data[i - 1], data[i]);
+        }
+
+        xr::Core::ConsolePrintf(xr::Core::kConsoleStdOut, "%2u threads: reduce %" XR_UINT64_PRINT "us, scan %" XR_UINT64_PRINT "us, sort %" XR_UINT64_PRINT "us" XR_EOL,
+            (unsigned int)threads[t], reduce, inclusiveScan, sort);
+
+        IManager::Shutdown(p);
+    }
+
+    XR_DELETE_ARRAY(scan);
+    XR_DELETE_ARRAY(wide);
+    XR_DELETE_ARRAY(data);
+    XR_DELETE_ARRAY(source);
+}
+#endif // #if defined(XR_BENCHMARK_FEATURES_ENABLED)
+
+XR_UNITTEST_GROUP_END()
+
+#endif // #if defined(XR_TEST_FEATURES_ENABLED)
@@ -29,6 +29,19 @@
 #ifndef XR_CORE_THREADING_THREAD_H
 #include "xr/core/threading/thread.h"
 #endif
+#ifndef XR_CORE_TIME_H
+#include "xr/core/time.h"
+#endif
+#ifndef XR_CORE_ALLOCATORS_LINEAR_H
+#include "xr/core/allocators/linear.h"
+#endif
+#ifndef XR_CORE_MEM_UTILS_H
+#include "xr/core/mem_utils.h"
+#endif
+#ifndef XR_CORE_CONSOLE_H
+#include "xr/core/console.h"
+#endif
+#include <string.h> // strstr, strcmp
 // ######################################################################################### - FILE
 /* Unit Tests                                                                */
 // ######################################################################################### - FILE
@@ -258,14 +271,9 @@ XR_UNITTEST_TEST_FUNC( BlockedBarrierJobs )
 // --------------------------------------------------------------------------------------  FUNCTION
 /*!  */
 // --------------------------------------------------------------------------------------  FUNCTION
-void RunTestWithParams(size_t numThreads, size_t numReady, size_t numFree, size_t numJobs)
+void RunTestWithOptions(xr::Scheduling::IManager::InitializeOptions * options, size_t numJobs)
 {
-    xr::Scheduling::IManager::InitializeOptions options;
-    options.mNumThreads = numThreads;
-    options.mReadyListSize = numReady;
-    options.mFreeListSize = numFree;
-
-    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(options);
 
     xr::Scheduling::JobHandle * h = XR_NEW( "TestJobs") xr::Scheduling::JobHandle[numJobs];
 
@@ -287,6 +295,15 @@ void RunTestWithParams(size_t numThreads, size_t numReady, size_t numFree, size_
     xr::Scheduling::IManager::Shutdown(p);
 }
 
+void RunTestWithParams(size_t numThreads, size_t numReady, size_t numFree, size_t numJobs)
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = numThreads;
+    options.mReadyListSize = numReady;
+    options.mFreeListSize = numFree;
+    RunTestWithOptions(&options, numJobs);
+}
+
 // --------------------------------------------------------------------------------------  FUNCTION
 /*!  */
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -299,6 +316,8 @@ XR_UNITTEST_TEST_FUNC( Counter )
     RunTestWithParams(10, 10, 10, 1000);
     RunTestWithParams(10, 100, 100, 5000);
     RunTestWithParams(30, 1000, 1000, 10000);
+    // Workers cache freed instances, the inserting thread has to reclaim them.
+    RunTestWithParams( 4, 256, 256, 20000);
 }
 
 
@@ -465,6 +484,1540 @@ XR_UNITTEST_TEST_FUNC( DependencyManyToOne )
     RunManyToOneTestWithParams(10, 99, 100, 80);
 }
 
+// ***************************************************************************************** - TYPE
+/// Waits on a handle from a non worker thread.
+// ***************************************************************************************** - TYPE
+class WaiterThread : public xr::Core::Thread{
+public:
+    WaiterThread() : xr::Core::Thread("waiter"), mDone(false) {}
+
+    uintptr_t Run()
+    {
+        mHandle.WaitOn();
+        mDone = mHandle.IsDone();
+        return 0;
+    }
+
+    xr::Scheduling::JobHandle mHandle;
+    volatile bool             mDone;
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  Several threads waiting on the same job and on different jobs. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( MultipleWaiters )
+{
+    static const size_t kNumWaiters = 8;
+
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    options.mReadyListSize = 16;
+    options.mFreeListSize = 16;
+
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    for(int xxx = 0; xxx < 10; xxx++)
+    {
+        xr::Scheduling::JobHandleBlocked gate0 = p->InsertBlocked([] () {});
+        xr::Scheduling::JobHandleBlocked gate1 = p->InsertBlocked([] () {});
+
+        WaiterThread * waiters[kNumWaiters];
+        for(size_t i = 0; i < kNumWaiters; i++)
+        {
+            waiters[i] = XR_NEW( "waiterThread" ) WaiterThread();
+            // Half on each gate.
+            waiters[i]->mHandle = (i & 1) ? gate1 : gate0;
+            waiters[i]->Start();
+        }
+
+        // Completing gate0 must not release the gate1 waiters.
+        gate0.ReleaseBarrier();
+        for(size_t i = 0; i < kNumWaiters; i += 2)
+        {
+            waiters[i]->Join();
+            XR_ASSERT_ALWAYS_EQ(waiters[i]->mDone, true);
+        }
+        for(size_t i = 1; i < kNumWaiters; i += 2)
+        {
+            XR_ASSERT_ALWAYS_EQ(waiters[i]->mDone, false);
+        }
+
+        gate1.ReleaseBarrier();
+        for(size_t i = 1; i < kNumWaiters; i += 2)
+        {
+            waiters[i]->Join();
+            XR_ASSERT_ALWAYS_EQ(waiters[i]->mDone, true);
+        }
+
+        for(size_t i = 0; i < kNumWaiters; i++)
+        {
+            XR_DELETE(waiters[i]);
+        }
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Inserts kFanOut children until depth runs out, these inserts come from
+    worker threads so they land in the worker deques and get stolen. */
+// --------------------------------------------------------------------------------------  FUNCTION
+static const size_t kFanOut = 4;
+void NestedRunnable(const xr::Core::Arguments * a)
+{
+    xr::Scheduling::IManager * p = (xr::Scheduling::IManager *)a->a0;
+    volatile size_t * counter = (volatile size_t *)a->a1;
+    xr::Core::AtomicIncrement(counter);
+
+    if(a->a2 > 0)
+    {
+        xr::Core::Arguments child = *a;
+        child.a2 = a->a2 - 1;
+        for(size_t i = 0; i < kFanOut; i++)
+        {
+            p->InsertReady(&NestedRunnable, &child);
+        }
+    }
+}
+
+void RunNestedTestWithParams(size_t numThreads, size_t numReady, size_t depth)
+{
+    size_t numJobs = 0;
+    size_t level = 1;
+    for(size_t i = 0; i <= depth; i++)
+    {
+        numJobs += level;
+        level *= kFanOut;
+    }
+
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = numThreads;
+    options.mReadyListSize = numReady;
+    // Nothing is waited on until the end, every job needs an instance.
+    options.mFreeListSize = numJobs + 1;
+
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    volatile size_t counter = 0;
+    xr::Core::Arguments a;
+    a.a0 = (uintptr_t)p;
+    a.a1 = (uintptr_t)&counter;
+    a.a2 = depth;
+    p->InsertReady(&NestedRunnable, &a);
+
+    while(counter != numJobs)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+    XR_ASSERT_ALWAYS_EQ(counter, numJobs);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( NestedInsert )
+{
+	//                   numThreads, numReady, depth
+    // Workers block when their deque and the shared list are both full,
+    // numReady must cover the depth first backlog ((kFanOut-1) * depth + 1).
+    RunNestedTestWithParams( 1,  16, 3);
+    RunNestedTestWithParams( 4,  16, 4);
+    RunNestedTestWithParams( 8,  64, 5);
+    RunNestedTestWithParams(30, 256, 6);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Recursive subdivision, every job forks two children and waits on them.
+    Would deadlock if waiting blocked the worker. */
+// --------------------------------------------------------------------------------------  FUNCTION
+void ForkJoinRunnable(const xr::Core::Arguments * a)
+{
+    xr::Scheduling::IManager * p = (xr::Scheduling::IManager *)a->a0;
+    volatile size_t * counter = (volatile size_t *)a->a1;
+    xr::Core::AtomicIncrement(counter);
+
+    if(a->a2 > 0)
+    {
+        xr::Core::Arguments child = *a;
+        child.a2 = a->a2 - 1;
+        xr::Scheduling::JobHandle left  = p->InsertReady(&ForkJoinRunnable, &child);
+        xr::Scheduling::JobHandle right = p->InsertReady(&ForkJoinRunnable, &child);
+        left.WaitOn();
+        right.WaitOn();
+    }
+}
+
+void RunForkJoinTestWithParams(size_t numThreads, size_t depth)
+{
+    size_t numJobs = (size_t(1) << (depth + 1)) - 1;
+
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = numThreads;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = numJobs + 1;
+
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    volatile size_t counter = 0;
+    xr::Core::Arguments a;
+    a.a0 = (uintptr_t)p;
+    a.a1 = (uintptr_t)&counter;
+    a.a2 = depth;
+    p->InsertReady(&ForkJoinRunnable, &a).WaitOn();
+
+    XR_ASSERT_ALWAYS_EQ(counter, numJobs);
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( ForkJoin )
+{
+	//                     numThreads, depth
+    RunForkJoinTestWithParams( 1, 6);
+    RunForkJoinTestWithParams( 2, 8);
+    RunForkJoinTestWithParams( 8, 10);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+void RunParallelForTestWithParams(size_t numThreads, size_t count, size_t grainSize)
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = numThreads;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 64;
+
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    volatile uint32_t * visits = (volatile uint32_t *)XR_ALLOC(sizeof(uint32_t) * (count + 1), "Test");
+    for(size_t i = 0; i < count + 1; i++)
+    {
+        visits[i] = 0;
+    }
+
+    volatile size_t chunks = 0;
+    xr::Scheduling::JobHandle h = p->ParallelFor(1, count + 1, grainSize, [visits, &chunks, grainSize] (size_t b, size_t e) {
+        XR_ASSERT_ALWAYS_LT(b, e);
+        XR_ASSERT_ALWAYS_LE(e - b, grainSize);
+        xr::Core::AtomicIncrement(&chunks);
+        for(size_t i = b; i < e; i++)
+        {
+            xr::Core::AtomicIncrement(&visits[i]);
+        }
+    });
+    h.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(h.IsDone(), true);
+
+    XR_ASSERT_ALWAYS_EQ(visits[0], 0);
+    for(size_t i = 1; i < count + 1; i++)
+    {
+        XR_ASSERT_ALWAYS_EQ(visits[i], 1);
+    }
+    XR_ASSERT_ALWAYS_EQ(chunks, (count + grainSize - 1) / grainSize);
+
+    XR_FREE((void*)visits);
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( ParallelFor )
+{
+	//                        numThreads, count, grainSize
+    RunParallelForTestWithParams( 1,    100,  7);
+    RunParallelForTestWithParams( 4,      5, 10);
+    RunParallelForTestWithParams( 4,  10000,  1);
+    RunParallelForTestWithParams( 8, 100000, 64);
+
+    // Inline, and usable as an antecedent.
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    options.mReadyListSize = 8;
+    options.mFreeListSize = 8;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    xr::Core::Thread::ThreadID caller = xr::Core::Thread::GetCurrentThreadID();
+    bool ranInline = false;
+    xr::Scheduling::JobHandle h = p->ParallelFor(0, 16, 16, [&ranInline, caller] (size_t, size_t) {
+        ranInline = (xr::Core::Thread::GetCurrentThreadID() == caller);
+    });
+    XR_ASSERT_ALWAYS_EQ(ranInline, true);
+    XR_ASSERT_ALWAYS_EQ(h.IsDone(), true);
+
+    bool didRun = false;
+    p->InsertAfter([&didRun] () { didRun = true; }, &h, 1).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(didRun, true);
+
+    // The type erased overload takes the same shortcuts (and still owns
+    // the body): an empty range does nothing, one grain runs inline.
+    size_t covered = 0;
+    auto count = [&covered] (size_t b, size_t e) { covered += e - b; };
+    typedef xr::Scheduling::detail::ParallelForLambda<decltype(count)> Body;
+    xr::Scheduling::detail::ParallelForBody * body = XR_NEW("ParallelFor") Body(count);
+    h = p->ParallelFor(5, 5, 4, body);
+    XR_ASSERT_ALWAYS_EQ(h.IsDone(), true);
+    body = XR_NEW("ParallelFor") Body(count);
+    h = p->ParallelFor(9, 3, 4, body);
+    XR_ASSERT_ALWAYS_EQ(h.IsDone(), true);
+    XR_ASSERT_ALWAYS_EQ(covered, 0);
+    body = XR_NEW("ParallelFor") Body(count);
+    h = p->ParallelFor(3, 7, 4, body);
+    XR_ASSERT_ALWAYS_EQ(h.IsDone(), true);
+    XR_ASSERT_ALWAYS_EQ(covered, 4);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Records the order jobs ran in. a0 = order array, a1 = next slot,
+    a2 = value to record. */
+// --------------------------------------------------------------------------------------  FUNCTION
+void RecordOrderRunnable(const xr::Core::Arguments * a)
+{
+    volatile size_t * order = (volatile size_t *)a->a0;
+    volatile size_t * next  = (volatile size_t *)a->a1;
+    order[xr::Core::AtomicIncrement(next)] = a->a2;
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Occupies the only worker while the lanes are filled, then runs
+    them. Returns the order the priorities ran in. */
+// --------------------------------------------------------------------------------------  FUNCTION
+static const size_t kPriorityJobCount = 16;
+void RunPriorityTestWithParams(size_t starvationInterval, size_t * counts, volatile size_t * order)
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 1;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 256;
+    options.mStarvationInterval = starvationInterval;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    volatile bool started = false;
+    volatile bool release = false;
+    xr::Scheduling::JobHandle gate = p->InsertReady([&started, &release] () {
+        started = true;
+        while(!release)
+        {
+            xr::Core::Thread::YieldCurrentThread();
+        }
+    });
+    while(!started)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+
+    volatile size_t next = 0;
+    size_t total = 0;
+    // Insert lowest priority first so FIFO order alone would fail.
+    for(size_t lane = xr::Scheduling::kPriorityCount; lane-- != 0; )
+    {
+        xr::Core::Arguments a((uintptr_t)order, (uintptr_t)&next, lane, 0);
+        for(size_t i = 0; i < counts[lane]; i++)
+        {
+            p->InsertReady(&RecordOrderRunnable, &a, xr::Scheduling::Priority(lane));
+        }
+        XR_ASSERT_ALWAYS_EQ(p->GetReadyCount(xr::Scheduling::Priority(lane)), counts[lane]);
+        total += counts[lane];
+    }
+
+    release = true;
+    gate.WaitOn();
+    while(next != total)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+    for(size_t lane = 0; lane < xr::Scheduling::kPriorityCount; lane++)
+    {
+        XR_ASSERT_ALWAYS_EQ(p->GetReadyCount(xr::Scheduling::Priority(lane)), 0);
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Priorities )
+{
+    volatile size_t order[kPriorityJobCount * 3];
+
+    // Strict, every lane drains before the next one starts.
+    size_t counts[xr::Scheduling::kPriorityCount] = {kPriorityJobCount, kPriorityJobCount, kPriorityJobCount};
+    RunPriorityTestWithParams(0, counts, order);
+    for(size_t i = 0; i < kPriorityJobCount * 3; i++)
+    {
+        XR_ASSERT_ALWAYS_EQ(order[i], i / kPriorityJobCount);
+    }
+
+    // Starvation guard, background gets a turn while high is still busy.
+    const size_t kInterval = 4;
+    counts[xr::Scheduling::kPriorityHigh]       = kPriorityJobCount * 2;
+    counts[xr::Scheduling::kPriorityNormal]     = 0;
+    counts[xr::Scheduling::kPriorityBackground] = kPriorityJobCount;
+    RunPriorityTestWithParams(kInterval, counts, order);
+    size_t firstBackground = kPriorityJobCount * 3;
+    for(size_t i = 0; i < kPriorityJobCount * 3; i++)
+    {
+        if(order[i] == xr::Scheduling::kPriorityBackground)
+        {
+            firstBackground = i;
+            break;
+        }
+    }
+    XR_ASSERT_ALWAYS_LT(firstBackground, kInterval);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*!  */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Placement )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 8;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 256;
+
+    // One per core, node by node. More workers than cores is allowed.
+    options.mPinThreads = true;
+    options.mSkipSmtSiblings = true;
+    options.mNumaAware = true;
+    RunTestWithOptions(&options, 5000);
+
+    // NUMA placement without pinning.
+    options.mPinThreads = false;
+    options.mSkipSmtSiblings = false;
+    RunTestWithOptions(&options, 5000);
+
+    // Explicit list, every worker on the first processor available to us.
+    xr::Core::Thread::ProcessorInfo first;
+    XR_ASSERT_ALWAYS_GE(xr::Core::Thread::GetProcessorInfo(&first, 1), 1);
+    size_t processors[1] = { first.mProcessor };
+    options.mNumaAware = false;
+    options.mProcessors = processors;
+    options.mProcessorCount = 1;
+    RunTestWithOptions(&options, 5000);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Counts destructions of the instance a job owns. Moved from (and default)
+    instances do not count. */
+// --------------------------------------------------------------------------------------  FUNCTION
+class PayloadTracker{
+public:
+    explicit PayloadTracker(volatile size_t * count) : mCount(count) {}
+    PayloadTracker(const PayloadTracker & other) : mCount(other.mCount) {}
+    PayloadTracker(PayloadTracker && other) : mCount(other.mCount) { other.mCount = nullptr; }
+    ~PayloadTracker()
+    {
+        if(mCount != nullptr)
+        {
+            xr::Core::AtomicIncrement(mCount);
+        }
+    }
+    volatile size_t * mCount;
+};
+
+template<size_t kSize>
+struct PayloadPadding
+{
+    uint8_t mBytes[kSize];
+};
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Inserts a capture of about \a kSize bytes ready, blocked and after, and
+    checks each ran with its data intact and was destroyed exactly once. */
+// --------------------------------------------------------------------------------------  FUNCTION
+template<size_t kSize>
+void RunPayloadTest(xr::Scheduling::IManager * p)
+{
+    PayloadPadding<kSize> padding;
+    for(size_t i = 0; i < kSize; ++i)
+    {
+        padding.mBytes[i] = (uint8_t)i;
+    }
+
+    volatile size_t destroyed = 0;
+    volatile size_t checked = 0;
+    PayloadTracker tracker(&destroyed);
+
+    auto job = [tracker, padding, &checked] () {
+        for(size_t i = 0; i < kSize; ++i)
+        {
+            if(padding.mBytes[i] != (uint8_t)i)
+            {
+                return;
+            }
+        }
+        xr::Core::AtomicIncrement(&checked);
+    };
+
+    xr::Scheduling::JobHandle h = p->InsertReady(job);
+    h.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(checked, 1);
+    XR_ASSERT_ALWAYS_EQ(destroyed, 1);
+
+    xr::Scheduling::JobHandleBlocked hb = p->InsertBlocked(job);
+    xr::Scheduling::JobHandle ha = p->InsertAfter(job, &hb, 1);
+    XR_ASSERT_ALWAYS_EQ(destroyed, 1);
+    hb.ReleaseBarrier();
+    ha.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(checked, 3);
+    XR_ASSERT_ALWAYS_EQ(destroyed, 3);
+
+    // Many at once so the arena hands blocks between threads.
+    const size_t kCount = 200;
+    xr::Scheduling::JobHandle handles[kCount];
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        handles[i] = p->InsertReady(job);
+    }
+    p->InsertAfter([] () {}, handles, kCount).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(checked, 3 + kCount);
+    XR_ASSERT_ALWAYS_EQ(destroyed, 3 + kCount);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Captures inline in the instance, from the payload arena, and too large
+    for either. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Payloads )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 256;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    RunPayloadTest<8>(p);
+    RunPayloadTest<48>(p);
+    RunPayloadTest<256>(p);
+    RunPayloadTest<3000>(p);
+    RunPayloadTest<10000>(p);
+
+    // Nested inserts allocate from the workers' caches.
+    volatile size_t nestedDone = 0;
+    PayloadPadding<512> padding;
+    p->InsertReady([p, padding, &nestedDone] () {
+        xr::Scheduling::JobHandle inner[32];
+        for(size_t i = 0; i < 32; ++i)
+        {
+            inner[i] = p->InsertReady([padding, &nestedDone] () { xr::Core::AtomicIncrement(&nestedDone); });
+        }
+        p->InsertAfter([] () {}, inner, 32).WaitOn();
+    }).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(nestedDone, 32);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Then chains, WhenAll, and successors attached while the antecedent is
+    completing. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Continuations )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    options.mReadyListSize = 256;
+    options.mFreeListSize = 1024;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    // A chain, each link sees the one before it.
+    volatile size_t step = 0;
+    xr::Scheduling::JobHandle h = p->InsertReady([&step] () { step = 1; });
+    for(size_t i = 1; i < 50; ++i)
+    {
+        h = h.Then([&step, i] () { if(step == i) { step = i + 1; } });
+    }
+    h.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(step, 50);
+
+    // Fan out past the inline successors (and several chunks), then back in.
+    const size_t kFanOut = 200;
+    volatile size_t ran = 0;
+    xr::Scheduling::JobHandleBlocked source = p->InsertBlocked([] () {});
+    xr::Scheduling::JobHandle consumers[kFanOut];
+    for(size_t i = 0; i < kFanOut; ++i)
+    {
+        consumers[i] = source.Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    }
+    xr::Scheduling::JobHandle all = p->WhenAll(consumers, kFanOut);
+    XR_ASSERT_ALWAYS_EQ(ran, 0);
+    source.ReleaseBarrier();
+    all.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, kFanOut);
+
+    // Attaching to jobs that are finishing: each successor runs exactly once
+    // whether it was attached in time or found the job already done.
+    for(size_t round = 0; round < 20; ++round)
+    {
+        ran = 0;
+        xr::Scheduling::JobHandle antecedent = p->InsertReady([] () {});
+        for(size_t i = 0; i < kFanOut; ++i)
+        {
+            consumers[i] = antecedent.Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+        }
+        p->WhenAll(consumers, kFanOut).WaitOn();
+        XR_ASSERT_ALWAYS_EQ(ran, kFanOut);
+    }
+
+    // Nothing to wait for, and no scheduler behind a completed handle.
+    XR_ASSERT_ALWAYS_EQ(p->WhenAll(nullptr, 0).IsDone(), true);
+    bool ranInline = false;
+    xr::Scheduling::IManager::GetCompletedHandle().Then([&ranInline] () { ranInline = true; });
+    XR_ASSERT_ALWAYS_EQ(ranInline, true);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! One producer enabling thousands of consumers of mixed priority, a few
+    times over so successor chunks are recycled. More than 8191 of them,
+    the most a 32-bit target could count before the state went to 64 bits. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( FanOut )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    options.mReadyListSize = 16384;
+    options.mFreeListSize = 16384;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    const size_t kConsumers = 10000;
+    static xr::Scheduling::JobHandle consumers[kConsumers];
+    for(size_t round = 0; round < 4; ++round)
+    {
+        volatile size_t ran = 0;
+        xr::Scheduling::JobHandleBlocked producer = p->InsertBlocked([] () {});
+        for(size_t i = 0; i < kConsumers; ++i)
+        {
+            consumers[i] = producer.Then([&ran] () { xr::Core::AtomicIncrement(&ran); },
+                xr::Scheduling::Priority(i % xr::Scheduling::kPriorityCount));
+        }
+        producer.ReleaseBarrier();
+        p->WhenAll(consumers, kConsumers).WaitOn();
+        XR_ASSERT_ALWAYS_EQ(ran, kConsumers);
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Counters add up to the work submitted. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Stats )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 4;
+    options.mReadyListSize = 256;
+    options.mFreeListSize = 512;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    const size_t kJobs = 200;
+    volatile size_t ran = 0;
+    static xr::Scheduling::JobHandle handles[kJobs];
+    xr::Scheduling::JobHandleBlocked producer = p->InsertBlocked([] () {});
+    for(size_t i = 0; i < kJobs; ++i)
+    {
+        handles[i] = producer.Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    }
+    producer.ReleaseBarrier();
+    p->WhenAll(handles, kJobs).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, kJobs);
+
+    xr::Scheduling::IManager::Stats stats;
+    xr::Scheduling::IManager::WorkerStats workers[8];
+    XR_ASSERT_ALWAYS_EQ(p->GetStats(&stats, workers, 8), options.mNumThreads);
+    XR_ASSERT_ALWAYS_EQ(stats.mWorkerCount, options.mNumThreads);
+    XR_ASSERT_ALWAYS_GT(stats.mSuccessorChunks, 0);
+    // No blocking jobs, no blocking threads.
+    XR_ASSERT_ALWAYS_EQ(stats.mBlockingThreadsHighWater, 0);
+    XR_ASSERT_ALWAYS_LE(stats.mFreeListLowWater, options.mFreeListSize);
+
+    uint64_t jobsRun = 0;
+    for(size_t i = 0; i < options.mNumThreads; ++i)
+    {
+        jobsRun += workers[i].mJobsRun;
+        XR_ASSERT_ALWAYS_LE(workers[i].mDequeHighWater, options.mReadyListSize);
+    }
+    // The producer, the consumers and the WhenAll instance. A worker counts
+    // a job once it returns, which can be just after WaitOn did.
+    XR_ASSERT_ALWAYS_LE(jobsRun, kJobs + 2);
+    XR_ASSERT_ALWAYS_GE(jobsRun, kJobs + 2 - options.mNumThreads);
+
+    // A null stats pointer just reports the worker count.
+    XR_ASSERT_ALWAYS_EQ(p->GetStats(nullptr, nullptr, 0), options.mNumThreads);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Small jobs trickling in are picked up by spinning workers, with
+    spinning off every worker parks. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Spinning )
+{
+    for(size_t spin = 0; spin < 2; ++spin)
+    {
+        xr::Scheduling::IManager::InitializeOptions options;
+        options.mNumThreads = 2;
+        options.mReadyListSize = 64;
+        options.mFreeListSize = 64;
+        options.mSpinMicroSeconds = spin != 0 ? 1000 : 0;
+        options.mYieldCount = spin != 0 ? 16 : 0;
+        xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+        volatile size_t ran = 0;
+        for(size_t i = 0; i < 200; ++i)
+        {
+            p->InsertReady([&ran] () { xr::Core::AtomicIncrement(&ran); }).WaitOn();
+        }
+        XR_ASSERT_ALWAYS_EQ(ran, 200);
+
+        xr::Scheduling::IManager::WorkerStats workers[2];
+        p->GetStats(nullptr, workers, 2);
+        const uint64_t spinHits = workers[0].mSpinHits + workers[1].mSpinHits;
+        if(spin != 0)
+        {
+            XR_ASSERT_ALWAYS_GT(spinHits, 0);
+        }
+        else
+        {
+            XR_ASSERT_ALWAYS_EQ(spinHits, 0);
+        }
+
+        xr::Scheduling::IManager::Shutdown(p);
+    }
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Collects WriteTrace output. a0 = buffer, a1 = capacity, a2 = length.
+// --------------------------------------------------------------------------------------  FUNCTION
+void TraceCollect(void * context, const char * text, size_t length)
+{
+    xr::Core::Arguments * a = (xr::Core::Arguments *)context;
+    char * buffer = (char *)a->a0;
+    for(size_t i = 0; i < length && a->a2 + 1 < a->a1; ++i)
+    {
+        buffer[a->a2++] = text[i];
+    }
+    buffer[a->a2] = '\0';
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Only jobs run while recording are traced, the rings wrap, and a chain
+    gets flow events. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Trace )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 64;
+    options.mTraceEventCount = 12; // Rounded up to 16
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    static char buffer[64 * 1024];
+    xr::Core::Arguments out((uintptr_t)buffer, sizeof(buffer), 0);
+
+    p->InsertReady([] () {}).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(p->WriteTrace(&TraceCollect, &out), 0);
+
+    p->SetTracing(true);
+    volatile size_t ran = 0;
+    xr::Scheduling::JobHandleBlocked root = p->InsertBlocked([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    xr::Scheduling::JobHandle h = root;
+    for(size_t i = 0; i < 3; ++i)
+    {
+        h = h.Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    }
+    root.ReleaseBarrier();
+    h.WaitOn();
+    p->SetTracing(false);
+    // The last job is counted once it returns, which may be after WaitOn.
+    for(;;)
+    {
+        out.a2 = 0;
+        if(p->WriteTrace(&TraceCollect, &out) == 4)
+        {
+            break;
+        }
+        xr::Core::Thread::YieldCurrentThread();
+    }
+    XR_ASSERT_ALWAYS_EQ(ran, 4);
+    XR_ASSERT_ALWAYS_NE(strstr(buffer, "\"traceEvents\""), nullptr);
+    XR_ASSERT_ALWAYS_NE(strstr(buffer, "\"ph\":\"X\""), nullptr);
+    XR_ASSERT_ALWAYS_NE(strstr(buffer, "\"ph\":\"s\""), nullptr);
+    XR_ASSERT_ALWAYS_NE(strstr(buffer, "\"ph\":\"f\""), nullptr);
+
+    // Only the last 16 per worker are kept.
+    p->SetTracing(true);
+    for(size_t i = 0; i < 100; ++i)
+    {
+        p->InsertReady([] () {}).WaitOn();
+    }
+    p->SetTracing(false);
+    out.a2 = 0;
+    XR_ASSERT_ALWAYS_LE(p->WriteTrace(&TraceCollect, &out), 2 * 16);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Counts backpressure callbacks, context is a uintptr_t per Backpressure.
+// --------------------------------------------------------------------------------------  FUNCTION
+void BackpressureCount(void * context, xr::Scheduling::IManager::Backpressure what)
+{
+    volatile uintptr_t * counts = (volatile uintptr_t *)context;
+    xr::Core::AtomicIncrement(&counts[what]);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! TryInsert fails instead of waiting on a full free list or ready list,
+    and the callback hears about both. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Backpressure )
+{
+    static volatile uintptr_t counts[2];
+    counts[0] = counts[1] = 0;
+
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 1;
+    options.mReadyListSize = 4;
+    options.mFreeListSize = 8;
+    options.mBackpressure = &BackpressureCount;
+    options.mBackpressureContext = (void *)counts;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    // Every instance held by a job that can not run yet.
+    xr::Scheduling::JobHandleBlocked held[8];
+    for(size_t i = 0; i < 8; ++i)
+    {
+        held[i] = p->InsertBlocked([] () {});
+    }
+    volatile size_t ran = 0;
+    XR_ASSERT_ALWAYS_EQ(p->TryInsertReady([&ran] () { xr::Core::AtomicIncrement(&ran); }).IsValid(), false);
+    xr::Scheduling::JobHandle antecedent = held[0];
+    XR_ASSERT_ALWAYS_EQ(p->TryInsertAfter([&ran] () { xr::Core::AtomicIncrement(&ran); }, &antecedent, 1).IsValid(), false);
+    XR_ASSERT_ALWAYS_GE(counts[xr::Scheduling::IManager::kBackpressureFreeList], 2);
+    for(size_t i = 0; i < 8; ++i)
+    {
+        held[i].ReleaseBarrier();
+        held[i].WaitOn();
+    }
+
+    // Keep the only worker busy, then fill the shared ready list.
+    volatile uintptr_t go = 0;
+    xr::Scheduling::JobHandle blocker = p->InsertReady([&go] () { while(go == 0) { xr::Core::Thread::YieldCurrentThread(); } });
+    while(p->GetReadyCount(xr::Scheduling::kPriorityNormal) != 0)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+    xr::Scheduling::JobHandle queued[5];
+    size_t accepted = 0;
+    for(size_t i = 0; i < 5; ++i)
+    {
+        queued[i] = p->TryInsertReady([&ran] () { xr::Core::AtomicIncrement(&ran); });
+        accepted += queued[i].IsValid() ? 1 : 0;
+    }
+    XR_ASSERT_ALWAYS_EQ(accepted, options.mReadyListSize);
+    XR_ASSERT_ALWAYS_EQ(queued[4].IsValid(), false);
+    XR_ASSERT_ALWAYS_GE(counts[xr::Scheduling::IManager::kBackpressureReadyList], 1);
+
+    // Nothing left to wait for, so these need the full ready list too.
+    bool didRun = false;
+    xr::Core::Arguments args((uintptr_t)&didRun);
+    xr::Scheduling::JobHandle complete = xr::Scheduling::IManager::GetCompletedHandle();
+    XR_ASSERT_ALWAYS_EQ(p->TryInsertAfter(&TestRunnable, &args, &complete, 1).IsValid(), false);
+    XR_ASSERT_ALWAYS_EQ(p->TryInsertAfter(&TestRunnable, &args, nullptr, 0).IsValid(), false);
+    XR_ASSERT_ALWAYS_EQ(p->TryInsertAfter([&ran] () { xr::Core::AtomicIncrement(&ran); }, &complete, 1).IsValid(), false);
+
+    go = 1;
+    blocker.WaitOn();
+    for(size_t i = 0; i < accepted; ++i)
+    {
+        queued[i].WaitOn();
+    }
+    // The rejected jobs never run.
+    XR_ASSERT_ALWAYS_EQ(ran, accepted);
+    XR_ASSERT_ALWAYS_EQ(didRun, false);
+
+    // With room they run, antecedents or not.
+    p->TryInsertAfter(&TestRunnable, &args, nullptr, 0).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(didRun, true);
+    didRun = false;
+    p->TryInsertAfter(&TestRunnable, &args, &complete, 1).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(didRun, true);
+    p->TryInsertAfter([&ran] () { xr::Core::AtomicIncrement(&ran); }, nullptr, 0).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, accepted + 1);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! With a grow size the pool grows instead of waiting, up to its limit. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( FreeListGrowth )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    options.mReadyListSize = 16;
+    options.mFreeListSize = 4;
+    options.mFreeListGrowSize = 4;
+    options.mFreeListMaxSize = 12;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    xr::Scheduling::JobHandleBlocked held[12];
+    for(size_t i = 0; i < 12; ++i)
+    {
+        held[i] = p->InsertBlocked([] () {});
+    }
+    xr::Scheduling::IManager::Stats stats;
+    p->GetStats(&stats, nullptr, 0);
+    XR_ASSERT_ALWAYS_EQ(stats.mFreeListSize, 12);
+    XR_ASSERT_ALWAYS_EQ(p->TryInsertReady([] () {}).IsValid(), false);
+
+    for(size_t i = 0; i < 12; ++i)
+    {
+        held[i].ReleaseBarrier();
+        held[i].WaitOn();
+    }
+    // Grown instances are recycled like any other.
+    volatile size_t ran = 0;
+    for(size_t i = 0; i < 100; ++i)
+    {
+        p->InsertReady([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    }
+    while(ran != 100)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Cancelled jobs skip their runnable but complete, successors run or are
+    cancelled per policy, and a token cancels everything under its scope. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Cancel )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 64;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    volatile size_t ran = 0;
+    xr::Scheduling::JobHandleBlocked root = p->InsertBlocked([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    xr::Scheduling::JobHandle next = root.Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    XR_ASSERT_ALWAYS_EQ(root.Cancel(), true);
+    root.ReleaseBarrier();
+    next.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, 1);
+    XR_ASSERT_ALWAYS_EQ(root.Cancel(), false);
+
+    // Transitively.
+    ran = 0;
+    root = p->InsertBlocked([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    next = root.Then([&ran] () { xr::Core::AtomicIncrement(&ran); }).Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    XR_ASSERT_ALWAYS_EQ(root.Cancel(xr::Scheduling::kCancelSuccessors), true);
+    root.ReleaseBarrier();
+    next.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, 0);
+
+    // A token reaches jobs inserted under its scope, and the jobs they insert.
+    xr::Scheduling::CancellationToken token;
+    xr::Scheduling::JobHandleBlocked gate = p->InsertBlocked([] () {});
+    xr::Scheduling::JobHandle group[8];
+    xr::Scheduling::JobHandleBlocked child;
+    {
+        xr::Scheduling::CancellationScope scope(&token);
+        for(size_t i = 0; i < 8; ++i)
+        {
+            group[i] = gate.Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+        }
+        p->InsertReady([p, &child, &ran] () { child = p->InsertBlocked([&ran] () { xr::Core::AtomicIncrement(&ran); }); }).WaitOn();
+    }
+    xr::Scheduling::JobHandle outside = gate.Then([&ran] () { xr::Core::AtomicIncrement(&ran); });
+    token.Cancel();
+    gate.ReleaseBarrier();
+    child.ReleaseBarrier();
+    p->WhenAll(group, 8).WaitOn();
+    child.WaitOn();
+    outside.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, 1);
+
+    xr::Scheduling::IManager::WorkerStats workers[2];
+    p->GetStats(nullptr, workers, 2);
+    XR_ASSERT_ALWAYS_EQ(workers[0].mJobsCancelled + workers[1].mJobsCancelled, 1 + 3 + 8 + 1);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Delayed jobs never start early, run in deadline order whatever the
+    insert order (including past the first wheel level), and can be
+    cancelled while they wait, which completes them right away. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Delayed )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 64;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    xr::Core::TimeStamp start = xr::Core::GetTimeStamp();
+    xr::Core::TimeStamp ranAt = 0;
+    p->InsertDelayed(5000, [&ranAt] () { ranAt = xr::Core::GetTimeStamp(); }).WaitOn();
+    XR_ASSERT_ALWAYS_GE(xr::Core::TimeStampToMicroSeconds(ranAt - start), 5000);
+
+    volatile size_t order[3] = { 0, 0, 0 };
+    volatile size_t count = 0;
+    xr::Scheduling::JobHandle handles[3];
+    handles[0] = p->InsertDelayed(30000, [&order, &count] () { order[xr::Core::AtomicIncrement(&count)] = 3; });
+    handles[1] = p->InsertDelayed(10000, [&order, &count] () { order[xr::Core::AtomicIncrement(&count)] = 1; });
+    handles[2] = p->InsertDelayed(20000, [&order, &count] () { order[xr::Core::AtomicIncrement(&count)] = 2; });
+    p->WhenAll(handles, 3).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(order[0], 1);
+    XR_ASSERT_ALWAYS_EQ(order[1], 2);
+    XR_ASSERT_ALWAYS_EQ(order[2], 3);
+
+    volatile size_t ran = 0;
+    xr::Scheduling::JobHandle cancelled = p->InsertDelayed(2000, [&ran] () { xr::Core::AtomicIncrement(&ran); });
+    XR_ASSERT_ALWAYS_EQ(cancelled.Cancel(), true);
+    cancelled.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, 0);
+
+    // Cancelling does not wait out the delay, an hour is released at once.
+    start = xr::Core::GetTimeStamp();
+    xr::Scheduling::JobHandle hour = p->InsertDelayed(uint64_t(3600) * 1000000, [&ran] () { xr::Core::AtomicIncrement(&ran); });
+    XR_ASSERT_ALWAYS_EQ(hour.Cancel(), true);
+    hour.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ran, 0);
+    XR_ASSERT_ALWAYS_LT(xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start), 1000000);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Periodic jobs keep running until cancelled, and not after. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Periodic )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 64;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    volatile size_t ran = 0;
+    xr::Scheduling::PeriodicHandle h = p->InsertPeriodic(1000, [&ran] () { xr::Core::AtomicIncrement(&ran); });
+    XR_ASSERT_ALWAYS_EQ(h.IsValid(), true);
+    while(ran < 5)
+    {
+        xr::Core::Thread::YieldCurrentThread(1);
+    }
+    XR_ASSERT_ALWAYS_EQ(p->CancelPeriodic(h), true);
+    // One run may have been queued already.
+    const size_t stopped = ran;
+    xr::Core::Thread::YieldCurrentThread(20);
+    XR_ASSERT_ALWAYS_LE(ran, stopped + 1);
+    XR_ASSERT_ALWAYS_EQ(p->CancelPeriodic(h), false);
+
+    // Left running, Shutdown cleans it up.
+    p->InsertPeriodic(500, [] () {});
+    xr::Core::Thread::YieldCurrentThread(5);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Blocking jobs get their own threads (the single worker stays free
+    while they all block), depend on and are depended on by compute jobs,
+    and the pool shrinks back once idle. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Blocking )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 1;
+    options.mReadyListSize = 64;
+    options.mFreeListSize = 64;
+    options.mBlockingThreads = 1;
+    options.mMaxBlockingThreads = 8;
+    options.mBlockingIdleMicroSeconds = 2000;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    volatile size_t released = 0;
+    volatile size_t ran = 0;
+    xr::Scheduling::JobHandle io[4];
+    for(size_t i = 0; i < 4; ++i)
+    {
+        io[i] = p->InsertBlocking([&released, &ran] ()
+        {
+            while(released == 0)
+            {
+                xr::Core::Thread::YieldCurrentThread(1);
+            }
+            xr::Core::AtomicIncrement(&ran);
+        });
+    }
+    xr::Scheduling::JobHandle after = p->InsertAfter([&ran] () { XR_ASSERT_ALWAYS_EQ(ran, 4); }, io, 4);
+    // Only runs if the worker is not stuck behind the blocking jobs.
+    p->InsertReady([&released] () { released = 1; }).WaitOn();
+    after.WaitOn();
+
+    xr::Scheduling::IManager::Stats stats;
+    p->GetStats(&stats, nullptr, 0);
+    XR_ASSERT_ALWAYS_GE(stats.mBlockingThreadsHighWater, 4);
+    XR_ASSERT_ALWAYS_EQ(stats.mBlockingJobsRun, 4);
+
+    // And the other way around.
+    volatile size_t step = 0;
+    xr::Scheduling::JobHandle compute = p->InsertReady([&step] () { xr::Core::Thread::YieldCurrentThread(2); step = 1; });
+    p->InsertBlocking([&step] () { XR_ASSERT_ALWAYS_EQ(step, 1); step = 2; }, &compute, 1).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(step, 2);
+
+    for(size_t i = 0; i < 2000 && stats.mBlockingThreads > 1; ++i)
+    {
+        xr::Core::Thread::YieldCurrentThread(1);
+        p->GetStats(&stats, nullptr, 0);
+    }
+    XR_ASSERT_ALWAYS_EQ(stats.mBlockingThreads, 1);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! A waits on a gate, B on A, both on the single worker. Helping in WaitOn
+    would run B on top of A's stack and never get back to A, fibers let
+    both switch out. Then lots of fiber jobs waiting on their children,
+    more than there are fibers. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Fiber )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 1;
+    options.mReadyListSize = 256;
+    options.mFreeListSize = 256;
+    options.mFiberCount = 4;
+    options.mFiberStackSize = 32 * 1024;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    xr::Scheduling::JobHandleBlocked gate = p->InsertBlocked((xr::Core::Runnable)nullptr, nullptr, xr::Scheduling::kPriorityHigh);
+    volatile size_t aDone = 0;
+    volatile size_t bStarted = 0;
+    xr::Scheduling::JobHandle a = p->InsertFiber([&gate, &aDone] ()
+    {
+        gate.WaitOn();
+        aDone = 1;
+    });
+    xr::Scheduling::JobHandle b = p->InsertFiber([&a, &aDone, &bStarted] ()
+    {
+        bStarted = 1;
+        a.WaitOn();
+        XR_ASSERT_ALWAYS_EQ(aDone, 1);
+    });
+    while(bStarted == 0)
+    {
+        xr::Core::Thread::YieldCurrentThread(1);
+    }
+    gate.ReleaseBarrier();
+    b.WaitOn();
+    XR_ASSERT_ALWAYS_EQ(aDone, 1);
+
+    xr::Scheduling::IManager::Stats stats;
+    xr::Scheduling::IManager::WorkerStats worker;
+    p->GetStats(&stats, &worker, 1);
+    XR_ASSERT_ALWAYS_GE(worker.mFiberWaits, 2);
+    XR_ASSERT_ALWAYS_EQ(stats.mFibersExhausted, 0);
+    xr::Scheduling::IManager::Shutdown(p);
+
+    options.mNumThreads = 4;
+    options.mFreeListSize = 1024;
+    p = xr::Scheduling::IManager::Initialize(&options);
+
+    const size_t kJobs = 200;
+    static volatile size_t results[kJobs];
+    xr::Scheduling::JobHandle jobs[kJobs];
+    for(size_t i = 0; i < kJobs; ++i)
+    {
+        results[i] = 0;
+        jobs[i] = p->InsertFiber([p, i] ()
+        {
+            volatile size_t left = 0;
+            volatile size_t right = 0;
+            xr::Scheduling::JobHandle children[2];
+            children[0] = p->InsertReady([&left, i] () { left = i; });
+            children[1] = p->InsertReady([&right] () { xr::Core::Thread::YieldCurrentThread(); right = 1; });
+            children[0].WaitOn();
+            children[1].WaitOn();
+            results[i] = left + right;
+        });
+    }
+    p->WhenAll(jobs, kJobs).WaitOn();
+    for(size_t i = 0; i < kJobs; ++i)
+    {
+        XR_ASSERT_ALWAYS_EQ(results[i], i + 1);
+    }
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Scratch is rewound after every job and by nested scopes, survives jobs
+    run while helping in WaitOn and (in a fiber job) a switch out. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Scratch )
+{
+    XR_ASSERT_ALWAYS_EQ(xr::Scheduling::GetJobScratch(), (xr::Core::LinearAllocator *)nullptr);
+
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 1;
+    options.mFiberCount = 2;
+    options.mJobScratchSize = 4096;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    void * volatile first = nullptr;
+    p->InsertReady([&first] ()
+    {
+        xr::Core::LinearAllocator * scratch = xr::Scheduling::GetJobScratch();
+        XR_ASSERT_ALWAYS_NE(scratch, (xr::Core::LinearAllocator *)nullptr);
+        first = scratch->Alloc(64);
+        {
+            xr::Core::LinearAllocatorScope scope(scratch);
+            scratch->Alloc(128);
+            // Past the first bucket.
+            XR_ASSERT_ALWAYS_NE(scratch->Alloc(16 * 1024), (void *)nullptr);
+        }
+        XR_ASSERT_ALWAYS_EQ(scratch->Alloc(128), (uint8_t *)first + 64);
+    }).WaitOn();
+
+    volatile size_t ok = 0;
+    p->InsertReady([p, &first, &ok] ()
+    {
+        // The last job's allocations are gone.
+        uint8_t * mine = (uint8_t *)xr::Scheduling::GetJobScratch()->Alloc(64);
+        XR_ASSERT_ALWAYS_EQ((void *)mine, first);
+        xr::Core::MemFill8(mine, 0x5a, 64);
+
+        // Run inline while we wait, above our allocation.
+        xr::Scheduling::JobHandle child = p->InsertReady([] ()
+        {
+            xr::Core::MemFill8(xr::Scheduling::GetJobScratch()->Alloc(64), 0xa5, 64);
+        });
+        child.WaitOn();
+        ok = xr::Core::MemCheck8(mine, 0x5a, 64) == xr::Core::kSuccess ? 1 : 0;
+    }).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ok, 1);
+
+    ok = 0;
+    p->InsertFiber([p, &first, &ok] ()
+    {
+        uint8_t * mine = (uint8_t *)xr::Scheduling::GetJobScratch()->Alloc(64);
+        XR_ASSERT_ALWAYS_NE((void *)mine, first);
+        xr::Core::MemFill8(mine, 0x5a, 64);
+
+        // Switches out, the worker runs the child from its own scratch.
+        xr::Scheduling::JobHandle child = p->InsertReady([&first] ()
+        {
+            void * theirs = xr::Scheduling::GetJobScratch()->Alloc(64);
+            XR_ASSERT_ALWAYS_EQ(theirs, first);
+            xr::Core::MemFill8(theirs, 0xa5, 64);
+        });
+        child.WaitOn();
+        ok = xr::Core::MemCheck8(mine, 0x5a, 64) == xr::Core::kSuccess ? 1 : 0;
+    }).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(ok, 1);
+
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Counts resizes reported through InitializeOptions::mResize. */
+// --------------------------------------------------------------------------------------  FUNCTION
+static void CountResize(void * context, size_t, bool grew)
+{
+    volatile uintptr_t * counts = (volatile uintptr_t *)context;
+    xr::Core::AtomicIncrement(&counts[grew ? 0 : 1]);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Grows while the only worker is held up and jobs keep queueing, shrinks
+    back once idle, then grows again (reviving the retired worker). */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Elastic )
+{
+    volatile uintptr_t resizes[2] = { 0, 0 };
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 1;
+    options.mMaxThreads = 3;
+    options.mGrowLatencyMicroSeconds = 1000;
+    options.mRetireIdleMicroSeconds = 20000;
+    options.mResize = &CountResize;
+    options.mResizeContext = (void *)resizes;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    xr::Scheduling::IManager::Stats stats;
+    for(size_t round = 0; round < 2; ++round)
+    {
+        volatile size_t hold = 1;
+        xr::Scheduling::JobHandle held = p->InsertReady([&hold] ()
+        {
+            while(hold != 0)
+            {
+                xr::Core::Thread::YieldCurrentThread();
+            }
+        });
+
+        // Keep queueing until someone is added to run it.
+        volatile size_t ran = 0;
+        const xr::Core::TimeStamp start = xr::Core::GetTimeStamp();
+        do
+        {
+            p->InsertReady([&ran] () { xr::Core::AtomicIncrement(&ran); });
+            xr::Core::Thread::YieldCurrentThread(1);
+            p->GetStats(&stats, nullptr, 0);
+        } while(stats.mActiveWorkers < 2 && xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start) < 5000000);
+        XR_ASSERT_ALWAYS_GE(stats.mActiveWorkers, 2);
+        XR_ASSERT_ALWAYS_EQ(stats.mWorkerCount, 3);
+        while(ran == 0)
+        {
+            xr::Core::Thread::YieldCurrentThread(1);
+        }
+
+        hold = 0;
+        held.WaitOn();
+
+        // Back down to mNumThreads once idle.
+        const xr::Core::TimeStamp idle = xr::Core::GetTimeStamp();
+        do
+        {
+            xr::Core::Thread::YieldCurrentThread(5);
+            p->GetStats(&stats, nullptr, 0);
+        } while(stats.mActiveWorkers > 1 && xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - idle) < 5000000);
+        XR_ASSERT_ALWAYS_EQ(stats.mActiveWorkers, 1);
+    }
+
+    XR_ASSERT_ALWAYS_GE(stats.mWorkersAdded, 2);
+    XR_ASSERT_ALWAYS_EQ(stats.mWorkersAdded, stats.mWorkersRetired);
+    XR_ASSERT_ALWAYS_GE(stats.mActiveWorkersHighWater, 2);
+    XR_ASSERT_ALWAYS_EQ(resizes[0], stats.mWorkersAdded);
+    XR_ASSERT_ALWAYS_EQ(resizes[1], stats.mWorkersRetired);
+
+    // Still works with the retired workers asleep.
+    volatile size_t after = 0;
+    p->InsertReady([&after] () { after = 1; }).WaitOn();
+    XR_ASSERT_ALWAYS_EQ(after, 1);
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Stands in for real work, busy for \a microSeconds. */
+// --------------------------------------------------------------------------------------  FUNCTION
+static void Busy(int64_t microSeconds)
+{
+    const xr::Core::TimeStamp start = xr::Core::GetTimeStamp();
+    while(xr::Core::TimeStampToMicroSeconds(xr::Core::GetTimeStamp() - start) < microSeconds)
+    {
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Groups )
+{
+    xr::Scheduling::IManager::InitializeOptions options;
+    options.mNumThreads = 1;
+    xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+    xr::Scheduling::JobGroup heavy = p->CreateGroup("heavy", 3);
+    xr::Scheduling::JobGroup light = p->CreateGroup("light", 1, 1);
+    XR_ASSERT_ALWAYS_TRUE(heavy.IsValid());
+    XR_ASSERT_ALWAYS_TRUE(light.IsValid());
+
+    // Queue both groups up behind a held worker, then see who runs first.
+    volatile size_t hold = 2;
+    xr::Scheduling::JobHandle held = p->InsertReady([&hold] ()
+    {
+        hold = 1;
+        while(hold != 0)
+        {
+            xr::Core::Thread::YieldCurrentThread();
+        }
+    });
+    while(hold != 1)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+
+    static const size_t kJobs = 100;
+    char order[2 * kJobs];
+    volatile uintptr_t done = 0;
+    xr::Scheduling::JobHandle last[2];
+    for(size_t i = 0; i < kJobs; ++i)
+    {
+        {
+            xr::Scheduling::JobGroupScope scope(heavy);
+            last[0] = p->InsertReady([&order, &done] () { Busy(20); order[xr::Core::AtomicIncrement(&done)] = 'h'; });
+        }
+        xr::Scheduling::JobGroupScope scope(light);
+        last[1] = p->InsertReady([&order, &done] () { Busy(20); order[xr::Core::AtomicIncrement(&done)] = 'l'; });
+    }
+    xr::Scheduling::IManager::GroupStats stats;
+    XR_ASSERT_ALWAYS_TRUE(p->GetGroupStats(heavy, &stats));
+    XR_ASSERT_ALWAYS_EQ(stats.mQueued, kJobs);
+    XR_ASSERT_ALWAYS_EQ(p->GetReadyCount(xr::Scheduling::kPriorityNormal), 2 * kJobs);
+
+    hold = 0;
+    held.WaitOn();
+    last[0].WaitOn();
+    last[1].WaitOn();
+    while(done != 2 * kJobs)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+
+    // About three heavy jobs per light one while both have work.
+    size_t heavyFirst = 0;
+    for(size_t i = 0; i < kJobs; ++i)
+    {
+        heavyFirst += order[i] == 'h' ? 1 : 0;
+    }
+    XR_ASSERT_ALWAYS_GE(heavyFirst, 60);
+    XR_ASSERT_ALWAYS_LE(heavyFirst, 90);
+
+    // Counted once the worker is done with the job, after it completes.
+    do
+    {
+        xr::Core::Thread::YieldCurrentThread(1);
+        XR_ASSERT_ALWAYS_TRUE(p->GetGroupStats(light, &stats));
+    } while(stats.mJobsRun != kJobs);
+    XR_ASSERT_ALWAYS_EQ(strcmp(stats.mName, "light"), 0);
+    XR_ASSERT_ALWAYS_EQ(stats.mWeight, 1);
+    XR_ASSERT_ALWAYS_EQ(stats.mQueued, 0);
+    XR_ASSERT_ALWAYS_GE(stats.mRunMicroSeconds, kJobs * 20);
+    xr::Scheduling::IManager::Shutdown(p);
+
+    // More workers: the cap holds, children join their parent's group, and
+    // a job may wait on its own group's jobs despite the cap.
+    options.mNumThreads = 4;
+    p = xr::Scheduling::IManager::Initialize(&options);
+    light = p->CreateGroup("light", 1, 1);
+    volatile uintptr_t running = 0;
+    volatile uintptr_t mostRunning = 0;
+    {
+        xr::Scheduling::JobGroupScope scope(light);
+        for(size_t i = 0; i < 20; ++i)
+        {
+            last[0] = p->InsertReady([p, &running, &mostRunning] ()
+            {
+                const uintptr_t now = xr::Core::AtomicIncrement(&running) + 1;
+                mostRunning = now > mostRunning ? now : mostRunning;
+                Busy(50);
+                xr::Core::AtomicDecrement(&running);
+                p->InsertReady([] () { Busy(10); }).WaitOn();
+            });
+        }
+    }
+    for(size_t i = 0; i < 20; ++i)
+    {
+        p->InsertReady([] () { Busy(10); });
+    }
+    last[0].WaitOn();
+    XR_ASSERT_ALWAYS_EQ(mostRunning, 1);
+    do
+    {
+        xr::Core::Thread::YieldCurrentThread(1);
+        XR_ASSERT_ALWAYS_TRUE(p->GetGroupStats(light, &stats));
+    } while(stats.mJobsRun != 40);
+    XR_ASSERT_ALWAYS_EQ(stats.mRunningHighWater, 1);
+
+    // Only so many groups.
+    for(size_t i = 1; i < xr::Scheduling::IManager::kMaxGroups; ++i)
+    {
+        XR_ASSERT_ALWAYS_TRUE(p->CreateGroup("more").IsValid());
+    }
+    XR_ASSERT_ALWAYS_FALSE(p->CreateGroup("too many").IsValid());
+    xr::Scheduling::IManager::Shutdown(p);
+}
+
+#if defined(XR_BENCHMARK_FEATURES_ENABLED)
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Per-job cost of the instance life cycle: empty jobs inserted from
+    several jobs at once (allocation, XID, queueing and completion) and a
+    chain of continuations (adding and notifying successors). Prints the
+    best of three rounds in ns per job, only completion is asserted. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( InstanceOverhead )
+{
+    const size_t kJobs = 1 << 16;
+    const size_t kRoots = 8;
+    static xr::Scheduling::JobHandle handles[kJobs];
+
+    const size_t threads[] = { 1, 4 };
+    for(size_t t = 0; t < XR_ARRAY_SIZE(threads); ++t)
+    {
+        xr::Scheduling::IManager::InitializeOptions options;
+        options.mNumThreads = threads[t];
+        options.mReadyListSize = kJobs;
+        options.mFreeListSize = kJobs + 64;
+        xr::Scheduling::IManager * p = xr::Scheduling::IManager::Initialize(&options);
+
+        double spawn = 1.0e30;
+        double chain = 1.0e30;
+        for(size_t round = 0; round < 3; ++round)
+        {
+            xr::Core::TimeStamp start = xr::Core::GetTimeStamp();
+            xr::Scheduling::JobHandle roots[kRoots];
+            for(size_t r = 0; r < kRoots; ++r)
+            {
+                roots[r] = p->InsertReady([p, r] () {
+                    for(size_t i = r; i < kJobs; i += kRoots)
+                    {
+                        handles[i] = p->InsertReady([] () {});
+                    }
+                });
+            }
+            for(size_t r = 0; r < kRoots; ++r)
+            {
+                roots[r].WaitOn();
+            }
+            for(size_t i = 0; i < kJobs; ++i)
+            {
+                handles[i].WaitOn();
+            }
+            double seconds = xr::Core::TimeStampToSeconds(xr::Core::GetTimeStamp() - start);
+            spawn = seconds < spawn ? seconds : spawn;
+
+            start = xr::Core::GetTimeStamp();
+            volatile size_t step = 0;
+            xr::Scheduling::JobHandle h = p->InsertReady([] () {});
+            for(size_t i = 1; i < kJobs; ++i)
+            {
+                h = h.Then([&step] () { step = step + 1; });
+            }
+            h.WaitOn();
+            XR_ASSERT_ALWAYS_EQ(step, kJobs - 1);
+            seconds = xr::Core::TimeStampToSeconds(xr::Core::GetTimeStamp() - start);
+            chain = seconds < chain ? seconds : chain;
+        }
+
+        xr::Core::ConsolePrintf(xr::Core::kConsoleStdOut, "%s%u threads: spawn %.1fns/job, chain %.1fns/job" XR_EOL,
+            t == 0 ? XR_EOL : "", (unsigned int)threads[t], spawn * 1.0e9 / kJobs, chain * 1.0e9 / kJobs);
+
+        xr::Scheduling::IManager::Shutdown(p);
+    }
+}
+#endif // #if defined(XR_BENCHMARK_FEATURES_ENABLED)
+
 XR_UNITTEST_GROUP_END()
 
 #endif // #if defined(XR_TEST_FEATURES_ENABLED)
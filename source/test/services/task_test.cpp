@@ -0,0 +1,121 @@
+// ######################################################################################### - FILE
+/*!
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#include "xr/defines.h"
+#endif
+#ifndef XR_SERVICES_TASK_H
+#include "xr/services/task.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_TEST_H
+#include "xr/core/test.h"
+#endif
+#ifndef XR_CORE_THREADING_ATOMIC_H
+#include "xr/core/threading/atomic.h"
+#endif
+// ######################################################################################### - FILE
+/* Unit Tests                                                                */
+// ######################################################################################### - FILE
+#if defined(XR_TEST_FEATURES_ENABLED) && XR_SCHEDULING_TASK_ENABLED
+
+// ######################################################################################### - FILE
+// ######################################################################################### - FILE
+XR_UNITTEST_GROUP_BEGIN( Task )
+
+using xr::Scheduling::IManager;
+using xr::Scheduling::JobHandle;
+using xr::Scheduling::Task;
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Moves onto a worker before adding, the caller must be suspended by then. */
+// --------------------------------------------------------------------------------------  FUNCTION
+Task<size_t> Add(IManager * manager, size_t a, size_t b)
+{
+    co_await xr::Scheduling::Schedule(manager);
+    XR_ASSERT_ALWAYS_EQ(IManager::GetCurrent(), manager);
+    co_return a + b;
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Hops to the blocking pool and back. */
+// --------------------------------------------------------------------------------------  FUNCTION
+Task<void> Blocking(IManager * manager, volatile size_t * out)
+{
+    co_await xr::Scheduling::ScheduleBlocking(manager);
+    XR_ASSERT_ALWAYS_EQ(IManager::GetCurrent(), (IManager *)nullptr);
+    *out = 7;
+    co_await xr::Scheduling::Schedule(manager);
+    XR_ASSERT_ALWAYS_EQ(IManager::GetCurrent(), manager);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Started from a worker, so it takes the scheduler from GetCurrent. */
+// --------------------------------------------------------------------------------------  FUNCTION
+Task<size_t> Chain(volatile size_t * sum)
+{
+    IManager * manager = IManager::GetCurrent();
+
+    JobHandle h = manager->InsertReady([sum] () { xr::Core::AtomicAdd(sum, size_t(100)); });
+    co_await h;
+    XR_ASSERT_ALWAYS_EQ(*sum, 100);
+
+    size_t total = co_await Add(manager, 1, 2);
+
+    volatile size_t seven = 0;
+    co_await Blocking(manager, &seven);
+    co_return total + *sum + seven;
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! co_await on jobs and tasks, results returned through the Task. */
+// --------------------------------------------------------------------------------------  FUNCTION
+XR_UNITTEST_TEST_FUNC( Await )
+{
+    IManager::InitializeOptions options;
+    options.mNumThreads = 2;
+    IManager * p = IManager::Initialize(&options);
+
+    {
+        Task<size_t> t = Add(p, 20, 22);
+        XR_ASSERT_ALWAYS_EQ(t.Get(), 42);
+    }
+
+    for(size_t i = 0; i < 100; ++i)
+    {
+        volatile size_t sum = 0;
+        volatile size_t result = 0;
+        JobHandle h = p->InsertReady([&sum, &result] ()
+        {
+            Task<size_t> t = Chain(&sum);
+            result = t.Get();
+        });
+        h.WaitOn();
+        XR_ASSERT_ALWAYS_EQ(result, 110);
+    }
+
+    // An ordinary job after a task.
+    {
+        volatile size_t order = 0;
+        Task<size_t> t = Add(p, 1, 1);
+        JobHandle done = t.GetHandle();
+        JobHandle after = p->InsertAfter([&order, &t] () { order = t.IsDone() ? 1 : 2; }, &done, 1);
+        after.WaitOn();
+        XR_ASSERT_ALWAYS_EQ(order, 1);
+    }
+
+    IManager::Shutdown(p);
+}
+
+XR_UNITTEST_GROUP_END()
+
+#endif // #if defined(XR_TEST_FEATURES_ENABLED) && XR_SCHEDULING_TASK_ENABLED
@@ -0,0 +1,317 @@
+// ######################################################################################### - FILE
+/*!
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#include "xr/defines.h"
+#endif
+#ifndef XR_CORE_THREADING_FIBER_H
+#include "xr/core/threading/fiber.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
+
+#if defined(XR_PLATFORM_WINDOWS)
+XR_DISABLE_ALL_WARNINGS()
+#include <windows.h>
+XR_RESTORE_ALL_WARNINGS()
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// ######################################################################################### - FILE
+/* Private Macros */
+// ######################################################################################### - FILE
+// Switch with a few instructions of our own where we have them: swapcontext
+// also saves and restores the signal mask, a system call every switch.
+#if !defined(XR_PLATFORM_WINDOWS) && defined(XR_PLATFORM_LINUX) && defined(XR_CPU_X64) && defined(XR_COMPILER_GCC)
+#define XR_FIBER_ASM_SWITCH 1
+#endif
+
+#if !defined(XR_PLATFORM_WINDOWS) && !defined(XR_FIBER_ASM_SWITCH)
+// Deprecated by POSIX but still the only portable way to switch stacks.
+#include <ucontext.h>
+#endif
+
+
+// ######################################################################################### - FILE
+/* Implementation */
+// ######################################################################################### - FILE
+namespace xr { namespace Core {
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+Fiber::Fiber() : mContext(nullptr), mStack(nullptr), mStackSize(0), mEntry(nullptr), mEntryContext(nullptr), mConverted(false)
+{
+}
+
+#if defined(XR_PLATFORM_WINDOWS)
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+Fiber::~Fiber()
+{
+    XR_ASSERT_DEBUG_FALSE_M(mConverted, "DetachFromThread was not called");
+    if(mContext != nullptr && mStackSize != 0)
+    {
+        DeleteFiber(mContext);
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void __stdcall Fiber::Start(void * fiber)
+{
+    Fiber * self = (Fiber *)fiber;
+    self->mEntry(self->mEntryContext);
+    XR_ALWAYS_UNEXPECTED_M("Fiber entry point returned");
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool Fiber::Create(EntryPoint entry, void * context, size_t stackSize)
+{
+    XR_ASSERT_DEBUG_EQ(mContext, (void *)nullptr);
+    mEntry        = entry;
+    mEntryContext = context;
+    mContext      = CreateFiber(stackSize, (LPFIBER_START_ROUTINE)&Fiber::Start, this);
+    mStackSize    = mContext != nullptr ? stackSize : 0;
+    return mContext != nullptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::AttachToThread()
+{
+    XR_ASSERT_DEBUG_EQ(mContext, (void *)nullptr);
+    if(IsThreadAFiber())
+    {
+        mContext = GetCurrentFiber();
+    }
+    else
+    {
+        mContext = ConvertThreadToFiber(nullptr);
+        mConverted = true;
+    }
+    XR_ASSERT_ALWAYS_NE(mContext, (void *)nullptr);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::DetachFromThread()
+{
+    if(mConverted)
+    {
+        ConvertFiberToThread();
+        mConverted = false;
+    }
+    mContext = nullptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::Switch(Fiber &, Fiber & to)
+{
+    // Windows keeps track of the running fiber itself.
+    SwitchToFiber(to.mContext);
+}
+#else
+#if defined(XR_FIBER_ASM_SWITCH)
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! Pushes the callee saved registers (and the SSE / x87 control words) on
+    the running stack, stores the stack pointer in *\a from, then pops the
+    same from \a to and returns to wherever it was switched away from.
+    A new fiber's stack is laid out by Create to return into
+    xr_core_fiber_entry, which calls the function in r13 with r12. */
+// --------------------------------------------------------------------------------------  FUNCTION
+extern "C" void xr_core_fiber_switch(void ** from, void * to);
+extern "C" void xr_core_fiber_entry();
+__asm__(
+    ".text\n"
+    ".globl xr_core_fiber_switch\n"
+    ".type xr_core_fiber_switch,@function\n"
+    ".align 16\n"
+    "xr_core_fiber_switch:\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $16, %rsp\n"
+    "    stmxcsr 8(%rsp)\n"
+    "    fnstcw 12(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr 8(%rsp)\n"
+    "    fldcw 12(%rsp)\n"
+    "    addq $16, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".size xr_core_fiber_switch,.-xr_core_fiber_switch\n"
+    ".globl xr_core_fiber_entry\n"
+    ".type xr_core_fiber_entry,@function\n"
+    ".align 16\n"
+    "xr_core_fiber_entry:\n"
+    "    movq %r12, %rdi\n"
+    // A null return address ends backtraces here.
+    "    pushq $0\n"
+    "    jmpq *%r13\n"
+    ".size xr_core_fiber_entry,.-xr_core_fiber_entry\n"
+);
+#endif
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Stacks are mapped with an inaccessible page below them, so running off
+/// the end faults instead of corrupting whatever is next in the heap.
+// --------------------------------------------------------------------------------------  FUNCTION
+static size_t GetGuardSize()
+{
+    return (size_t)sysconf(_SC_PAGESIZE);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+Fiber::~Fiber()
+{
+    if(mStack != nullptr)
+    {
+        const size_t guard = GetGuardSize();
+        munmap((uint8_t *)mStack - guard, mStackSize + guard);
+    }
+#if !defined(XR_FIBER_ASM_SWITCH)
+    if(mContext != nullptr)
+    {
+        XR_FREE(mContext);
+    }
+#endif
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::Start(void * fiber)
+{
+    Fiber * self = (Fiber *)fiber;
+    self->mEntry(self->mEntryContext);
+    XR_ALWAYS_UNEXPECTED_M("Fiber entry point returned");
+}
+#if !defined(XR_FIBER_ASM_SWITCH)
+// --------------------------------------------------------------------------------------  FUNCTION
+/// makecontext only passes int arguments, the Fiber pointer is split in two.
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::Start(unsigned int high, unsigned int low)
+{
+    Start((void *)(((uint64_t(high) << 16) << 16) | uint64_t(low)));
+}
+#endif
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool Fiber::Create(EntryPoint entry, void * context, size_t stackSize)
+{
+    XR_ASSERT_DEBUG_EQ(mContext, (void *)nullptr);
+    const size_t guard = GetGuardSize();
+    stackSize = (stackSize + guard - 1) & ~(guard - 1);
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_STACK)
+    flags |= MAP_STACK;
+#endif
+    void * mapping = mmap(nullptr, stackSize + guard, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if(mapping == MAP_FAILED)
+    {
+        return false;
+    }
+    // Stacks grow down, the guard is the lowest page.
+    if(mprotect(mapping, guard, PROT_NONE) != 0)
+    {
+        munmap(mapping, stackSize + guard);
+        return false;
+    }
+    mStack        = (uint8_t *)mapping + guard;
+    mStackSize    = stackSize;
+    mEntry        = entry;
+    mEntryContext = context;
+
+#if defined(XR_FIBER_ASM_SWITCH)
+    // What xr_core_fiber_switch pops, lowest address first: 16 bytes
+    // holding padding then mxcsr and the x87 control word, r15, r14,
+    // r13 (entry), r12 (argument), rbx, rbp and the return address. Start must see a called frame, rsp % 16 == 8 once
+    // xr_core_fiber_entry has pushed its null return address.
+    uintptr_t * top   = (uintptr_t *)((uint8_t *)mStack + mStackSize);
+    uintptr_t * frame = top - 11;
+    frame[0] = 0;
+    frame[1] = uintptr_t(0x037F) << 32 | 0x1F80;  // fpu control word | mxcsr (defaults)
+    frame[2] = 0;
+    frame[3] = 0;
+    frame[4] = (uintptr_t)(void (*)(void *))&Fiber::Start;
+    frame[5] = (uintptr_t)this;
+    frame[6] = 0;
+    frame[7] = 0;
+    frame[8] = (uintptr_t)&xr_core_fiber_entry;
+    frame[9] = 0;
+    frame[10] = 0;
+    mContext = frame;
+#else
+    ucontext_t * uc = (ucontext_t *)XR_ALLOC_ALIGN(sizeof(ucontext_t), "Fiber", 16);
+    if(getcontext(uc) != 0)
+    {
+        XR_FREE(uc);
+        munmap(mapping, stackSize + guard);
+        mStack     = nullptr;
+        mStackSize = 0;
+        return false;
+    }
+    uc->uc_stack.ss_sp   = mStack;
+    uc->uc_stack.ss_size = stackSize;
+    uc->uc_link          = nullptr;
+    const uint64_t self = uint64_t(uintptr_t(this));
+    makecontext(uc, (void (*)())(void (*)(unsigned int, unsigned int))&Fiber::Start, 2, (unsigned int)((self >> 16) >> 16), (unsigned int)self);
+    mContext = uc;
+#endif
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::AttachToThread()
+{
+    XR_ASSERT_DEBUG_EQ(mContext, (void *)nullptr);
+    // Filled in by the first Switch away from the thread.
+#if defined(XR_FIBER_ASM_SWITCH)
+    mContext = this;
+#else
+    mContext = XR_ALLOC_ALIGN(sizeof(ucontext_t), "Fiber", 16);
+#endif
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::DetachFromThread()
+{
+    XR_ASSERT_DEBUG_EQ(mStack, (void *)nullptr);
+#if !defined(XR_FIBER_ASM_SWITCH)
+    if(mContext != nullptr)
+    {
+        XR_FREE(mContext);
+    }
+#endif
+    mContext = nullptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void Fiber::Switch(Fiber & from, Fiber & to)
+{
+    XR_ASSERT_DEBUG_NE(&from, &to);
+#if defined(XR_FIBER_ASM_SWITCH)
+    xr_core_fiber_switch(&from.mContext, to.mContext);
+#else
+    swapcontext((ucontext_t *)from.mContext, (ucontext_t *)to.mContext);
+#endif
+}
+#endif
+
+}}//namespace xr::Core
@@ -271,6 +271,23 @@ size_t LinearAllocator::Clear()
     return totalBytes;
 }
 
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void LinearAllocator::Rollback(const Marker & marker)
+{
+    // Overflow buckets link back to the ones before them.
+    while(mCurrentBucket != marker.mBucket)
+    {
+        Bucket * b = mCurrentBucket;
+        XR_ASSERT_DEBUG_NE_M(b->mNextBucket, (Bucket *)nullptr, "Marker is not from this allocator, or was rolled back past");
+        mCurrentBucket = b->mNextBucket;
+        XR_FREE(b->mBase);
+    }
+    XR_ASSERT_DEBUG_LE(marker.mCurrent, mCurrentBucket->mCurrent);
+    mCurrentBucket->mCurrent = marker.mCurrent;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
 XR_RESTRICT_RETURN void * LinearAllocator::Expand( size_t allocSize, size_t allocAlign )
 {
 
@@ -32,6 +32,7 @@ XR_RESTORE_ALL_WARNINGS()
 #if defined(_POSIX_THREADS)
 #include <pthread.h>
 #include <errno.h>
+#include <time.h>
 #endif
 
 #endif
@@ -79,6 +80,20 @@ void Monitor::Wait(XR_IN xr::Core::Mutex & mutex) const
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
+bool Monitor::Wait(XR_IN xr::Core::Mutex & mutex, uint64_t microSeconds) const
+{
+    uint64_t milliSeconds = (microSeconds + 999) / 1000;
+    milliSeconds = milliSeconds < INFINITE ? milliSeconds : INFINITE - 1;
+    if (SleepConditionVariableSRW((CONDITION_VARIABLE*)&mCondition, mutex.UnderlyingSystemObject(), (DWORD)milliSeconds, 0) == FALSE)
+    {
+        uint32_t err = (uint32_t)GetLastError();
+        XR_ASSERT_ALWAYS_EQ_FM(err, ERROR_TIMEOUT, "SleepConditionVariableSRW Error 0x%8.8" XR_UINT32_PRINTX "!", err);
+        return false;
+    }
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
 void Monitor::Wait(XR_IN xr::Core::RecursiveMutex & mutex) const
 {
     if (SleepConditionVariableCS((CONDITION_VARIABLE*)&mCondition, mutex.UnderlyingSystemObject(), INFINITE) == FALSE)
@@ -117,8 +132,22 @@ inline void HandleErrno(int errvalue, const char * where)
 // --------------------------------------------------------------------------------------  FUNCTION
 Monitor::Monitor()
 {
+#if defined(XR_PLATFORM_DARWIN)
+    // No pthread_condattr_setclock, timed waits are relative instead.
     int err = pthread_cond_init(&mCondition, nullptr);
     HandleErrno(err, "pthread_cond_init");
+#else
+    // Timed waits measure on the monotonic clock, a wall clock step would
+    // otherwise stretch (or cut short) every wait in progress.
+    pthread_condattr_t attr;
+    int err = pthread_condattr_init(&attr);
+    HandleErrno(err, "pthread_condattr_init");
+    err = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    HandleErrno(err, "pthread_condattr_setclock");
+    err = pthread_cond_init(&mCondition, &attr);
+    HandleErrno(err, "pthread_cond_init");
+    pthread_condattr_destroy(&attr);
+#endif
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -136,6 +165,36 @@ void Monitor::Wait(xr::Core::Mutex & mutex) const
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
+bool Monitor::Wait(xr::Core::Mutex & mutex, uint64_t microSeconds) const
+{
+#if defined(XR_PLATFORM_DARWIN)
+    struct timespec timeout;
+    timeout.tv_sec  = time_t(microSeconds / 1000000);
+    timeout.tv_nsec = long((microSeconds % 1000000) * 1000);
+    int err = pthread_cond_timedwait_relative_np(&mCondition, mutex.UnderlyingSystemObject(), &timeout);
+#else
+    // Absolute, on the monotonic clock the condition was created with.
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec  += time_t(microSeconds / 1000000);
+    deadline.tv_nsec += long((microSeconds % 1000000) * 1000);
+    if(deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_nsec -= 1000000000;
+        deadline.tv_sec  += 1;
+    }
+
+    int err = pthread_cond_timedwait(&mCondition, mutex.UnderlyingSystemObject(), &deadline);
+#endif
+    if(err == ETIMEDOUT)
+    {
+        return false;
+    }
+    HandleErrno(err, "pthread_cond_timedwait");
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
 void Monitor::Signal() const
 {
     int err = pthread_cond_signal(&mCondition);
@@ -191,12 +191,13 @@ Mutex::~Mutex()
 bool Mutex::TryLock() const
 {
     int errval = pthread_mutex_trylock(&mSystemMutex);
-    HandleErrno(errval, "pthread_mutex_trylock");
-    if(errval == 0)
+    if(errval == EBUSY)
     {
-        return true;
+        // Held by another thread, the normal reason for failing.
+        return false;
     }
-    return false;
+    HandleErrno(errval, "pthread_mutex_trylock");
+    return errval == 0;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -56,10 +56,14 @@ public:
     ~QSProtector();
     /// Returns the number of entries available to insert
     size_t InsertionLock();
+    /// Returns the number of entries available to insert, 0 if full (lock is not held)
+    size_t TryInsertionLock();
     // Pass in the number of entries actually inserted
     void InsertionUnLock( size_t numInserted );
     /// Returns the number of entries that can be removed
     size_t RemovalLock( );
+    /// Returns the number of entries that can be removed, 0 if empty (lock is not held)
+    size_t TryRemovalLock( );
     /// pass in the number of entries actually removed
     void RemovalUnLock( size_t numRemoved );
     inline void Kick();
@@ -118,6 +122,21 @@ size_t QSProtector::InsertionLock()
 // --------------------------------------------------------------------------------------  FUNCTION
 /* */
 // --------------------------------------------------------------------------------------  FUNCTION
+size_t QSProtector::TryInsertionLock()
+{
+    mMutex.Lock();
+
+    if( mCurrentCount >= kMaxCount )
+    {
+        mMutex.Unlock();
+        return 0;
+    }
+
+    return kMaxCount - mCurrentCount;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/* */
+// --------------------------------------------------------------------------------------  FUNCTION
 void QSProtector::InsertionUnLock( size_t numPushd )
 {
     size_t temp = mCurrentCount;
@@ -158,6 +177,21 @@ size_t QSProtector::RemovalLock()
 // --------------------------------------------------------------------------------------  FUNCTION
 /* */
 // --------------------------------------------------------------------------------------  FUNCTION
+size_t QSProtector::TryRemovalLock()
+{
+    mMutex.Lock();
+
+    if( mCurrentCount == 0 )
+    {
+        mMutex.Unlock();
+        return 0;
+    }
+
+    return mCurrentCount;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/* */
+// --------------------------------------------------------------------------------------  FUNCTION
 void QSProtector::RemovalUnLock( size_t numPopped )
 {
     size_t temp = mCurrentCount;
@@ -228,6 +262,18 @@ size_t QSBase::RemovalLock( )
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
+size_t QSBase::TryRemovalLock( )
+{
+    return mProtector->TryRemovalLock();
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t QSBase::TryInsertionLock( )
+{
+    return mProtector->TryInsertionLock();
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
 void QSBase::RemovalUnLock( size_t numRemoved )
 {
     mProtector->RemovalUnLock(numRemoved);
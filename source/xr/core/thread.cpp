@@ -39,6 +39,12 @@ XR_RESTORE_ALL_WARNINGS()
 #include <sys/time.h>
 #endif
 #endif
+#include <unistd.h>
+#if defined(XR_PLATFORM_LINUX)
+#include <sched.h>
+#include <stdio.h>
+#include <dirent.h>
+#endif
 #endif
 
 #include "xr/core/threading/mutex.h"
@@ -241,6 +247,7 @@ Thread::Thread() : mMonitor()
 
     mExitCode   = 0;
     mHasRequestedQuit = false;
+    mAffinity   = kNoAffinity;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -254,6 +261,7 @@ Thread::Thread(const char * name): mMonitor()
     mHasExited2 = false;
     mExitCode   = 0;
     mHasRequestedQuit = false;
+    mAffinity   = kNoAffinity;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -340,6 +348,13 @@ uint32_t __stdcall Thread::ThreadEntry(void * threadObject)
     xr::Core::AtomicCompareAndSwap(&p->mID, kDefaultThreadID, tempId);
 
     sCurrentThread.SetValue(p);
+    if(p->mAffinity != kNoAffinity && p->mAffinity < sizeof(DWORD_PTR) * 8)
+    {
+        // Only the calling processor group is reachable this way.
+        DWORD_PTR mask = DWORD_PTR(1) << p->mAffinity;
+        DWORD_PTR previous = SetThreadAffinityMask(GetCurrentThread(), mask);
+        XR_EXPECT_ALWAYS_NE_FM(previous, DWORD_PTR(0), "SetThreadAffinityMask call Failed! GetLastError:0x%lX", GetLastError());
+    }
     if(p->mName != nullptr)
     {
         // Set the name on the thread before it runs.
@@ -501,6 +516,72 @@ void            Thread::YieldCurrentThread(uint32_t timeout_ms)
 {
     Sleep(timeout_ms);
 }
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t Thread::GetProcessorInfo(ProcessorInfo * info, size_t maxCount)
+{
+    static const size_t kMaskBits = sizeof(DWORD_PTR) * 8;
+    uint32_t core[kMaskBits];
+    // The core and NUMA entries come in no particular order, a processor
+    // is on node 0 until a node entry says otherwise.
+    uint32_t node[kMaskBits] = {};
+    DWORD_PTR known = 0;
+
+    DWORD length = 0;
+    GetLogicalProcessorInformation(nullptr, &length);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION * buffer = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION *)XR_ALLOC(length, "ProcessorInfo");
+    if(buffer != nullptr && GetLogicalProcessorInformation(buffer, &length))
+    {
+        uint32_t coreIndex = 0;
+        size_t entries = length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+        for(size_t i = 0; i < entries; ++i)
+        {
+            for(size_t bit = 0; bit < kMaskBits; ++bit)
+            {
+                if((buffer[i].ProcessorMask & (DWORD_PTR(1) << bit)) == 0)
+                {
+                    continue;
+                }
+                if(buffer[i].Relationship == RelationProcessorCore)
+                {
+                    core[bit] = coreIndex;
+                    known |= (DWORD_PTR(1) << bit);
+                }
+                else if(buffer[i].Relationship == RelationNumaNode)
+                {
+                    node[bit] = uint32_t(buffer[i].NumaNode.NodeNumber);
+                }
+            }
+            if(buffer[i].Relationship == RelationProcessorCore)
+            {
+                ++coreIndex;
+            }
+        }
+    }
+    XR_FREE(buffer);
+
+    DWORD_PTR processMask = 0;
+    DWORD_PTR systemMask = 0;
+    GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask);
+
+    size_t count = 0;
+    for(size_t bit = 0; bit < kMaskBits; ++bit)
+    {
+        if((processMask & (DWORD_PTR(1) << bit)) == 0)
+        {
+            continue;
+        }
+        if(count < maxCount)
+        {
+            bool isKnown = (known & (DWORD_PTR(1) << bit)) != 0;
+            info[count].mProcessor = uint32_t(bit);
+            info[count].mCore      = isKnown ? core[bit] : uint32_t(bit);
+            info[count].mNode      = node[bit];
+        }
+        ++count;
+    }
+    return count;
+}
 
 #elif defined(_POSIX_THREADS)
 /*#######################################################################*/
@@ -540,6 +621,7 @@ Thread::Thread() : mMonitor()
     mHasExited2 = false;
     mHasStarted = false;
     mHasRequestedQuit = false;
+    mAffinity = kNoAffinity;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -551,6 +633,7 @@ Thread::Thread(const char * name) : mMonitor()
     mHasExited2 = false;
     mHasStarted = false;
     mHasRequestedQuit = false;
+    mAffinity = kNoAffinity;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
@@ -563,8 +646,9 @@ Thread::~Thread()
         mName = nullptr;
     }
 
-    // Make sure that the monitor is REALLY free
-    while(mHasExited2 == false)
+    // Make sure that the monitor is REALLY free. Start assigns mID before
+    // returning, so a thread that was never started has nothing to wait on.
+    while(mID != kDefaultThreadID && mHasExited2 == false)
     {
         YieldCurrentThread();
     }
@@ -607,9 +691,23 @@ void * Thread::ThreadEntry(void * threadObject)
     // If this fails that's fine. The other thread got there first.
     xr::Core::AtomicCompareAndSwap(&p->mID, kDefaultThreadID, tempId);
 
+    if(p->mAffinity != kNoAffinity)
+    {
+#if defined(XR_PLATFORM_LINUX)
+        if(p->mAffinity < CPU_SETSIZE)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(p->mAffinity, &set);
+            int errval = pthread_setaffinity_np(temp, sizeof(set), &set);
+            XR_EXPECT_ALWAYS_EQ_FM(errval, 0, "Error: Error returned from pthread_setaffinity_np. errno:%d", errval);
+        }
+#endif
+    }
+
     p->mHasStarted = true;
     sCurrentThread.SetValue(p);
-    uint32_t retValue = p->Run();
+    uintptr_t retValue = p->Run();
     p->OnExit(retValue);
     return 0;
 }
@@ -668,11 +766,17 @@ bool Thread::Join(uint32_t timeout_ms)
     ts.tv_sec = tv.tv_sec;
     ts.tv_nsec = tv.tv_usec * 1000;
 #else
-    clock_gettime(CLOCK_REALTIME, &ts);
+    // Monitors wait on the monotonic clock (see Monitor::Monitor).
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 #endif
 
-    ts.tv_sec += (timeout_ms / 1000);
-    ts.tv_nsec = ((timeout_ms%1000) * 1000 * 1000);
+    ts.tv_sec  += (timeout_ms / 1000);
+    ts.tv_nsec += ((timeout_ms%1000) * 1000 * 1000);
+    if(ts.tv_nsec >= 1000000000)
+    {
+        ts.tv_nsec -= 1000000000;
+        ts.tv_sec  += 1;
+    }
 
 
     sMutex.Lock();
@@ -746,6 +850,94 @@ void            Thread::YieldCurrentThread(uint32_t timeout_ms)
 {
     usleep(timeout_ms * 1000);
 }
+#if defined(XR_PLATFORM_LINUX)
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Reads a single number from /sys/devices/system/cpu/cpuN/<file>
+// --------------------------------------------------------------------------------------  FUNCTION
+static uint32_t ReadCpuTopologyValue(int cpu, const char * file, uint32_t defaultValue)
+{
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/%s", cpu, file);
+    FILE * f = fopen(path, "r");
+    if(f == nullptr)
+    {
+        return defaultValue;
+    }
+    unsigned value = defaultValue;
+    if(fscanf(f, "%u", &value) != 1)
+    {
+        value = defaultValue;
+    }
+    fclose(f);
+    return uint32_t(value);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// The cpu's directory holds a "nodeN" link on NUMA kernels.
+// --------------------------------------------------------------------------------------  FUNCTION
+static uint32_t ReadCpuNode(int cpu)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR * dir = opendir(path);
+    if(dir == nullptr)
+    {
+        return 0;
+    }
+    unsigned node = 0;
+    struct dirent * entry;
+    while((entry = readdir(dir)) != nullptr)
+    {
+        if(sscanf(entry->d_name, "node%u", &node) == 1)
+        {
+            break;
+        }
+        node = 0;
+    }
+    closedir(dir);
+    return uint32_t(node);
+}
+#endif
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t Thread::GetProcessorInfo(ProcessorInfo * info, size_t maxCount)
+{
+#if defined(XR_PLATFORM_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        size_t count = 0;
+        for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if(!CPU_ISSET(cpu, &set))
+            {
+                continue;
+            }
+            if(count < maxCount)
+            {
+                // core_id is only unique within a package.
+                uint32_t package = ReadCpuTopologyValue(cpu, "topology/physical_package_id", 0);
+                uint32_t core    = ReadCpuTopologyValue(cpu, "topology/core_id", uint32_t(cpu));
+                info[count].mProcessor = uint32_t(cpu);
+                info[count].mCore      = (package << 16) | (core & 0xFFFF);
+                info[count].mNode      = ReadCpuNode(cpu);
+            }
+            ++count;
+        }
+        return count;
+    }
+#endif
+    // No topology, every processor is its own core on node 0.
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t count = online > 0 ? size_t(online) : 1;
+    for(size_t i = 0; i < count && i < maxCount; ++i)
+    {
+        info[i].mProcessor = uint32_t(i);
+        info[i].mCore      = uint32_t(i);
+        info[i].mNode      = 0;
+    }
+    return count;
+}
 #else // Platform
 #error "Need a Thread implementation for this platform (or addit to an existing platform)"
 #endif
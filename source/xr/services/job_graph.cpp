@@ -0,0 +1,315 @@
+// ######################################################################################### - FILE
+/*!
+
+Job Graph:
+Nodes live in mNodes, edges are recorded as pairs and turned into a
+successor array (CSR, each node's successors are a contiguous range of
+mSuccessors) by Compile. Per launch state is one counter per node plus a
+count of nodes left, both reset by Launch before any node can run.
+
+Timing issues are prevented using the following means:
++ mRemaining: decremented atomically by each antecedent, the one taking it
+  to zero starts (or runs) the node, so every node starts exactly once.
++ mRemainingNodes: every node copies mDone before decrementing it, the
+  one taking it to zero releases that copy and touches the graph no more,
+  IsRunning is false from then on and Launch may be called again.
++ Everything else is only written by AddNode / AddEdge / Compile, which
+  require the graph not to be running.
+
+\author Daniel Craig \par Copyright 2016, All Rights reserved.
+*/
+// ######################################################################################### - FILE
+
+// ######################################################################################### - FILE
+/* Includes */
+// ######################################################################################### - FILE
+#ifndef XR_DEFINES_H
+#include "xr/defines.h"
+#endif
+#ifndef XR_SERVICES_JOB_GRAPH_H
+#include "xr/services/job_graph.h"
+#endif
+#ifndef XR_CORE_ASSERT_H
+#include "xr/core/assert.h"
+#endif
+#ifndef XR_CORE_ALLOCATOR_H
+#include "xr/core/allocator.h"
+#endif
+#ifndef XR_CORE_MEM_UTILS_H
+#include "xr/core/mem_utils.h"
+#endif
+#ifndef XR_CORE_THREADING_ATOMIC_H
+#include "xr/core/threading/atomic.h"
+#endif
+
+// ######################################################################################### - FILE
+/* Implementation */
+// ######################################################################################### - FILE
+namespace xr { namespace Scheduling {
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobGraph::JobGraph()
+    : mRemaining(nullptr)
+    , mNodeCount(0)
+    , mRemainingNodes(0)
+    , mCompiled(false)
+    , mManager(nullptr)
+{
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobGraph::~JobGraph()
+{
+    XR_ASSERT_ALWAYS_EQ_M(IsRunning(), false, "JobGraph destroyed while running");
+
+    for(Node & node : mNodes)
+    {
+        if(node.mPayload != nullptr)
+        {
+            if(node.mDestroy != nullptr)
+            {
+                node.mDestroy(node.mPayload);
+            }
+            XR_FREE(node.mPayload);
+        }
+    }
+    if(mRemaining != nullptr)
+    {
+        XR_FREE((void *)mRemaining);
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t JobGraph::AddNode(Core::Runnable r, const Core::Arguments * args, Priority priority)
+{
+    XR_ASSERT_ALWAYS_EQ_M(IsRunning(), false, "JobGraph edited while running");
+    XR_ASSERT_ALWAYS_LT(mNodeCount, size_t(XR_UINT32_MAX));
+
+    Node * node = mNodes.Insert();
+    node->mRunnable       = r;
+    node->mArguments[0]   = args != nullptr ? args->a0 : 0;
+    node->mArguments[1]   = args != nullptr ? args->a1 : 0;
+    node->mArguments[2]   = args != nullptr ? args->a2 : 0;
+    node->mArguments[3]   = args != nullptr ? args->a3 : 0;
+    node->mPayload        = nullptr;
+    node->mDestroy        = nullptr;
+    node->mSuccessorBegin = 0;
+    node->mSuccessorCount = 0;
+    node->mPriority       = uint32_t(priority);
+
+    mCompiled = false;
+    return mNodeCount++;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t JobGraph::AddNodePayload(const detail::PayloadType * type, void * object, Priority priority)
+{
+    void * payload = XR_ALLOC_ALIGN(type->mSize, "JobGraph::Payload", 16);
+    type->mMove(payload, object);
+
+    Core::Arguments args((uintptr_t)payload);
+    const size_t index = AddNode(type->mRunIndirect, &args, priority);
+
+    Node & node = mNodes.begin()[index];
+    node.mPayload = payload;
+    node.mDestroy = type->mDestroy;
+    return index;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobGraph::AddEdge(size_t before, size_t after)
+{
+    XR_ASSERT_ALWAYS_EQ_M(IsRunning(), false, "JobGraph edited while running");
+    XR_ASSERT_ALWAYS_LT(before, mNodeCount);
+    XR_ASSERT_ALWAYS_LT(after, mNodeCount);
+    XR_ASSERT_ALWAYS_NE(before, after);
+
+    Edge * edge = mEdges.Insert();
+    edge->mBefore = uint32_t(before);
+    edge->mAfter  = uint32_t(after);
+    mCompiled = false;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobGraph::Compile()
+{
+    Node * nodes = mNodes.begin();
+    const size_t edgeCount = mEdges.Count();
+    const Edge * edges = mEdges.begin();
+
+    //`````````````````````````````````````````````````````````````````
+    // Count both ends of every edge.
+    mAntecedentCounts.Clear();
+    mAntecedentCounts.Reserve(mNodeCount);
+    for(size_t i = 0; i < mNodeCount; ++i)
+    {
+        mAntecedentCounts.Insert(0);
+        nodes[i].mSuccessorCount = 0;
+    }
+    uint32_t * antecedentCounts = mAntecedentCounts.begin();
+    for(size_t i = 0; i < edgeCount; ++i)
+    {
+        ++nodes[edges[i].mBefore].mSuccessorCount;
+        ++antecedentCounts[edges[i].mAfter];
+    }
+
+    //`````````````````````````````````````````````````````````````````
+    // Give each node its range, then fill them (the count doubles as the
+    // fill cursor).
+    uint32_t begin = 0;
+    for(size_t i = 0; i < mNodeCount; ++i)
+    {
+        nodes[i].mSuccessorBegin = begin;
+        begin += nodes[i].mSuccessorCount;
+        nodes[i].mSuccessorCount = 0;
+    }
+    mSuccessors.Clear();
+    mSuccessors.Reserve(edgeCount);
+    for(size_t i = 0; i < edgeCount; ++i)
+    {
+        mSuccessors.Insert(0);
+    }
+    uint32_t * successors = mSuccessors.begin();
+    for(size_t i = 0; i < edgeCount; ++i)
+    {
+        Node & node = nodes[edges[i].mBefore];
+        successors[node.mSuccessorBegin + node.mSuccessorCount++] = edges[i].mAfter;
+    }
+
+    //`````````````````````````````````````````````````````````````````
+    // Roots, and make sure everything is reachable from them (no cycles).
+    mRoots.Clear();
+    if(mRemaining != nullptr)
+    {
+        XR_FREE((void *)mRemaining);
+    }
+    mRemaining = (volatile uint32_t *)XR_ALLOC(sizeof(uint32_t) * (mNodeCount + 1), "JobGraph::Remaining");
+    uint32_t * remaining = (uint32_t *)mRemaining;
+    Core::MemCopy32(remaining, antecedentCounts, mNodeCount);
+
+    uint32_t * order = (uint32_t *)XR_ALLOC(sizeof(uint32_t) * (mNodeCount + 1), "JobGraph::Compile");
+    size_t orderCount = 0;
+    for(size_t i = 0; i < mNodeCount; ++i)
+    {
+        if(antecedentCounts[i] == 0)
+        {
+            mRoots.Insert(uint32_t(i));
+            order[orderCount++] = uint32_t(i);
+        }
+    }
+    for(size_t i = 0; i < orderCount; ++i)
+    {
+        const Node & node = nodes[order[i]];
+        for(size_t s = 0; s < node.mSuccessorCount; ++s)
+        {
+            const uint32_t successor = successors[node.mSuccessorBegin + s];
+            if(--remaining[successor] == 0)
+            {
+                order[orderCount++] = successor;
+            }
+        }
+    }
+    XR_FREE(order);
+    XR_ASSERT_ALWAYS_EQ_M(orderCount, mNodeCount, "JobGraph has a cycle");
+
+    mCompiled = true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle JobGraph::Launch(IManager * manager)
+{
+    XR_ASSERT_ALWAYS_EQ_M(IsRunning(), false, "JobGraph launched while running");
+
+    if(!mCompiled)
+    {
+        Compile();
+    }
+    if(mNodeCount == 0)
+    {
+        return IManager::GetCompletedHandle();
+    }
+
+    mManager = manager;
+    Core::MemCopy32((uint32_t *)mRemaining, mAntecedentCounts.begin(), mNodeCount);
+    mRemainingNodes = mNodeCount;
+
+    // Only forwards the completion, get it out of the way quickly.
+    mDone = manager->InsertBlocked((Core::Runnable)nullptr, nullptr, kPriorityHigh);
+    JobHandle done = mDone;
+
+    for(uint32_t root : mRoots)
+    {
+        Start(root);
+    }
+    return done;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool JobGraph::IsRunning() const
+{
+    // Not mDone, the graph may outlive the manager it last ran on.
+    return mRemainingNodes != 0;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobGraph::Start(size_t nodeIndex)
+{
+    Core::Arguments args((uintptr_t)this, (uintptr_t)nodeIndex);
+    mManager->InsertReady(&RunNodes, &args, Priority(mNodes.begin()[nodeIndex].mPriority));
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobGraph::RunNodes(const Core::Arguments * args)
+{
+    JobGraph *       graph      = (JobGraph *)args->a0;
+    size_t           index      = args->a1;
+    const Node *     nodes      = graph->mNodes.begin();
+    const uint32_t * successors = graph->mSuccessors.begin();
+
+    for(;;)
+    {
+        const Node & node = nodes[index];
+        if(node.mRunnable != nullptr)
+        {
+            Core::Arguments nodeArgs(node.mArguments[0], node.mArguments[1], node.mArguments[2], node.mArguments[3]);
+            node.mRunnable(&nodeArgs);
+        }
+
+        // Run the first successor we enable ourselves, unless it would let
+        // a lower priority node ride in on our time slice.
+        size_t next = XR_SIZE_MAX;
+        for(size_t i = 0; i < node.mSuccessorCount; ++i)
+        {
+            const uint32_t successor = successors[node.mSuccessorBegin + i];
+            if(xr::Core::AtomicDecrement(&graph->mRemaining[successor]) != 1)
+            {
+                continue;
+            }
+            if(next == XR_SIZE_MAX && nodes[successor].mPriority <= node.mPriority)
+            {
+                next = successor;
+            }
+            else
+            {
+                graph->Start(successor);
+            }
+        }
+
+        // Read before the decrement: once mRemainingNodes reaches zero the
+        // graph may be relaunched (new mDone) or destroyed.
+        JobHandleBlocked done = graph->mDone;
+        if(xr::Core::AtomicDecrement(&graph->mRemainingNodes) == 1)
+        {
+            done.ReleaseBarrier();
+            return;
+        }
+        if(next == XR_SIZE_MAX)
+        {
+            return;
+        }
+        index = next;
+    }
+}
+
+}}//namespace xr
@@ -7,15 +7,139 @@ maintained internally by forward dependencies (i.e. when a job finishes it
 decrements downstream jobs and readies them if their counts reach 0).
 
 
+Ready jobs:
+Every worker owns a work stealing deque per priority lane. A job readied on a
+worker thread (inserted by a running job or enabled by its completion) is
+pushed onto that worker's deque for its lane and popped LIFO by the owner.
+Idle workers steal FIFO from the other workers. The shared ReadyLists (one per
+lane) are only used for jobs submitted from threads which are not workers of
+this scheduler (and for overflow when a deque is full). Workers with nothing
+to do park on a monitor, pushers only touch it when a worker has announced it
+is going idle.
+
+Placement (optional): workers can be pinned to processors. When NUMA aware,
+workers are assigned node by node and steal from their own node first, so
+a job (and the JobInstance a worker recycles through its magazine) tends to
+stay on the node that readied it.
+
+Lanes are searched highest priority first (local, shared, steal for each
+lane before moving to the next). Every mStarvationInterval picks a worker
+searches lowest priority first instead, so background work can not be
+starved forever by a steady stream of higher priority jobs.
+
+Groups: a job in a group (JobInstance::mGroup) is never pushed to a deque,
+it waits in its group's queue for its lane, so the group's share and cap
+apply to every one of its jobs (a successor it enables is queued too, not
+run as the continuation). Within a lane a worker looks at its deque, then
+the groups (deficit round robin, see JobThread::FindGroupWork), then the
+shared list, then steals.
+
 Timing issues are prevented using the following means:
-+ FreeList / ReadyList: These are encapsulated and thread safety is assumed
-  by the underlying types. Lockless / other versions can be used in the future
-  should performance be acceptable.
-+ WaitOn() is implemented using a monitor, which requires a user space mutex.
-+ Event Management: protected by the WaitOn Mutex. Since the Mutex is held
-  only for very small periods of time contention is hopefully minimized.
-  Also since this mutex must be locked for a completed job anyway it's
-  additive cost is small.
++ ReadyList: This is encapsulated and thread safety is assumed by the
+  underlying type.
++ FreeList: JobInstancePool, a lock free (tagged pointer) stack. Workers
+  keep a small magazine of instances and only touch the shared stack in
+  batches. Idle workers return their magazine so instances are not hoarded.
++ Deques: owner push / pop and steal are lock free, see work_stealing_deque.h
++ Parking: A worker increments mIdleCount *before* its final scan for work,
+  a pusher publishes its job before reading mIdleCount. One of the two always
+  sees the other, so a job can not be left behind with every worker asleep.
++ Spinning: pushers skip the wake while mSpinningCount covers the jobs. A
+  spinner leaves mSpinningCount before it parks, and parking does the final
+  scan above, so a job it was counted for is found either way.
++ WaitOn() is per job. Waiters register in the instance's mWaiterCount,
+  a completion fences and reads it, and with no waiters locks and wakes
+  nothing (on any platform). On Linux waiters sleep on a
+  futex on the low word of mXID, elsewhere on the monitor of the instance's
+  wait bucket (a small parking lot of mutex / monitor pairs keyed by
+  instance address).
++ Payloads: lambdas up to IManager::kInlinePayloadSize live in the
+  instance. Larger ones come from the PayloadArena, size classed blocks
+  carved from chunks. Workers cache blocks per class and only lock the
+  arena once per batch. Payloads are destroyed and released by Run before
+  completion is signaled.
++ Successors: lock free. mSuccessorState (64 bits on every target) packs
+  the generation (low word of the XID), a closed flag and the number of
+  reserved slots, so a CAS both
+  checks the antecedent is still the same unfinished job and reserves a
+  slot. Slots past the inline ones live in chunks from the payload arena
+  (each twice the last, up to the largest class), the adder reserving a
+  chunk's first slot allocates it. Completion closes the list, then waits
+  for every reserved slot to be written (adders are a few instructions from
+  doing so) before notifying, so an instance is never recycled under an
+  adder. Successors it enables are queued in per lane batches.
++ Statistics: WorkerCounters are written by their worker only (plain
+  volatile stores, no atomics) and read racily by GetStats. Scheduler wide
+  marks are updated with CAS, and only when they move.
++ Tracing: each worker owns its ring and publishes a record by advancing
+  mTraceCount (release). mEnabledBy shares storage with mNextFree, which
+  is only meaningful while the instance is free.
++ Cancellation: Cancel sets bits in mSuccessorState with the same CAS
+  (and generation check) as AddSuccessor, so it can not mark a reused
+  instance and loses to completion closing the list. Run reads them once,
+  before the runnable. Tokens are plain flags read at the same point.
++ Timers: the wheel and the timer free list are under mTimerMutex, held
+  only to link / unlink (jobs are released and queued after it is
+  dropped). Servicing uses TryLock, a worker that finds it taken moves on.
+  mNextTimerDeadline is only ever early (a cancel does not push it back),
+  so a service may find nothing to do but never misses a deadline.
+  A delayed job keeps its timer in the mNextFree union until it fires.
+  Cancelling the job unlinks the timer under mTimerMutex and releases
+  the job at once, checking the XID after reading the union. Firing
+  clears the union under the same lock.
+  The parked worker holding mTimerKeeper waits on mTimerMonitor with a
+  timeout, an earlier timer signals it (or, with no keeper, wakes a
+  worker which will become one). Same publish-then-check pairing as
+  Parking above.
++ Blocking pool: one mutex and monitor guard its queue and thread
+  counts. A thread is started when a job is queued and there are fewer
+  idle threads than queued jobs, one that times out waiting (and is above
+  the minimum) moves itself to mRetired, the next start or Shutdown joins
+  it. Blocking jobs never enter the ready lanes, Enqueue routes them by
+  lane, and a compute job one of them enables goes back through Enqueue.
++ Fibers: a fiber job's WaitOn records what it waits on in its FiberSlot
+  and switches back to the worker's own stack. Only then, with the
+  fiber's context saved, does the worker add the job that resumes it as a
+  successor of the awaited one, so it can not be resumed before it is
+  fully switched out. Resume jobs ignore cancellation (the fiber would be
+  stranded). Free fibers are a list under mFiberMutex. The current
+  CancellationScope token and JobGroupScope group are per thread, they
+  are swapped with the fiber's own on every switch.
++ Scratch: each worker and each fiber owns a LinearAllocator only it
+  touches. RunJob takes a marker before a job and rolls back to it after,
+  jobs run while helping in WaitOn nest inside it. A fiber job allocates
+  from its fiber's arena (it may resume on another worker), which is
+  cleared when the job completes.
++ Elastic pool: mActiveThreads only changes under mElasticMutex and the
+  active workers are always [0, mActiveThreads), so stealing and
+  ParallelFor just read the count. Only the newest worker retires, from
+  Park (after a last look for work, a wake may have been meant for it),
+  with empty deques: nothing else pushes to them. It then sleeps on
+  mElasticMonitor, outside mIdleCount, so wakes never count on it.
+  Growth is decided on the push path (WakeWorkers finding no idle or
+  spinning worker) against mBacklogSince, which any worker running out of
+  work clears. Pushers claim the decision with a CAS on mBacklogSince,
+  the one that wins only TryLocks, pushers never wait on it.
++ Groups: created under mGroupMutex into a fixed array and published by
+  mGroupCount (release), never removed before Shutdown. Deficits and the
+  per group run counters are per worker (owner writes only). mRunning is
+  claimed by increment before a job is taken from a group's queue and
+  given back if the queue was empty or the cap was exceeded, so the cap is
+  exact. A claimed job is counted until RunJob finishes it (Park puts one
+  back unrun, and gives the claim back). A job waiting in
+  HelpUntilComplete gives its claim back meanwhile and takes it again
+  unconditionally, or a capped group waiting on itself would deadlock.
++ Growth: instances are only added, never returned before Shutdown, so a
+  pointer popped from the free list stays valid. mGrowMutex serializes
+  growth, a thread that waited on it retries the free list first.
++ Instances: each starts a cache line. The first line holds what other
+  threads write while the job is live (mXID, successors, antecedent count,
+  waiter count), the rest what the inserter writes and the runner reads.
+  XIDs need no shared counter: the low word is a generation only the
+  owner of the instance bumps (in Initialize, before the handle exists),
+  the high word is the instance's line number, so XIDs stay unique across
+  instances for tracing. A stale handle could only match again after 2^32
+  uses of the same instance.
 
 
 \author Daniel Craig \par Copyright 2016, All Rights reserved.
@@ -58,8 +182,45 @@ Timing issues are prevented using the following means:
 #ifndef XR_CORE_THREADING_MONITOR_H
 #include "xr/core/threading/monitor.h"
 #endif
+#ifndef XR_CORE_THREADING_TLS_H
+#include "xr/core/threading/tls.h"
+#endif
+#ifndef XR_CORE_THREADING_WORK_STEALING_DEQUE_H
+#include "xr/core/threading/work_stealing_deque.h"
+#endif
+#ifndef XR_CORE_THREADING_FIBER_H
+#include "xr/core/threading/fiber.h"
+#endif
+#ifndef XR_CORE_ALLOCATORS_LINEAR_H
+#include "xr/core/allocators/linear.h"
+#endif
+#ifndef XR_CORE_TIME_H
+#include "xr/core/time.h"
+#endif
+#ifndef XR_CORE_STRING_UTILS_H
+#include "xr/core/string_utils.h"
+#endif
+#ifndef XR_CORE_CONTAINERS_VECTOR
+#include "xr/core/containers/vector.h"
+#endif
+#ifndef XR_CORE_MEM_UTILS_H
+#include "xr/core/mem_utils.h"
+#endif
 #include "xr/core/static_profile.h"
 #include <malloc.h> // alloca
+#include <stdarg.h>
+#include <algorithm> // std::sort
+
+#if defined(XR_COMPILER_MICROSOFT)
+#include <intrin.h> // _mm_pause
+#endif
+
+#if defined(XR_PLATFORM_LINUX)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#endif
 
 // ######################################################################################### - FILE
 /* Private Macros */
@@ -71,6 +232,86 @@ Timing issues are prevented using the following means:
 namespace xr { namespace Scheduling{
 
 static Core::LogHandle sScedulerLogHandle("xr.scheduling");
+class ManagerInternal;
+class JobInstance;
+class BlockingPool;
+struct FiberSlot;
+struct JobGroupState;
+struct Timer;
+
+// --------------------------------------------------------------------------------------  FUNCTION
+/// JobInstance lane of blocking jobs (IManager::InsertBlocking). Past the
+/// compute lanes, so a worker never runs one as its continuation.
+// --------------------------------------------------------------------------------------  FUNCTION
+static const size_t kBlockingLane = kPriorityCount;
+// --------------------------------------------------------------------------------------  FUNCTION
+/// How long a worker in HelpUntilComplete sleeps on the awaited job before
+/// looking for other work again. The completion itself wakes it earlier.
+// --------------------------------------------------------------------------------------  FUNCTION
+static const uint64_t kHelpRecheckMicroSeconds = 1000;
+
+// ***************************************************************************************** - TYPE
+/*! Per worker cache of free JobInstances, an intrusive list. Only the owner
+    pushes or pops single entries. Any thread may take the whole list (a
+    thread starved for instances drains every magazine before sleeping),
+    so the owner still uses CAS on mHead, but the line is rarely shared. */
+// ***************************************************************************************** - TYPE
+struct JobMagazine
+{
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t kMaxSize = 32;
+    JobMagazine() : mHead(nullptr), mCount(0), mCapacity(0) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * volatile mHead;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Owner's idea of the list length, reset when it finds the list drained.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t        mCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// 0 disables the magazine (small pools).
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t        mCapacity;
+};
+// ***************************************************************************************** - TYPE
+/*! Header in front of every arena payload, padded so payloads stay 16 byte
+    aligned. */
+// ***************************************************************************************** - TYPE
+struct PayloadBlock
+{
+    static const size_t kHeaderSize = 16;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Free list link
+    // ------------------------------------------------------------------------------------  MEMBER
+    PayloadBlock * mNext;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Size class, PayloadCache::kNumClasses if it came from the general allocator
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t         mClass;
+};
+static_assert(sizeof(PayloadBlock) <= PayloadBlock::kHeaderSize, "size validation" );
+// ***************************************************************************************** - TYPE
+/*! Per worker free payload blocks, one list per size class. Owner only. */
+// ***************************************************************************************** - TYPE
+struct PayloadCache
+{
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Classes are 128, 256 .. 4096 bytes (header included)
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t kNumClasses    = 6;
+    static const size_t kMinClassShift = 7;
+    PayloadCache()
+    {
+        for(size_t i = 0; i < kNumClasses; i++)
+        {
+            mFree[i]  = nullptr;
+            mCount[i] = 0;
+        }
+    }
+    PayloadBlock * mFree[kNumClasses];
+    size_t         mCount[kNumClasses];
+};
 // ***************************************************************************************** - TYPE
 // ***************************************************************************************** - TYPE
 enum JobState
@@ -80,35 +321,414 @@ enum JobState
     XR_JOB_RUNNING
 };
 // ***************************************************************************************** - TYPE
+/*! Counters behind IManager::WorkerStats. Only the owning worker writes
+    them, times are in Core::TimeStamp units. */
+// ***************************************************************************************** - TYPE
+struct WorkerCounters
+{
+    WorkerCounters() : mJobsRun(0), mBusy(0), mIdle(0), mBlocked(0), mSteals(0), mParks(0), mWaitCalls(0), mDequeHighWater(0), mSpinHits(0), mJobsCancelled(0), mFiberWaits(0) {}
+    volatile uint64_t        mJobsRun;
+    volatile Core::TimeStamp mBusy;
+    volatile Core::TimeStamp mIdle;
+    volatile Core::TimeStamp mBlocked;
+    volatile uint64_t        mSteals;
+    volatile uint64_t        mParks;
+    volatile uint64_t        mWaitCalls;
+    volatile uint64_t        mDequeHighWater;
+    volatile uint64_t        mSpinHits;
+    volatile uint64_t        mJobsCancelled;
+    volatile uint64_t        mFiberWaits;
+};
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Tells the core we are in a spin loop (frees resources for a sibling
+/// hardware thread, saves power).
+// --------------------------------------------------------------------------------------  FUNCTION
+static inline void SpinPause()
+{
+#if defined(XR_CPU_X86) && defined(XR_COMPILER_MICROSOFT)
+    _mm_pause();
+#elif defined(XR_CPU_X86)
+    __builtin_ia32_pause();
+#elif defined(XR_CPU_ARM)
+    __asm__ __volatile__("yield");
+#endif
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Raises *mark to value if it is higher. Racing updates settle on the highest.
+// --------------------------------------------------------------------------------------  FUNCTION
+static inline void UpdateHighWater(volatile uintptr_t * mark, uintptr_t value)
+{
+    uintptr_t current = *mark;
+    while(value > current)
+    {
+        uintptr_t seen = xr::Core::AtomicCompareAndSwap(mark, current, value);
+        if(seen == current)
+        {
+            return;
+        }
+        current = seen;
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Token of the innermost CancellationScope on this thread (or of the job
+/// it is running). Only read while sTokenScopes is not 0, so programs that
+/// never open a scope pay no TLS lookup per insert.
+// --------------------------------------------------------------------------------------  FUNCTION
+static xr::Core::ThreadLocalStorage<CancellationToken*> sCurrentToken;
+static volatile uintptr_t                               sTokenScopes = 0;
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Returns the token to pass to LeaveTokenScope.
+// --------------------------------------------------------------------------------------  FUNCTION
+static inline CancellationToken * EnterTokenScope(CancellationToken * token)
+{
+    xr::Core::AtomicIncrement(&sTokenScopes);
+    CancellationToken * previous = sCurrentToken.GetValue();
+    sCurrentToken.SetValue(token);
+    return previous;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+static inline void LeaveTokenScope(CancellationToken * previous)
+{
+    sCurrentToken.SetValue(previous);
+    xr::Core::AtomicDecrement(&sTokenScopes);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Group of the innermost JobGroupScope on this thread (or of the job it
+/// is running), same rules as sCurrentToken.
+// --------------------------------------------------------------------------------------  FUNCTION
+static xr::Core::ThreadLocalStorage<JobGroupState*>     sCurrentGroup;
+static volatile uintptr_t                               sGroupScopes = 0;
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Returns the group to pass to LeaveGroupScope.
+// --------------------------------------------------------------------------------------  FUNCTION
+static inline JobGroupState * EnterGroupScope(JobGroupState * group)
+{
+    xr::Core::AtomicIncrement(&sGroupScopes);
+    JobGroupState * previous = sCurrentGroup.GetValue();
+    sCurrentGroup.SetValue(group);
+    return previous;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+static inline void LeaveGroupScope(JobGroupState * previous)
+{
+    sCurrentGroup.SetValue(previous);
+    xr::Core::AtomicDecrement(&sGroupScopes);
+}
+// ***************************************************************************************** - TYPE
+/// One job in a worker's trace ring, see IManager::SetTracing.
+// ***************************************************************************************** - TYPE
+struct TraceRecord
+{
+    uint64_t        mXID;
+    uint64_t        mEnabledBy;
+    Core::Runnable  mRunnable;
+    Core::TimeStamp mStart;
+    Core::TimeStamp mEnd;
+};
+// ***************************************************************************************** - TYPE
 // ***************************************************************************************** - TYPE
 class JobThread: public Core::Thread
 {
 public:
-    JobThread(): mReadyQueue(nullptr), mManager(nullptr) {}
+    JobThread(): mManager(nullptr), mIndex(0), mNode(0), mStealSeed(0), mPickCount(0), mIdleGap(0), mTrace(nullptr), mTraceCount(0), mFiber(nullptr), mScratch(nullptr), mRunningGroup(0), mUncharged(nullptr)
+    {
+        for(size_t i = 0; i < kPriorityCount; i++)
+        {
+            mDeques[i] = nullptr;
+            mGroupCursor[i] = 0;
+            for(size_t g = 0; g < IManager::kMaxGroups; g++)
+            {
+                mGroupDeficit[i][g] = 0;
+            }
+        }
+        for(size_t i = 0; i < IManager::kMaxGroups; i++)
+        {
+            mGroupJobs[i]    = 0;
+            mGroupTime[i]    = 0;
+        }
+    }
     // ------------------------------------------------------------------------------------  MEMBER
     // ------------------------------------------------------------------------------------  MEMBER
     uintptr_t Run() XR_OVERRIDE;
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Searches the lanes in priority order (see mStarvationInterval).
+    /// nullptr if nothing found.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * FindWork();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Local pop, then the groups, then the shared queue, then steal.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * FindWork(size_t lane);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// A job of \a lane from the group whose turn it is (deficit round
+    /// robin), or from any group with work if none has a turn left.
+    /// nullptr if the groups have nothing runnable.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * FindGroupWork(size_t lane);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Spins, then yields, looking for work. nullptr if it is time to park.
+    /// \a idleSince is when we ran out of work.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * SpinForWork(Core::TimeStamp idleSince);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// How long to spin, from mIdleGap.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline Core::TimeStamp GetSpinBudget() const;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runs ji (and counts it), returns the successor to run next.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline JobInstance * RunJob(JobInstance * ji);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// RunJob while recording, adds a record to mTrace.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * RunTraced(JobInstance * ji);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Called by this worker after pushing to its own deque.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void UpdateDequeHighWater(size_t lane)
+    {
+        const uint64_t count = mDeques[lane]->UnsafeGetCount();
+        if(count > mCounters.mDequeHighWater)
+        {
+            mCounters.mDequeHighWater = count;
+        }
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Try each other worker once, starting at a random one. Workers on
+    /// our node are tried before the rest.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * StealWork(size_t lane);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// WaitOn for a worker: run other jobs until ji / xid completes.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void HelpUntilComplete(JobInstance * ji, uint64_t xid);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runs fiber job \a ji on a free fiber (on this stack if there is
+    /// none), returns the successor to run next.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * RunFiber(JobInstance * ji);
     // ------------------------------------------------------------------------------------  MEMBER
-    xr::Core::BlockingQueue<JobInstance *> * mReadyQueue;
+    /// Switches to \a slot until its job completes or waits. Returns the
+    /// successor to run next, nullptr if it waits (it is then resumed by
+    /// a successor of what it waits on).
     // ------------------------------------------------------------------------------------  MEMBER
-    /// \internal Not used directly, only here for debugging.
+    JobInstance * EnterFiber(FiberSlot * slot);
     // ------------------------------------------------------------------------------------  MEMBER
-    IManager               * mManager;
+    /// WaitOn from a fiber job: switches back to the worker's stack until
+    /// ji / xid completes. Returns on whichever worker resumed the fiber,
+    /// the caller must not use this JobThread afterwards.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void SuspendFiber(JobInstance * ji, uint64_t xid);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Returns the JobThread for the calling thread, nullptr if the caller
+    /// is not a scheduler worker.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static inline JobThread * GetCurrent();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Jobs readied on this thread, one per priority. Only this thread
+    /// may push / pop.
+    // ------------------------------------------------------------------------------------  MEMBER
+    xr::Core::WorkStealingDeque<JobInstance *> * mDeques[kPriorityCount];
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    ManagerInternal        * mManager;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Index in the manager's thread array.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t                   mIndex;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// NUMA node this worker was placed on (0 unless mNumaAware).
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t                   mNode;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// xorshift state used to pick steal victims.
+    // ------------------------------------------------------------------------------------  MEMBER
+    uint32_t                 mStealSeed;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Jobs found in priority order since the last starvation guard pick.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t                   mPickCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Free instances cached by this worker.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobMagazine              mMagazine;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Moving average of the time from running out of work to finding
+    /// more, in TimeStamp units. Sets the spin budget.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::TimeStamp          mIdleGap;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Free payload blocks cached by this worker.
+    // ------------------------------------------------------------------------------------  MEMBER
+    PayloadCache             mPayloadCache;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// See IManager::GetStats
+    // ------------------------------------------------------------------------------------  MEMBER
+    WorkerCounters           mCounters;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Trace ring of mOptions.mTraceEventCount (a power of two) records,
+    /// nullptr when tracing is unavailable. mTraceCount is the number of
+    /// records ever written.
+    // ------------------------------------------------------------------------------------  MEMBER
+    TraceRecord            * mTrace;
+    volatile uintptr_t       mTraceCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The worker's own stack, attached when the scheduler has fibers.
+    /// mFiber is the fiber running on this thread, nullptr on our stack.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::Fiber              mThreadFiber;
+    FiberSlot              * mFiber;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// GetJobScratch for jobs run on this worker's stack.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::LinearAllocator  * mScratch;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Per lane, the group whose turn it is (index in the manager's
+    /// array) and each group's time left in its turn, negative while it
+    /// pays back an overrun, in TimeStamp units.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t                   mGroupCursor[kPriorityCount];
+    Core::TimeStamp          mGroupDeficit[kPriorityCount][IManager::kMaxGroups];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Jobs of each group this worker ran and their time, see GetGroupStats.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uint64_t        mGroupJobs[IManager::kMaxGroups];
+    volatile Core::TimeStamp mGroupTime[IManager::kMaxGroups];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Group of the job RunJob is running (innermost), 0 for none.
+    /// mUncharged is a job FindGroupWork handed out of turn, its time is
+    /// not taken from its group's deficit.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t                   mRunningGroup;
+    JobInstance            * mUncharged;
+private:
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    static xr::Core::ThreadLocalStorage<JobThread*> sCurrent;
+};
+// ***************************************************************************************** - TYPE
+/*! A job group (IManager::CreateGroup), see "Groups" at the top of the
+    file. JobInstance::mGroup holds mIndex, 0 is no group. */
+// ***************************************************************************************** - TYPE
+struct JobGroupState
+{
+    JobGroupState() : mManager(nullptr), mIndex(0), mName(nullptr), mWeight(1), mMaxConcurrency(0), mQuantum(0), mRunning(0), mRunningHighWater(0), mQueuedHighWater(0)
+    {
+        for(size_t i = 0; i < kPriorityCount; i++)
+        {
+            mQueues[i] = nullptr;
+        }
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Claims a run slot and takes the next job of \a lane. nullptr (and
+    /// no claim) if the lane is empty or the group is at its cap.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline JobInstance * TryTake(size_t lane)
+    {
+        // Unlocked peek, as for the shared ready lists.
+        Core::BlockingQueue<JobInstance *> * queue = mQueues[lane];
+        if(queue->UnsafeGetAvailableCount() == 0)
+        {
+            return nullptr;
+        }
+        const uintptr_t running = xr::Core::AtomicIncrement(&mRunning) + 1;
+        JobInstance * ji = nullptr;
+        if((mMaxConcurrency != 0 && running > mMaxConcurrency) || !queue->TryDequeue(&ji))
+        {
+            xr::Core::AtomicDecrement(&mRunning);
+            return nullptr;
+        }
+        UpdateHighWater(&mRunningHighWater, running);
+        return ji;
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Gives back a slot claimed by TryTake.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void Release() { xr::Core::AtomicDecrement(&mRunning); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Ready jobs in every lane, only a snapshot.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline size_t GetQueued() const
+    {
+        size_t count = 0;
+        for(size_t lane = 0; lane < kPriorityCount; lane++)
+        {
+            count += mQueues[lane]->UnsafeGetAvailableCount();
+        }
+        return count;
+    }
+
+    ManagerInternal                    * mManager;
+    size_t                               mIndex;
+    char                               * mName;
+    size_t                               mWeight;
+    size_t                               mMaxConcurrency;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Time added to the group's deficit each turn, mWeight quanta in
+    /// TimeStamp units.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::TimeStamp                      mQuantum;
+    Core::BlockingQueue<JobInstance *> * mQueues[kPriorityCount];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Claimed run slots, see TryTake.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t                   mRunning;
+    volatile uintptr_t                   mRunningHighWater;
+    volatile uintptr_t                   mQueuedHighWater;
+};
+// ***************************************************************************************** - TYPE
+/*! Successors past a JobInstance's inline slots, the slots follow the
+    header. Chunks are linked in the order of the slots they hold. Chunk n
+    fills payload arena class n (the largest class from then on), so even
+    a job with thousands of successors only has a handful of chunks. */
+// ***************************************************************************************** - TYPE
+struct SuccessorChunk
+{
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Allocation size of chunk \a chunkIndex
+    // ------------------------------------------------------------------------------------  MEMBER
+    static inline size_t GetSize(size_t chunkIndex)
+    {
+        const size_t sizeClass = chunkIndex < PayloadCache::kNumClasses ? chunkIndex : PayloadCache::kNumClasses - 1;
+        return (size_t(1) << (sizeClass + PayloadCache::kMinClassShift)) - PayloadBlock::kHeaderSize;
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Slots in chunk \a chunkIndex
+    // ------------------------------------------------------------------------------------  MEMBER
+    static inline size_t GetCapacity(size_t chunkIndex)
+    {
+        return (GetSize(chunkIndex) - sizeof(SuccessorChunk)) / sizeof(JobInstance *);
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline JobInstance * volatile * GetSlots()
+    {
+        return (JobInstance * volatile *)(this + 1);
+    }
+    SuccessorChunk * volatile mNext;
 };
 // ***************************************************************************************** - TYPE
-/*
+/* Cache line aligned, see "Instances" at the top of the file.
 */
 // ***************************************************************************************** - TYPE
+XR_ALIGN_PREFIX(64)
 class JobInstance
 {
 public:
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Alignment of every instance, slabs are allocated with it.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t kAlignment = 64;
     // ------------------------------------------------------------------------------------  MEMBER
-    void RunOnce(Core::BlockingStack<JobInstance*> *freeList, Core::BlockingQueue<JobInstance*> *readyList)
+    // ------------------------------------------------------------------------------------  MEMBER
+    void RunOnce(ManagerInternal *manager)
     {
-        mFreeList = freeList;
-        mReadyList = readyList;
+        mNextFree = nullptr;
+        mManager = manager;
+        mWaiterCount = 0;
+        mGeneration = 0;
     }
 
     // ------------------------------------------------------------------------------------  MEMBER
@@ -118,8 +738,18 @@ public:
     // ------------------------------------------------------------------------------------  MEMBER
     JobHandle Initialize(Core::Runnable r, size_t antecedentCount, const Core::Arguments *a);
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Moves \a object in as the job's runnable, call after Initialize.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void SetPayload(const detail::PayloadType * type, void * object);
+    // ------------------------------------------------------------------------------------  MEMBER
     // ------------------------------------------------------------------------------------  MEMBER
     void Release();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Drops a job that was initialized but never made visible (no handle
+    /// returned, not queued, no antecedent left to notify it): destroys
+    /// the payload and frees the instance.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Abandon();
 
     // ------------------------------------------------------------------------------------  MEMBER
     // ------------------------------------------------------------------------------------  MEMBER
@@ -141,6 +771,15 @@ public:
     // ------------------------------------------------------------------------------------  MEMBER
     void AppendAntecedent_NotStarted_NoLock(JobInstance * source);
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Adds \a successor to be notified when the job \a xid completes.
+    /// Returns false (and adds nothing) if it already has.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool AddSuccessor(uint64_t xid, JobInstance * successor);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// See JobHandle::Cancel. False if the job \a xid is complete.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool Cancel(uint64_t xid, CancelPolicy policy);
+    // ------------------------------------------------------------------------------------  MEMBER
     // ------------------------------------------------------------------------------------  MEMBER
     void AppendBarrier(size_t count);
     // ------------------------------------------------------------------------------------  MEMBER
@@ -154,668 +793,4782 @@ public:
     // ------------------------------------------------------------------------------------  MEMBER
     inline void WaitOn(uint64_t xid);
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Sleeps (futex / wait bucket) until \a xid completes, or for at most
+    /// \a microSeconds unless that is kSleepForever. Registered in
+    /// mWaiterCount meanwhile, so the completion wakes it at once.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const uint64_t kSleepForever = XR_UINT64_MAX;
+    void SleepUntilComplete(uint64_t xid, uint64_t microSeconds);
+    // ------------------------------------------------------------------------------------  MEMBER
     // ------------------------------------------------------------------------------------  MEMBER
     inline uint64_t GetXid() const;
     // ------------------------------------------------------------------------------------  MEMBER
-    /// Nothing to do here.
-    /// Call Initialize explicitly.
     // ------------------------------------------------------------------------------------  MEMBER
-    JobInstance() { }
+    inline Core::Runnable GetRunnable() const { return mRunnable; }
     // ------------------------------------------------------------------------------------  MEMBER
+    /// XID of the job whose completion made this one ready, 0 if it was
+    /// readied any other way. Valid from ready to Run.
     // ------------------------------------------------------------------------------------  MEMBER
-    ~JobInstance() { }
-private:
+    inline uint64_t GetEnabledBy() const { return mEnabledBy; }
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Lane the job is queued in once ready. Initialize resets it to
+    /// normal, set it before the job can become ready.
     // ------------------------------------------------------------------------------------  MEMBER
-    static void AddNotificationLocked(JobInstance * source, JobInstance * notifies);
-
+    inline void SetPriority(Priority priority) { mPriority = uint8_t(priority); }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// Monitor used for free list.
+    /// Run on the blocking pool instead of a worker, same rules as
+    /// SetPriority.
     // ------------------------------------------------------------------------------------  MEMBER
-    static xr::Core::Mutex        sMutex;
-    static xr::Core::Monitor      sMonitor;
+    inline void SetBlocking() { mPriority = uint8_t(kBlockingLane); }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// shared value used to prevent duplicate values, they must be unique.
+    /// Run on a fiber (IManager::InsertFiber), same rules as SetPriority.
     // ------------------------------------------------------------------------------------  MEMBER
-    static uint64_t         sGlobalXID;
+    inline void SetFiber() { mFlags = uint16_t(mFlags | kFlagFiber); }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// This value is tuned to Keep a JobInstance at 16 pointers.
     // ------------------------------------------------------------------------------------  MEMBER
-#if XR_PLATFORM_PTR_SIZE == 4
-    static const size_t  kEventListNumAllocated = 5;
-#else
-    static const size_t  kEventListNumAllocated = 6;
-#endif
-
+    inline bool IsFiber() const { return (mFlags & kFlagFiber) != 0; }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// This array size is tuned to Keep a JobInstance at 16 pointers.
+    /// Resumes a fiber: never cancelled, not part of any token.
     // ------------------------------------------------------------------------------------  MEMBER
-    static const size_t  kEventListMaxUsable = kEventListNumAllocated-1;
-
-
+    inline void SetResume() { mFlags = uint16_t(mFlags | kFlagResume); mToken = nullptr; }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// Our Unique ID
+    /// Holds a barrier on \a timer (ArmDelayed), so Cancel can unlink it.
+    /// Call with mTimerMutex held, before the handle escapes.
     // ------------------------------------------------------------------------------------  MEMBER
-    volatile uint64_t          mXID;
+    inline void SetDelayTimer(Timer * timer) { mFlags = uint16_t(mFlags | kFlagDelayed); mDelayTimer = timer; }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// Update mRemainingAntecedents atomically
+    /// The timer still holding the barrier, nullptr once it fired or was
+    /// cancelled. Only meaningful under mTimerMutex while the XID is live.
     // ------------------------------------------------------------------------------------  MEMBER
-    volatile uintptr_t         mRemainingAntecedents;
+    inline Timer * GetDelayTimer() const { return mDelayTimer; }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// This is where it goes once ready
+    /// Under mTimerMutex, as the timer leaves the wheel.
     // ------------------------------------------------------------------------------------  MEMBER
-    Core::BlockingQueue<JobInstance*>* mReadyList;
+    inline void ClearDelayTimer() { mEnabledBy = 0; }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// This is where it goes when done
     // ------------------------------------------------------------------------------------  MEMBER
-    Core::BlockingStack<JobInstance*>* mFreeList;
+    inline size_t GetPriority() const { return mPriority; }
     // ------------------------------------------------------------------------------------  MEMBER
-    /// Runnable Object
+    /// JobGroupState::mIndex of the job's group, 0 for none. Initialize
+    /// takes it from the current JobGroupScope.
     // ------------------------------------------------------------------------------------  MEMBER
-    Core::Runnable             mRunnable;
+    inline size_t GetGroup() const { return mGroup; }
+    inline void SetGroup(size_t group) { mGroup = uint8_t(group); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// nullptr for IManager::GetCompletedHandle()'s instance.
     // ------------------------------------------------------------------------------------  MEMBER
-    /// Protected by sMutex
+    inline ManagerInternal * GetManager() const { return mManager; }
     // ------------------------------------------------------------------------------------  MEMBER
-    volatile uintptr_t         mEventListCount;
+    /// Nothing to do here.
+    /// Call Initialize explicitly.
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// No destructor: trivially destructible keeps array new from putting
+    /// a cookie in front of the slab, which would misalign every instance.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance() { }
+private:
     // ------------------------------------------------------------------------------------  MEMBER
-    /// Protected by sMutex
+    /// Closes the successor list and notifies everything on it, returning
+    /// the first successor it enabled instead of enqueueing it. \a xid is
+    /// ours, already invalidated in mXID. With \a cancel the successors
+    /// are cancelled (kCancelSuccessors) before they are notified.
     // ------------------------------------------------------------------------------------  MEMBER
-    JobInstance    *  volatile mEventList[kEventListNumAllocated];
+    JobInstance * NotifySuccessors(uint64_t xid, bool cancel);
     // ------------------------------------------------------------------------------------  MEMBER
+    /// Waits for an adder that reserved a slot to publish it.
     // ------------------------------------------------------------------------------------  MEMBER
-    Core::Arguments       mArguments;
-};
+    template <class T>
+    static inline T * WaitForPublish(T * volatile * slot);
 
-static_assert(sizeof(JobInstance) == (16 * sizeof(void*)), "size validation" );
+    friend class JobInstancePool;
 
-/*-----------------------------------------------------------------------*/
-/*-----------------------------------------------------------------------*/
-xr::Core::Mutex        JobInstance::sMutex;
-xr::Core::Monitor      JobInstance::sMonitor;
-uint64_t JobInstance::sGlobalXID = 0;
-// --------------------------------------------------------------------------------------  FUNCTION
-// --------------------------------------------------------------------------------------  FUNCTION
-JobHandle  JobInstance::Initialize(Core::Runnable r, size_t antecedentCount, const Core::Arguments *a)
-{
-    mArguments = a != nullptr ? *a : Core::Arguments(0,0,0,0);
-    return Initialize(r, antecedentCount);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Off Linux, what waiters sleep on.
+    /// Striped by instance address, each bucket on its own cache line.
+    // ------------------------------------------------------------------------------------  MEMBER
+    XR_ALIGN_PREFIX(64)
+    struct WaitBucket
+    {
+        xr::Core::Mutex        mMutex;
+        xr::Core::Monitor      mMonitor;
+    } XR_ALIGN_POSTFIX(64);
+    static const size_t kWaitBucketCount = 64;
+    static WaitBucket   sWaitBuckets[kWaitBucketCount];
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    static inline WaitBucket & GetWaitBucket(const JobInstance * ji)
+    {
+        // Instances are 3 cache lines apart, drop the bits that never change.
+        return sWaitBuckets[(uintptr_t(ji) / sizeof(JobInstance)) & (kWaitBucketCount - 1)];
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Called after mXID is invalidated.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void WakeWaiters();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// This array size is tuned to fill the first cache line.
+    // ------------------------------------------------------------------------------------  MEMBER
+#if XR_PLATFORM_PTR_SIZE == 4
+    static const size_t  kInlineSuccessorCount = 7;
+#else
+    static const size_t  kInlineSuccessorCount = 3;
+#endif
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// mSuccessorState layout: generation | closed | cancelled | cancel
+    /// successors | reserved count. The generation is the low word of the
+    /// XID. 64 bits everywhere, so 32-bit targets get the same 29 bit count
+    /// (far more successors than there can be instances).
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t     kSuccessorGenerationShift = 32;
+    static const uint64_t   kSuccessorClosed          = uint64_t(1) << (kSuccessorGenerationShift - 1);
+    static const uint64_t   kSuccessorCancelled       = uint64_t(1) << (kSuccessorGenerationShift - 2);
+    static const uint64_t   kSuccessorCancelSuccessors= uint64_t(1) << (kSuccessorGenerationShift - 3);
+    static const uint64_t   kSuccessorCancelMask      = kSuccessorCancelled | kSuccessorCancelSuccessors;
+    static const uint64_t   kSuccessorCountMask       = kSuccessorCancelSuccessors - 1;
+    static inline uint64_t  SuccessorGeneration(uint64_t xid) { return uint64_t(uint32_t(xid)) << kSuccessorGenerationShift; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// A plain read of mSuccessorState can tear on 32-bit targets.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline uint64_t LoadSuccessorState()
+    {
+#if XR_PLATFORM_PTR_SIZE == 4
+        return xr::Core::AtomicCompareAndSwap(&mSuccessorState, uint64_t(0), uint64_t(0));
+#else
+        return mSuccessorState;
+#endif
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// mFlags bits.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const uint16_t   kFlagFiber                = 1;
+    static const uint16_t   kFlagResume               = 2;
+    static const uint16_t   kFlagDelayed              = 4;
+
+
+    //`````````````````````````````````````````````````````````````````
+    // First cache line: written by other threads while the job is live.
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Our Unique ID, (line number << 32) | mGeneration. Invalid once done.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uint64_t          mXID;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// See kSuccessorGenerationShift, updated by CAS only.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uint64_t          mSuccessorState;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Update mRemainingAntecedents atomically
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uint32_t          mRemainingAntecedents;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Low word of the last XID handed out, only Initialize touches it.
+    // ------------------------------------------------------------------------------------  MEMBER
+    uint32_t                   mGeneration;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Threads in WaitOn. Not reset by Initialize, a waiter on a previous
+    /// use of the instance may still be leaving.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uint32_t          mWaiterCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Priority (ready lane) and group, see GetGroup.
+    // ------------------------------------------------------------------------------------  MEMBER
+    uint8_t                    mPriority;
+    uint8_t                    mGroup;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// kFlagFiber, kFlagResume, kFlagDelayed
+    // ------------------------------------------------------------------------------------  MEMBER
+    uint16_t                   mFlags;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// First successors, nullptr until the adder that reserved it writes it.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance    *  volatile mSuccessors[kInlineSuccessorCount];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The rest, see SuccessorChunk.
+    // ------------------------------------------------------------------------------------  MEMBER
+    SuccessorChunk *  volatile mOverflow;
+
+    //`````````````````````````````````````````````````````````````````
+    // The rest: written by the inserter, read by the runner.
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// This is where it goes once ready
+    // ------------------------------------------------------------------------------------  MEMBER
+    ManagerInternal                  * mManager;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// mNextFree is the link used while in the JobInstancePool. Instances
+    /// are never freed while the manager exists, so a stale read of it is
+    /// harmless. Initialize zeroes all 64 bits of mEnabledBy (popping only
+    /// clears the pointer, the low word on 32-bit targets), so it reads 0
+    /// (see GetEnabledBy) until NotifySuccessors sets it. A delayed job
+    /// can not be enabled by a predecessor, it keeps its timer here until
+    /// the timer fires.
+    // ------------------------------------------------------------------------------------  MEMBER
+    union
+    {
+        JobInstance                  * mNextFree;
+        uint64_t                       mEnabledBy;
+        Timer                        * mDelayTimer;
+    };
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runnable Object
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::Runnable             mRunnable;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// CancellationScope the job was inserted under, nullptr if none.
+    // ------------------------------------------------------------------------------------  MEMBER
+    CancellationToken        * mToken;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Destroys the payload after the run, nullptr if there is nothing to do.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void                    (* mDestroy)(void * object);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Arena payload, nullptr if the payload (if any) is inline.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void                     * mPayloadBlock;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::Arguments       mArguments;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Inline payloads start at mArguments and continue into this.
+    // ------------------------------------------------------------------------------------  MEMBER
+    uint8_t               mPayloadTail[IManager::kInlinePayloadSize - sizeof(Core::Arguments)];
+} XR_ALIGN_POSTFIX(64);
+
+#if XR_PLATFORM_PTR_SIZE == 4
+static_assert(sizeof(JobInstance) == 2 * JobInstance::kAlignment, "size validation" );
+#else
+static_assert(sizeof(JobInstance) == 3 * JobInstance::kAlignment, "size validation" );
+#endif
+
+// ***************************************************************************************** - TYPE
+/*! One of the pooled stacks fiber jobs run on (IManager::InsertFiber).
+    The fiber runs Main, a loop starting mJob each time it is handed one.
+    Everything here belongs to whichever thread is running the fiber or
+    last switched it out, see "Fibers" at the top of the file. */
+// ***************************************************************************************** - TYPE
+struct FiberSlot
+{
+    FiberSlot() : mJob(nullptr), mNext(nullptr), mThread(nullptr), mWaitOn(nullptr), mWaitXid(0), mToken(nullptr), mGroup(nullptr), mScratch(nullptr), mNextFree(nullptr) {}
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Entry point of mFiber.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static void Main(void * slot);
+
+    Core::Fiber              mFiber;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Job started on the fiber, nullptr once it has completed. mNext is
+    /// what its Run returned.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance            * mJob;
+    JobInstance            * mNext;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Worker that switched to the fiber last, where it switches back to.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobThread              * mThread;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Job the fiber switched out to wait on, for the worker to pick up.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance            * mWaitOn;
+    uint64_t                 mWaitXid;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The job's CancellationScope token and JobGroupScope group while
+    /// switched out.
+    // ------------------------------------------------------------------------------------  MEMBER
+    CancellationToken      * mToken;
+    JobGroupState          * mGroup;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// GetJobScratch for the job, cleared when it completes.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::LinearAllocator  * mScratch;
+    FiberSlot              * mNextFree;
+};
+// --------------------------------------------------------------------------------------  FUNCTION
+/*! A scratch arena and its first bucket of \a size bytes, one block. */
+// --------------------------------------------------------------------------------------  FUNCTION
+static Core::LinearAllocator * CreateScratch(size_t size)
+{
+    const size_t header = Core::AlignSize(sizeof(Core::LinearAllocator), 64);
+    uint8_t * block = (uint8_t *)XR_ALLOC_ALIGN(header + size, "Scheduler::Scratch", 64);
+    // Overflow in buckets as large as the first, at least a page.
+    return new (block) Core::LinearAllocator("Scheduler::Scratch", block + header, size, size < 4096 ? 4096 : size);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+static void DestroyScratch(Core::LinearAllocator * scratch)
+{
+    if(scratch != nullptr)
+    {
+        scratch->~LinearAllocator();
+        XR_FREE(scratch);
+    }
+}
+
+// ***************************************************************************************** - TYPE
+/*! Lock free stack of free JobInstances (Treiber stack, the tag in the high
+    half of mHead prevents ABA). Callers on a worker pass their magazine and
+    only hit the shared stack once per batch. When everything is in use
+    Pop either fails or blocks until an instance is pushed back. */
+// ***************************************************************************************** - TYPE
+class JobInstancePool
+{
+public:
+    JobInstancePool();
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Initialize(JobInstance * instances, size_t count, JobThread * threads, size_t numThreads);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Add \a count more free instances (already RunOnce'd).
+    // ------------------------------------------------------------------------------------  MEMBER
+    void AddInstances(JobInstance * instances, size_t count);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// magazine may be nullptr (non worker threads). If every instance is
+    /// in use, waits for one, or returns nullptr if \a wait is false.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * Pop(JobMagazine * magazine, bool wait = true);
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Push(JobMagazine * magazine, JobInstance * ji);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Return everything held by magazine to the shared stack.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Flush(JobMagazine * magazine);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Fewest instances the shared stack has held.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline uintptr_t GetLowWater() const { return mLowWater; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Pops that found every instance in use.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline uintptr_t GetExhaustedCount() const { return mExhausted; }
+private:
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// nullptr if empty.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * PopShared();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The shared stack is empty, drain the magazines and, if \a wait,
+    /// wait for a push.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * PopStarved(bool wait);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Push a chain of \a count instances already linked through mNextFree.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void PushShared(JobInstance * first, JobInstance * last, size_t count);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Take the magazine's whole list and push it to the shared stack.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void DrainMagazine(JobMagazine * magazine);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Give the magazine back if someone is starved for instances.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void AfterMagazineFill(JobMagazine * magazine);
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Workers (and their magazines).
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobThread                      * mThreads;
+    size_t                           mNumThreads;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// mPtrs[0] = top, mInts[1] = tag
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile Core::AtomicDoublePointer mHead;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Only used when the stack runs dry.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mWaiters;
+    volatile uintptr_t               mPushEpoch;
+    xr::Core::Mutex                  mMutex;
+    xr::Core::Monitor                mMonitor;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Statistics. mSharedCount may briefly lag the stack itself.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mSharedCount;
+    volatile uintptr_t               mLowWater;
+    volatile uintptr_t               mExhausted;
+};
+
+// ***************************************************************************************** - TYPE
+/*! Storage for payloads too large to be inline. Power of two size classes
+    carved from 64K chunks, which are only returned when the manager is
+    destroyed. Workers pass their PayloadCache and move blocks to and from
+    the shared lists in batches. */
+// ***************************************************************************************** - TYPE
+class PayloadArena
+{
+public:
+    PayloadArena();
+    ~PayloadArena();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// cache may be nullptr (non worker threads).
+    // ------------------------------------------------------------------------------------  MEMBER
+    void * Alloc(PayloadCache * cache, size_t size);
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Free(PayloadCache * cache, void * payload);
+private:
+    static const size_t kChunkSize = 64 * 1024;
+    static const size_t kChunkHeaderSize = 64;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Blocks moved between a cache and the shared lists at a time.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const size_t kBatch = 16;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Unlinks up to \a count blocks (at least one) from the shared list,
+    /// carving a new chunk if it is empty. Must hold mMutex.
+    // ------------------------------------------------------------------------------------  MEMBER
+    PayloadBlock * TakeLocked(size_t sizeClass, size_t * count);
+
+    PayloadBlock   * mShared[PayloadCache::kNumClasses];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Chunks, linked through their first word.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void           * mChunks;
+    xr::Core::Mutex  mMutex;
+};
+
+// ***************************************************************************************** - TYPE
+/*! One pending InsertDelayed / InsertPeriodic. Timers are kept for reuse
+    until the manager is destroyed, so a stale PeriodicHandle only ever
+    finds a timer with another mID. */
+// ***************************************************************************************** - TYPE
+struct Timer
+{
+    Timer               * mNext;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Whatever points at us in the wheel, nullptr when not in it.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Timer              ** mLink;
+    uint64_t              mTick;        ///< Deadline, in ticks from the wheel's start
+    uint64_t              mID;          ///< 0 while free
+    uint64_t              mPeriod;      ///< Microseconds, 0 for a one shot
+    uint64_t              mDue;         ///< Periodic: current deadline, microseconds from the wheel's start
+    JobInstance         * mJob;         ///< One shot: holds a barrier on it
+    Core::Runnable        mRunnable;    ///< Periodic
+    Core::Arguments       mArguments;
+    void                (*mDestroy)(void * object);
+    void                * mPayload;     ///< Periodic lambda, from the payload arena
+    uint16_t              mPriority;
+    uint8_t               mLevel;
+    volatile bool         mCancelled;   ///< Periodic, cancelled while queued or running
+};
+
+// ***************************************************************************************** - TYPE
+/*! Hierarchical timer wheel (Varghese & Lauck). Level n has kSlots slots
+    of kSlots^n ticks each, a timer sits in the lowest level its deadline
+    fits and moves down when its slot comes up (cascade). Insert and
+    remove are O(1), Advance is O(ticks passed) but skips empty stretches.
+    Not thread safe. */
+// ***************************************************************************************** - TYPE
+class TimerWheel
+{
+public:
+    static const size_t   kLevels   = 4;
+    static const size_t   kSlotBits = 8;
+    static const size_t   kSlots    = size_t(1) << kSlotBits;
+    static const uint64_t kNever    = XR_UINT64_MAX;
+
+    TimerWheel();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Deadlines already passed fire on the next Advance.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void     Add(Timer * timer);
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void     Remove(Timer * timer);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Unlinks every timer due at or before tick \a now, returned as a list
+    /// through mNext.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Timer *  Advance(uint64_t now);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Earliest tick at which Advance can have something to do, kNever if
+    /// the wheel is empty. A slot scan, call after Advance, not per Add.
+    // ------------------------------------------------------------------------------------  MEMBER
+    uint64_t GetNextTick() const;
+private:
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void     Cascade(size_t level, size_t slot);
+
+    Timer  * mSlots[kLevels][kSlots];
+    size_t   mLevelCount[kLevels];
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Next tick to process.
+    // ------------------------------------------------------------------------------------  MEMBER
+    uint64_t mCurrent;
+};
+
+// ***************************************************************************************** - TYPE
+/*! A thread of the BlockingPool. */
+// ***************************************************************************************** - TYPE
+class BlockingThread: public Core::Thread
+{
+public:
+    BlockingThread() : Core::Thread("Scheduler::Blocking"), mPool(nullptr) {}
+    BlockingPool * mPool;
+protected:
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    uintptr_t Run() XR_OVERRIDE;
+};
+
+// ***************************************************************************************** - TYPE
+/*! Elastic pool of threads for jobs which block, see IManager::
+    InsertBlocking. A FIFO ring of ready blocking jobs under one mutex,
+    blocking jobs are long compared with the lock. */
+// ***************************************************************************************** - TYPE
+class BlockingPool
+{
+public:
+    BlockingPool();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Starts \a minThreads threads.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Initialize(size_t minThreads, size_t maxThreads, uint64_t idleMicroSeconds);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runs what is queued, then joins every thread.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Shutdown();
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Enqueue(JobInstance * ji);
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline uintptr_t GetThreadCount() const     { return mThreadCount; }
+    inline uintptr_t GetThreadHighWater() const { return mThreadHighWater; }
+    inline uintptr_t GetJobsRun() const         { return mJobsRun; }
+private:
+    friend class BlockingThread;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Next job, waiting for one. nullptr once the calling thread should
+    /// exit (idle too long, or shutting down).
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * Pop(BlockingThread * self);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Must hold mMutex.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void StartThreadLocked();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Joins and deletes exited threads, must hold mMutex.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void JoinRetiredLocked();
+
+    xr::Core::Mutex                  mMutex;
+    xr::Core::Monitor                mMonitor;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Ring of ready jobs, capacity is a power of 2 and doubles when full.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance                   ** mRing;
+    size_t                           mCapacity;
+    size_t                           mHead;
+    size_t                           mCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Running threads, and those which exited but are not joined yet.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::Vector<BlockingThread *>   mThreads;
+    Core::Vector<BlockingThread *>   mRetired;
+    size_t                           mIdleCount;
+    size_t                           mMinThreads;
+    size_t                           mMaxThreads;
+    uint64_t                         mIdleMicroSeconds;
+    bool                             mQuit;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Only written under mMutex, read racily by GetStats.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mThreadCount;
+    volatile uintptr_t               mThreadHighWater;
+    volatile uintptr_t               mJobsRun;
+};
+
+// ***************************************************************************************** - TYPE
+// ***************************************************************************************** - TYPE
+class ManagerInternal : public IManager{
+public:
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertReady(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertReady(
+        size_t runnableCount,
+        Core::Runnable * runnableArray,
+        size_t argumentsCount,
+        const Core::Arguments * argsArray,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandleBlocked InsertBlocked(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandleBlocked InsertBlocked(
+        size_t runnableCount,
+        Core::Runnable * runnableArray,
+        size_t argumentsCount,
+        const Core::Arguments * argsArray,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertAfter(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        JobHandle * handle0,
+        size_t handleCount,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle TryInsertReady(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle TryInsertAfter(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        JobHandle * handle0,
+        size_t handleCount,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle ParallelFor(
+        size_t begin,
+        size_t end,
+        size_t grainSize,
+        detail::ParallelForBody * body,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertPayload(
+        const detail::PayloadType * type,
+        void * object,
+        size_t barrierCount,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle TryInsertPayload(
+        const detail::PayloadType * type,
+        void * object,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertBlocking(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        JobHandle * antecedentArray,
+        size_t arrayCount) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertFiber(
+        Core::Runnable r,
+        const Core::Arguments *args,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertFiberPayload(
+        const detail::PayloadType * type,
+        void * object,
+        JobHandle * antecedentArray,
+        size_t arrayCount,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertBlockingPayload(
+        const detail::PayloadType * type,
+        void * object,
+        JobHandle * antecedentArray,
+        size_t arrayCount) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertDelayed(
+        uint64_t delayMicroSeconds,
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle InsertDelayedPayload(
+        uint64_t delayMicroSeconds,
+        const detail::PayloadType * type,
+        void * object,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    PeriodicHandle InsertPeriodic(
+        uint64_t periodMicroSeconds,
+        Core::Runnable r,
+        const Core::Arguments *args,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    PeriodicHandle InsertPeriodicPayload(
+        uint64_t periodMicroSeconds,
+        const detail::PayloadType * type,
+        void * object,
+        Priority priority) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool CancelPeriodic(PeriodicHandle handle) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobHandle WhenAll(JobHandle * antecedentArray, size_t arrayCount) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t GetReadyCount(Priority priority) const XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobGroup CreateGroup(const char * name, size_t weight, size_t maxConcurrency) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool GetGroupStats(JobGroup group, GroupStats * stats) const XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t GetStats(Stats * stats, WorkerStats * workers, size_t maxWorkers) const XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void SetTracing(bool enable) XR_OVERRIDE;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t WriteTrace(TraceWriter writer, void * context) const XR_OVERRIDE;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Makes a ready job runnable. Goes to the calling worker's deque for
+    /// the job's lane if called from one of our workers, otherwise to the
+    /// lane's shared ReadyList.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Enqueue(JobInstance * ji);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Enqueue which returns false instead of waiting for room in a full
+    /// ReadyList.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool TryEnqueue(JobInstance * ji);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Releases \a count barriers of a job a TryInsert call just made, the
+    /// job is queued with TryEnqueue if that enables it. On failure the
+    /// job is abandoned (nothing else can reference an enabled job the
+    /// caller has not returned yet) and false is returned.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool TryReleaseInserted(JobInstance * ji, size_t count);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// All instances must have the same priority.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Enqueue(JobInstance ** instances, size_t count);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Queues a grouped job in its group's lane, waiting for room unless
+    /// \a tryOnly (then false if it is full). Does not wake anyone.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool EnqueueGroup(JobInstance * ji, bool tryOnly);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Groups created so far, see "Groups" at the top of the file.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline size_t GetGroupCount() const { return size_t(xr::Core::AtomicLoadAcquire(&mGroupCount)); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Group with JobGroupState::mIndex \a index (not 0).
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline JobGroupState * GetGroup(size_t index) const { return mGroups[index - 1]; }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Called by a worker which found nothing to do. Returns when there
+    /// may be new work or quit was requested, true instead if the worker
+    /// should retire (see Retire).
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool Park(JobThread * thread);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Takes the newest worker out of the pool (if it still is the newest,
+    /// and above mMinThreads) and sleeps until it is revived or quit is
+    /// requested.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void Retire(JobThread * thread);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Work was pushed with no worker idle or spinning. Adds a worker once
+    /// that has gone on for mGrowLatency.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void CheckBacklog();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Called by a worker which ran out of work.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void ClearBacklog()
+    {
+        if(mBacklogSince != 0)
+        {
+            mBacklogSince = 0;
+        }
+    }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Workers not retired, see "Elastic pool" at the top of the file.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline size_t GetActiveThreads() const { return size_t(mActiveThreads); }
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Wakes parked workers (if any) after new work was published.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void WakeWorkers(size_t count);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Get a free instance, blocks if none are available (and the pool
+    /// can not grow).
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline JobInstance * AllocInstance();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Get a free instance, growing the pool if allowed, nullptr if none.
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobInstance * TryAllocInstance();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Adds mOptions.mFreeListGrowSize instances to the pool. Returns false
+    /// if growth is disabled or at mFreeListMaxSize.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool GrowFreeList();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Calls mOptions.mBackpressure, if set.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void NotifyBackpressure(Backpressure what);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Called by workers between jobs, services the timers if one is due.
+    /// One load and compare while there are none.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void PollTimers();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Fires every timer that is due.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void ServiceTimers();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// A cleared timer with a new ID.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Timer * AllocTimer();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Destroys the periodic payload (if any), must hold mTimerMutex.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void FreeTimerLocked(Timer * timer);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Puts \a timer (mTick set) in the wheel, returns true if it is the
+    /// new earliest. Must hold mTimerMutex.
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool AddTimerLocked(Timer * timer);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// AddTimerLocked, then wakes a worker to watch the timer if needed.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void ArmTimer(Timer * timer);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The deadline moved earlier, see "Timers" at the top of the file.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void WakeTimerKeeper();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Hold a barrier on \a ji and release it in \a delayMicroSeconds.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void ArmDelayed(JobInstance * ji, uint64_t delayMicroSeconds);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// \a ji (cancelled, \a xid) stops waiting for its timer and runs now,
+    /// which only completes it. Nothing if the timer already fired.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void CancelDelayed(JobInstance * ji, uint64_t xid);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Puts a periodic timer back once its run is done, or frees it if it
+    /// was cancelled meanwhile.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void RearmPeriodic(Timer * timer);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Job body of a periodic timer. a0 = Timer, a1 = ManagerInternal.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static void RunPeriodic(const Core::Arguments * args);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Microseconds since mTimerBase.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline uint64_t GetTimerMicroSeconds() const;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// First tick starting after \a microSeconds (from mTimerBase).
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline uint64_t DeadlineToTick(uint64_t microSeconds) const;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// TimeStamp by which \a tick has started, kNoTimer for kNever.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline Core::TimeStamp TickToTimeStamp(uint64_t tick) const;
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void FreeInstance(JobInstance * ji);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// A free fiber, nullptr if every one is in use.
+    // ------------------------------------------------------------------------------------  MEMBER
+    FiberSlot * AllocFiber();
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    void FreeFiber(FiberSlot * slot);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Queues the job resuming \a slot once ji / xid completes.
+    // ------------------------------------------------------------------------------------  MEMBER
+    void ResumeAfter(FiberSlot * slot, JobInstance * ji, uint64_t xid, Priority priority);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runnable of the resume jobs, a0 = FiberSlot.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static void ResumeFiber(const Core::Arguments * args);
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The calling thread's magazine, nullptr if not one of our workers.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline JobMagazine * GetMagazine();
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Arena storage for payloads larger than kInlinePayloadSize.
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void * AllocPayload(size_t size);
+    // ------------------------------------------------------------------------------------  MEMBER
+    // ------------------------------------------------------------------------------------  MEMBER
+    inline void FreePayload(void * payload);
+
+private:
+
+    InitializeOptions                mOptions;
+    JobInstance                    * mInstances;
+    JobThread                      * mThreads;
+    xr::Core::BlockingQueue<JobInstance *> * mReadyLists[kPriorityCount];
+    JobInstancePool                  mFreeList;
+    PayloadArena                     mPayloads;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Instances added by GrowFreeList, and the total including mInstances.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::Vector<JobInstance *>      mSlabs;
+    volatile uintptr_t               mInstanceCount;
+    xr::Core::Mutex                  mGrowMutex;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// InsertDelayed / InsertPeriodic, see "Timers" at the top of the file.
+    /// mTimers is every timer ever allocated, free ones are also on
+    /// mFreeTimers.
+    // ------------------------------------------------------------------------------------  MEMBER
+    static const Core::TimeStamp     kNoTimer = XR_INT64_MAX;
+    TimerWheel                       mTimerWheel;
+    xr::Core::Mutex                  mTimerMutex;
+    Core::Vector<Timer *>            mTimers;
+    Timer                          * mFreeTimers;
+    uint64_t                         mNextTimerID;
+    Core::TimeStamp                  mTimerBase;
+    double                           mStampsPerTick;
+    volatile Core::TimeStamp         mNextTimerDeadline;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// A parked worker waits on mTimerMonitor for the next deadline (under
+    /// mIdleMutex, like the other parked ones).
+    // ------------------------------------------------------------------------------------  MEMBER
+    bool                             mTimerKeeper;
+    xr::Core::Monitor                mTimerMonitor;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Runs jobs in kBlockingLane.
+    // ------------------------------------------------------------------------------------  MEMBER
+    BlockingPool                     mBlocking;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// mOptions.mFiberCount fibers (nullptr if none), the free ones are
+    /// linked from mFreeFibers.
+    // ------------------------------------------------------------------------------------  MEMBER
+    FiberSlot                      * mFiberSlots;
+    FiberSlot                      * mFreeFibers;
+    xr::Core::Mutex                  mFiberMutex;
+    volatile uintptr_t               mFibersExhausted;
+
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Workers which are idle or about to park. Read by every push.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mIdleCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Workers in SpinForWork. Read by every push.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mSpinningCount;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// mOptions.mSpinMicroSeconds in TimeStamp units.
+    // ------------------------------------------------------------------------------------  MEMBER
+    Core::TimeStamp                  mSpinLimit;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Incremented (under mIdleMutex) on every wake, parked workers wait
+    /// for it to change.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mWakeEpoch;
+    xr::Core::Mutex                  mIdleMutex;
+    xr::Core::Monitor                mIdleMonitor;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Distinct NUMA nodes workers were placed on.
+    // ------------------------------------------------------------------------------------  MEMBER
+    size_t                           mNumNodes;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// mThreads holds mOptions.mMaxThreads workers, mStartedThreads of them
+    /// have a thread and mActiveThreads are not retired. See "Elastic pool"
+    /// at the top of the file.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mActiveThreads;
+    size_t                           mStartedThreads;
+    bool                             mElastic;
+    xr::Core::Mutex                  mElasticMutex;
+    xr::Core::Monitor                mElasticMonitor;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// When work was first pushed with every worker busy, 0 once one runs
+    /// out. mGrowLatency and mRetireIdle are the options in TimeStamp units.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile Core::TimeStamp         mBacklogSince;
+    Core::TimeStamp                  mGrowLatency;
+    Core::TimeStamp                  mRetireIdle;
+    volatile uintptr_t               mActiveHighWater;
+    volatile uintptr_t               mWorkersAdded;
+    volatile uintptr_t               mWorkersRetired;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// The first mGroupCount entries are in use, see "Groups".
+    // ------------------------------------------------------------------------------------  MEMBER
+    JobGroupState                  * mGroups[IManager::kMaxGroups];
+    volatile uintptr_t               mGroupCount;
+    xr::Core::Mutex                  mGroupMutex;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Statistics not owned by any one worker, see GetStats.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile uintptr_t               mReadyListHighWater[kPriorityCount];
+    volatile uintptr_t               mSuccessorChunks;
+    volatile uintptr_t               mWaitCalls;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Workers record jobs while set, see SetTracing.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile bool                    mTracing;
+
+    friend class IManager;
+    friend class JobThread;
+    friend class JobInstance;
+};
+
+
+/*-----------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------*/
+JobInstance::WaitBucket JobInstance::sWaitBuckets[JobInstance::kWaitBucketCount];
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle  JobInstance::Initialize(Core::Runnable r, size_t antecedentCount, const Core::Arguments *a)
+{
+    mArguments = a != nullptr ? *a : Core::Arguments(0,0,0,0);
+    return Initialize(r, antecedentCount);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle  JobInstance::Initialize(Core::Runnable r, size_t antecedentCount)
+{
+    XR_ASSERT_DEBUG_LT(antecedentCount, size_t(XR_UINT32_MAX));
+    mRemainingAntecedents  = (uint32_t)antecedentCount;
+    mRunnable              = r;
+    // Nobody else can see the instance yet, see "Instances" at the top of
+    // the file. The low word is the futex word, it must never look invalid.
+    mGeneration            = mGeneration + 1;
+    if(mGeneration == uint32_t(JobHandle::kJobInstanceHandleInvalid))
+    {
+        mGeneration = 0;
+    }
+    const uint64_t xid     = (uint64_t(uint32_t(uintptr_t(this) / kAlignment)) << 32) | mGeneration;
+    mXID                   = xid;
+    mSuccessorState        = SuccessorGeneration(xid);
+    mPriority              = kPriorityNormal;
+    mFlags                 = 0;
+    mDestroy               = nullptr;
+    mPayloadBlock          = nullptr;
+    mOverflow              = nullptr;
+    mEnabledBy             = 0;
+    mToken                 = sTokenScopes != 0 ? sCurrentToken.GetValue() : nullptr;
+    mGroup                 = 0;
+    if(sGroupScopes != 0)
+    {
+        JobGroupState * group = sCurrentGroup.GetValue();
+        if(group != nullptr && group->mManager == mManager)
+        {
+            mGroup = uint8_t(group->mIndex);
+        }
+    }
+
+    for(size_t i = 0; i < kInlineSuccessorCount; i++)
+    {
+        mSuccessors[i] = nullptr;
+    }
+    return JobHandle(mXID, this);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::SetPayload(const detail::PayloadType * type, void * object)
+{
+    void * storage;
+    if(type->mSize <= IManager::kInlinePayloadSize)
+    {
+        storage   = &mArguments;
+        mRunnable = type->mRun;
+    }
+    else
+    {
+        storage       = mManager->AllocPayload(type->mSize);
+        mPayloadBlock = storage;
+        mArguments.a0 = (uintptr_t)storage;
+        mRunnable     = type->mRunIndirect;
+    }
+    type->mMove(storage, object);
+    mDestroy = type->mDestroy;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::Release()
+{
+    XR_ASSERT_DEBUG_EQ(mXID, JobHandle::kJobInstanceHandleInvalid);
+    mManager->FreeInstance(this);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::Abandon()
+{
+    if(mDestroy != nullptr)
+    {
+        mDestroy(mPayloadBlock != nullptr ? mPayloadBlock : (void *)&mArguments);
+    }
+    if(mPayloadBlock != nullptr)
+    {
+        mManager->FreePayload(mPayloadBlock);
+    }
+    // Nobody holds the XID, so there is nobody to wake or notify.
+    mXID = JobHandle::kJobInstanceHandleInvalid;
+    Release();
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobInstance::Run()
+{
+    XR_ASSERT_ALWAYS_EQ(mRemainingAntecedents, 0);
+
+    const uint64_t xid = mXID;
+    XR_ASSERT_ALWAYS_NE(xid, JobHandle::kJobInstanceHandleInvalid);
+
+    // Last chance to be cancelled, see "Cancellation" at the top of the file.
+    const uint64_t cancelState = (mFlags & kFlagResume) == 0 ? LoadSuccessorState() & kSuccessorCancelMask : 0;
+    const bool tokenCancelled = mToken != nullptr && mToken->IsCancelled();
+    const bool cancelled = cancelState != 0 || tokenCancelled;
+    const bool cancelSuccessors = (cancelState & kSuccessorCancelSuccessors) != 0 ||
+        (tokenCancelled && mToken->GetPolicy() == kCancelSuccessors);
+    if(cancelled)
+    {
+        JobThread * thread = JobThread::GetCurrent();
+        if(thread != nullptr)
+        {
+            thread->mCounters.mJobsCancelled = thread->mCounters.mJobsCancelled + 1;
+        }
+    }
+
+    // Jobs inserted by this one join its token and group.
+    const bool scoped = !cancelled && (mToken != nullptr || sTokenScopes != 0);
+    CancellationToken * outerToken = scoped ? EnterTokenScope(mToken) : nullptr;
+    const bool grouped = !cancelled && (mGroup != 0 || sGroupScopes != 0);
+    JobGroupState * outerGroup = grouped ? EnterGroupScope(mGroup != 0 ? mManager->GetGroup(mGroup) : nullptr) : nullptr;
+
+    // Run the job.
+    if(mRunnable != nullptr && !cancelled)
+    {
+#if (XR_PLATFORM_PTR_SIZE == 4) && defined(XR_COMPILER_MICROSOFT)
+
+        // Need to handle both _cdecl (1 arg) and _thiscall (at least for 0 arguments)
+        // Call convention differences make this simple as putting the argument into both
+        // ecx (_thiscall) and pushing it onto the stack (cdecl). Differences in stack 
+        // cleanup are safe because the function takes no arguments so the stack cleanup is 
+        // benign.
+        __asm mov  ecx, dword ptr[this];
+        __asm add  ecx, mArguments;
+        __asm mov  edx, dword ptr[this];
+        __asm mov  edx, dword ptr[edx + mRunnable];;
+        __asm push ecx;
+        __asm call edx;
+        __asm add  esp,4;
+
+#elif (XR_PLATFORM_PTR_SIZE == 4) && defined(XR_COMPILER_GCC)
+
+        // Lambda expects ecx to have pointer to captures...
+        // normal functions expect it on stack. Here we place it in both.
+        // I can't find any documentation on this but it is clear based on disasm
+        // at least as of gcc 4.7 and things like this rarely change for fear of 
+        // breaking compatibility across compiler versions.
+        asm(
+            "movl %0, %%ecx ;"
+            "movl %1, %%edx ;"
+            "push %%ecx ;"
+            "call *%%edx ;"
+            "pop %%ecx ;"
+            : : "r"(&mArguments), "r"(mRunnable) : "eax", "ecx", "edx"
+            );
+
+#else
+        // X64's (and most other arch's) ABI is less complicated
+        // no need for assembly to call function.
+        mRunnable(&mArguments);
+#endif
+
+    }
+    if(scoped)
+    {
+        LeaveTokenScope(outerToken);
+    }
+    if(grouped)
+    {
+        LeaveGroupScope(outerGroup);
+    }
+
+    // Captures go before completion is signaled, a waiter may rely on
+    // their destructors having run.
+    if(mDestroy != nullptr)
+    {
+        mDestroy(mPayloadBlock != nullptr ? mPayloadBlock : (void *)&mArguments);
+    }
+    if(mPayloadBlock != nullptr)
+    {
+        mManager->FreePayload(mPayloadBlock);
+    }
+
+    //`````````````````````````````````````````````````````````````````
+    // Now do post run processing.
+    // Clear the XID, this signals the job as done. WakeWaiters fences
+    // before looking for waiters, so with none this costs nothing more.
+    mXID                       = JobHandle::kJobInstanceHandleInvalid;
+    WakeWaiters();
+
+    // Optimization: Often a job will enable other jobs, in this case
+    // just run the newly enabled job, it is probably related.
+    JobInstance * first = NotifySuccessors(xid, cancelSuccessors);
+
+    // Don't let a lower priority job ride in on our time slice, nor a
+    // grouped one skip its group's turn.
+    if(first != nullptr && (first->mPriority > mPriority || first->mGroup != 0))
+    {
+        first->mManager->Enqueue(first);
+        first = nullptr;
+    }
+
+    Release();
+
+    return first;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool JobInstance::IsComplete(uint64_t xid)
+{
+    if(mXID != xid)
+    {
+        // Definitely done. XID is invalidated after the job is complete.
+        return true;
+    }
+
+    return false;
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+template <class T>
+T * JobInstance::WaitForPublish(T * volatile * slot)
+{
+    T * value;
+    while((value = xr::Core::AtomicLoadAcquire(slot)) == nullptr)
+    {
+        xr::Core::Thread::YieldCurrentThread();
+    }
+    return value;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool JobInstance::AddSuccessor(uint64_t xid, JobInstance * successor)
+{
+    //`````````````````````````````````````````````````````````````````
+    // Reserve a slot. The state only matches while the job is not done
+    // and the instance has not been reused.
+    const uint64_t generation = SuccessorGeneration(xid);
+    uint64_t state;
+    do
+    {
+        state = LoadSuccessorState();
+        if((state & ~(kSuccessorCountMask | kSuccessorCancelMask)) != generation || mXID != xid)
+        {
+            return false;
+        }
+        XR_ASSERT_ALWAYS_LT(state & kSuccessorCountMask, kSuccessorCountMask);
+    } while(xr::Core::AtomicCompareAndSwap(&mSuccessorState, state, state + 1) != state);
+    XR_ASSERT_ALWAYS_NE(successor, this);
+
+    //`````````````````````````````````````````````````````````````````
+    // Publish it. Completion waits for this, so the instance (and its
+    // chunks) stay put until we are done.
+    size_t index = size_t(state & kSuccessorCountMask);
+    if(index < kInlineSuccessorCount)
+    {
+        xr::Core::AtomicStoreRelease(&mSuccessors[index], successor);
+        return true;
+    }
+
+    index -= kInlineSuccessorCount;
+    SuccessorChunk * volatile * link = &mOverflow;
+    SuccessorChunk * chunk;
+    for(size_t chunkIndex = 0; ; ++chunkIndex)
+    {
+        const size_t capacity = SuccessorChunk::GetCapacity(chunkIndex);
+        if(index == 0)
+        {
+            // We reserved this chunk's first slot, it is ours to create.
+            chunk = (SuccessorChunk *)mManager->AllocPayload(SuccessorChunk::GetSize(chunkIndex));
+            xr::Core::AtomicIncrement(&mManager->mSuccessorChunks);
+            JobInstance * volatile * slots = chunk->GetSlots();
+            for(size_t i = 0; i < capacity; i++)
+            {
+                slots[i] = nullptr;
+            }
+            chunk->mNext = nullptr;
+            xr::Core::AtomicStoreRelease(link, chunk);
+        }
+        else
+        {
+            chunk = WaitForPublish(link);
+        }
+
+        if(index < capacity)
+        {
+            break;
+        }
+        index -= capacity;
+        link = &chunk->mNext;
+    }
+    xr::Core::AtomicStoreRelease(&chunk->GetSlots()[index], successor);
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool JobInstance::Cancel(uint64_t xid, CancelPolicy policy)
+{
+    const uint64_t generation = SuccessorGeneration(xid);
+    const uint64_t bits = kSuccessorCancelled | (policy == kCancelSuccessors ? kSuccessorCancelSuccessors : 0);
+    uint64_t state;
+    do
+    {
+        state = LoadSuccessorState();
+        if((state & ~(kSuccessorCountMask | kSuccessorCancelMask)) != generation || mXID != xid)
+        {
+            return false;
+        }
+        if((state & bits) == bits)
+        {
+            return true;
+        }
+    } while(xr::Core::AtomicCompareAndSwap(&mSuccessorState, state, state | bits) != state);
+    if((mFlags & kFlagDelayed) != 0)
+    {
+        // Otherwise it holds everything until the deadline.
+        mManager->CancelDelayed(this, xid);
+    }
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobInstance::NotifySuccessors(uint64_t xid, bool cancel)
+{
+    uint64_t state;
+    do
+    {
+        state = LoadSuccessorState();
+    } while(xr::Core::AtomicCompareAndSwap(&mSuccessorState, state, state | kSuccessorClosed) != state);
+
+    const size_t count = size_t(state & kSuccessorCountMask);
+
+    // Enabled successors are queued a lane at a time, one push and one
+    // wake per batch rather than per job.
+    static const size_t kReadyBatch = 32;
+    JobInstance * ready[kPriorityCount][kReadyBatch];
+    size_t readyCount[kPriorityCount] = {};
+
+    JobInstance *  first = nullptr;
+    JobInstance * volatile * slots = mSuccessors;
+    size_t slotCount = kInlineSuccessorCount;
+    size_t slot = 0;
+    size_t chunkIndex = 0;
+    SuccessorChunk * chunk = nullptr;
+    for(size_t i = 0; i < count; ++i, ++slot)
+    {
+        if(slot == slotCount)
+        {
+            chunk     = WaitForPublish(chunk == nullptr ? &mOverflow : &chunk->mNext);
+            slots     = chunk->GetSlots();
+            slotCount = SuccessorChunk::GetCapacity(chunkIndex++);
+            slot      = 0;
+        }
+
+        JobInstance * successor = WaitForPublish(&slots[slot]);
+        if(cancel)
+        {
+            // It waits on us, so it is neither complete nor reused.
+            successor->Cancel(successor->mXID, kCancelSuccessors);
+        }
+        JobInstance * enabled = successor->NotifyReturnOnEnabled();
+        if(enabled == nullptr)
+        {
+            continue;
+        }
+        enabled->mEnabledBy = xid;
+        if(first == nullptr)
+        {
+            first = enabled;
+            continue;
+        }
+        if(enabled->mManager != mManager || enabled->mPriority == kBlockingLane || enabled->mGroup != 0)
+        {
+            enabled->mManager->Enqueue(enabled);
+            continue;
+        }
+
+        const size_t lane = enabled->mPriority;
+        ready[lane][readyCount[lane]++] = enabled;
+        if(readyCount[lane] == kReadyBatch)
+        {
+            mManager->Enqueue(ready[lane], kReadyBatch);
+            readyCount[lane] = 0;
+        }
+    }
+
+    for(size_t lane = 0; lane < kPriorityCount; ++lane)
+    {
+        mManager->Enqueue(ready[lane], readyCount[lane]);
+    }
+
+    // Every slot is written, nobody else can be looking at the chunks.
+    chunk = mOverflow;
+    while(chunk != nullptr)
+    {
+        SuccessorChunk * next = chunk->mNext;
+        mManager->FreePayload(chunk);
+        chunk = next;
+    }
+    return first;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::AppendAntecedent(JobInstance * source, uint64_t source_xid)
+{
+    // The job was already done.
+    if(!source->AddSuccessor(source_xid, this))
+    {
+        Notify();
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t JobInstance::AppendAntecedents(JobHandle * handles, size_t antecedentCount)
+{
+    size_t numAlreadyCompleted = 0;
+    for(size_t i = 0; i < antecedentCount; ++i)
+    {
+        if(!handles[i].mInstance->AddSuccessor(handles[i].mXID, this))
+        {
+            ++numAlreadyCompleted;
+        }
+    }
+
+    return numAlreadyCompleted;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::AppendAntecedent_NotStarted_NoLock(JobInstance * source)
+{
+    bool added = source->AddSuccessor(source->mXID, this);
+    XR_UNUSED(added);
+    XR_ASSERT_DEBUG_EQ(added, true);
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::Notify()
+{
+    uint32_t initialValue;
+    do
+    {
+        initialValue = mRemainingAntecedents;
+        // If the counter is 1, there is no contention. Just run it. 
+        if(initialValue == 1)
+        {
+            mRemainingAntecedents = 0;
+            mManager->Enqueue(this);
+            return;
+        }
+
+        // Can move to "NoFence" version
+    } while( xr::Core::AtomicCompareAndSwap(&mRemainingAntecedents, initialValue, initialValue-1) != initialValue);
+
+    XR_ASSERT_ALWAYS_NE_M(initialValue, 0, "Job has invalid antecedents count!");
+    return;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobInstance::NotifyReturnOnEnabled()
+{
+    uint32_t initialValue;
+    do
+    {
+        initialValue = mRemainingAntecedents;
+        // If the counter is 1, there is no contention. Just run it. 
+        if(initialValue == 1)
+        {
+            mRemainingAntecedents = 0;
+            return this;
+        }
+
+        // Can move to "NoFence" version
+    } while( xr::Core::AtomicCompareAndSwap(&mRemainingAntecedents, initialValue, initialValue-1) != initialValue);
+
+    XR_ASSERT_ALWAYS_NE_M(initialValue, 0, "Job has invalid antecedents count!");
+    return nullptr;
+}
+/*-----------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------*/
+void JobInstance::WaitOn(uint64_t xid)
+{
+    if(IsComplete(xid))
+    {
+        return;
+    }
+
+    // Blocking a worker wastes a core and can deadlock the pool when every
+    // worker waits, so our own workers keep running jobs instead.
+    JobThread * thread = JobThread::GetCurrent();
+    if(thread != nullptr && thread->mManager == mManager)
+    {
+        thread->mCounters.mWaitCalls = thread->mCounters.mWaitCalls + 1;
+        if(thread->mFiber != nullptr)
+        {
+            // Resumed as our successor, so we are complete by then.
+            thread->SuspendFiber(this, xid);
+            XR_ASSERT_DEBUG_TRUE(IsComplete(xid));
+            return;
+        }
+        thread->HelpUntilComplete(this, xid);
+        return;
+    }
+    xr::Core::AtomicIncrement(&mManager->mWaitCalls);
+    SleepUntilComplete(xid, kSleepForever);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::SleepUntilComplete(uint64_t xid, uint64_t microSeconds)
+{
+#if defined(XR_PLATFORM_LINUX)
+    // Register before the last check, pairs with the fence in WakeWaiters.
+    xr::Core::AtomicIncrement(&mWaiterCount);
+
+    // Low word of mXID. The kernel only sleeps if it still holds our value.
+    volatile uint32_t * word = (volatile uint32_t *)&mXID;
+#if defined(XR_PLATFORM_BIG_ENDIAN)
+    ++word;
+#endif
+    if(microSeconds == kSleepForever)
+    {
+        while(!IsComplete(xid))
+        {
+            syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, uint32_t(xid), nullptr, nullptr, 0);
+        }
+    }
+    else if(!IsComplete(xid))
+    {
+        // Relative, and the caller checks again whatever woke us.
+        struct timespec timeout;
+        timeout.tv_sec  = time_t(microSeconds / 1000000);
+        timeout.tv_nsec = long(microSeconds % 1000000) * 1000;
+        syscall(SYS_futex, word, FUTEX_WAIT_PRIVATE, uint32_t(xid), &timeout, nullptr, 0);
+    }
+
+    xr::Core::AtomicDecrement(&mWaiterCount);
+#else
+    WaitBucket & bucket = GetWaitBucket(this);
+    bucket.mMutex.Lock();
+    xr::Core::AtomicIncrement(&mWaiterCount);
+
+    // Test predicate:
+    if(microSeconds == kSleepForever)
+    {
+        while(!IsComplete(xid))
+        {
+            bucket.mMonitor.Wait(bucket.mMutex);
+        }
+    }
+    else if(!IsComplete(xid))
+    {
+        bucket.mMonitor.Wait(bucket.mMutex, microSeconds);
+    }
+
+    xr::Core::AtomicDecrement(&mWaiterCount);
+    bucket.mMutex.Unlock();
+#endif
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstance::WakeWaiters()
+{
+    // Pairs with the waiter's increment of mWaiterCount before its last
+    // check of mXID: either it sees the invalid XID or this sees it.
+    xr::Core::AtomicFence();
+    if(mWaiterCount == 0)
+    {
+        return;
+    }
+#if defined(XR_PLATFORM_LINUX)
+    volatile uint32_t * word = (volatile uint32_t *)&mXID;
+#if defined(XR_PLATFORM_BIG_ENDIAN)
+    ++word;
+#endif
+    syscall(SYS_futex, word, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    // A waiter holds the bucket mutex from registering until it sleeps in
+    // Wait, taking it here means the broadcast can not fall in between.
+    WaitBucket & bucket = GetWaitBucket(this);
+    bucket.mMutex.Lock();
+    bucket.mMonitor.Broadcast();
+    bucket.mMutex.Unlock();
+#endif
+}
+/*-----------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------*/
+uint64_t JobInstance::GetXid() const
+{
+    return mXID;
+}
+/*-----------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------*/
+void JobInstance::AppendBarrier( size_t count )
+{
+    xr::Core::AtomicAdd(&mRemainingAntecedents , uint32_t(count));
+}
+
+
+// ***************************************************************************************** - TYPE
+// ***************************************************************************************** - TYPE
+JobHandle ManagerInternal::InsertReady(Core::Runnable r, const Core::Arguments *args, Priority priority)
+{
+    JobHandle h = AllocInstance()->Initialize(r, 0, args);
+    h.mInstance->SetPriority(priority);
+    Enqueue(h.mInstance);
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertReady(
+    size_t runnableCount,
+    Core::Runnable *runnableArray,
+    size_t argumentsCount,
+    const Core::Arguments * argsArray,
+    Priority priority)
+{
+    // Need an extra instance to wrap the collection.
+    JobInstance ** instances = (JobInstance **)alloca( sizeof(JobInstance*) * (runnableCount+1));
+    for(size_t i = 0; i < runnableCount+1; i++)
+    {
+        instances[i] = AllocInstance();
+    }
+
+    // Make the last one the wrapper job, it is enabled by the last of the
+    // runnables to finish.
+    JobHandle hWrap = instances[runnableCount]->Initialize(nullptr, runnableCount);
+    hWrap.mInstance->SetPriority(priority);
+
+    if(argumentsCount == 0)
+    {
+        // This can be optimized.
+        for(size_t i = 0; i < runnableCount; i++)
+        {
+            instances[i]->Initialize(runnableArray[i], 0);
+            hWrap.mInstance->AppendAntecedent_NotStarted_NoLock(instances[i]);
+        }
+    }
+    else if(argumentsCount == 1)
+    {
+        // This can be optimized.
+        for(size_t i = 0; i < runnableCount; i++)
+        {
+            instances[i]->Initialize(runnableArray[i], 0, &argsArray[0]);
+            hWrap.mInstance->AppendAntecedent_NotStarted_NoLock(instances[i]);
+        }
+    }
+    else 
+    {
+        XR_ASSERT_ALWAYS_EQ(runnableCount, argumentsCount);
+
+        // This can be optimized.
+        for(size_t i = 0; i < runnableCount; i++)
+        {
+#if defined(XR_COMPILER_MICROSOFT)
+			// Supress bogus overflow warning.
+#pragma warning(disable: 6385)
+#endif
+            instances[i]->Initialize(runnableArray[i], 0, &argsArray[i]);
+            hWrap.mInstance->AppendAntecedent_NotStarted_NoLock(instances[i]);
+        }
+    }
+
+    for(size_t i = 0; i < runnableCount; i++)
+    {
+        instances[i]->SetPriority(priority);
+    }
+    Enqueue(instances, runnableCount);
+
+    return hWrap;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandleBlocked ManagerInternal::InsertBlocked(
+    size_t runnableCount,
+    Core::Runnable *runnableArray,
+    size_t argumentsCount,
+    const Core::Arguments * argsArray,
+    Priority priority)
+{
+    
+
+    JobInstance ** instances = (JobInstance **)alloca( sizeof(JobInstance*) * (runnableCount+1));
+    for(size_t i = 0; i < runnableCount+1; i++)
+    {
+        instances[i] = AllocInstance();
+    }
+
+    JobHandle hWrap = instances[runnableCount]->Initialize(nullptr, 1);
+    hWrap.mInstance->SetPriority(kPriorityHigh);
+
+    if(argumentsCount == 0)
+    {
+        // This can be optimized.
+        for(size_t i = 0; i < runnableCount; i++)
+        {
+            instances[i]->Initialize(runnableArray[i], 1);
+            instances[i]->AppendAntecedent_NotStarted_NoLock(hWrap.mInstance);
+        }
+    }
+    else if(argumentsCount == 1)
+    {
+        // This can be optimized.
+        for(size_t i = 0; i < runnableCount; i++)
+        {
+            instances[i]->Initialize(runnableArray[i], 1, &argsArray[0]);
+            instances[i]->AppendAntecedent_NotStarted_NoLock(hWrap.mInstance);
+        }
+    }
+    else 
+    {
+        XR_ASSERT_ALWAYS_EQ(runnableCount, argumentsCount);
+
+        // This can be optimized.
+        for(size_t i = 0; i < runnableCount; i++)
+        {
+            instances[i]->Initialize(runnableArray[i], 1, &argsArray[i]);
+            instances[i]->AppendAntecedent_NotStarted_NoLock(hWrap.mInstance);
+        }
+    }
+
+    for(size_t i = 0; i < runnableCount; i++)
+    {
+        instances[i]->SetPriority(priority);
+    }
+    return JobHandleBlocked(hWrap);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+xr::Scheduling::JobHandleBlocked ManagerInternal::InsertBlocked( Core::Runnable r, const Core::Arguments *args, Priority priority )
+{
+    JobHandle hWrap = AllocInstance()->Initialize(r, 1, args);
+    hWrap.mInstance->SetPriority(priority);
+    return JobHandleBlocked(hWrap);
+}
+/*-----------------------------------------------------------------------*/
+/*-----------------------------------------------------------------------*/
+JobHandle ManagerInternal::InsertAfter(Core::Runnable r, const Core::Arguments * args, JobHandle * handle0, size_t handleCount, Priority priority)
+{
+    JobHandleBlocked h (AllocInstance()->Initialize(r, handleCount, args));
+    h.mInstance->SetPriority(priority);
+
+    size_t skippedCount = h.mInstance->AppendAntecedents(handle0, handleCount);
+
+    if(skippedCount != 0)
+    {
+        // Release the ones that were already completed.
+        h.ReleaseBarrier(skippedCount);
+    }
+
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertBlocking(
+    Core::Runnable r,
+    const Core::Arguments *args,
+    JobHandle * antecedentArray,
+    size_t arrayCount)
+{
+    // One extra barrier so the antecedents can not make it ready early.
+    JobHandleBlocked h (AllocInstance()->Initialize(r, arrayCount + 1, args));
+    h.mInstance->SetBlocking();
+
+    const size_t skippedCount = arrayCount != 0 ? h.mInstance->AppendAntecedents(antecedentArray, arrayCount) : 0;
+    h.ReleaseBarrier(skippedCount + 1);
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertBlockingPayload(
+    const detail::PayloadType * type,
+    void * object,
+    JobHandle * antecedentArray,
+    size_t arrayCount)
+{
+    JobHandleBlocked h (InsertPayload(type, object, 1, antecedentArray, arrayCount, kPriorityNormal));
+    h.mInstance->SetBlocking();
+    h.ReleaseBarrier();
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertFiber(
+    Core::Runnable r,
+    const Core::Arguments *args,
+    JobHandle * antecedentArray,
+    size_t arrayCount,
+    Priority priority)
+{
+    JobHandleBlocked h (AllocInstance()->Initialize(r, arrayCount + 1, args));
+    h.mInstance->SetPriority(priority);
+    h.mInstance->SetFiber();
+
+    const size_t skippedCount = arrayCount != 0 ? h.mInstance->AppendAntecedents(antecedentArray, arrayCount) : 0;
+    h.ReleaseBarrier(skippedCount + 1);
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertFiberPayload(
+    const detail::PayloadType * type,
+    void * object,
+    JobHandle * antecedentArray,
+    size_t arrayCount,
+    Priority priority)
+{
+    JobHandleBlocked h (InsertPayload(type, object, 1, antecedentArray, arrayCount, priority));
+    h.mInstance->SetFiber();
+    h.ReleaseBarrier();
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::TryInsertReady(Core::Runnable r, const Core::Arguments *args, Priority priority)
+{
+    JobInstance * ji = TryAllocInstance();
+    if(ji == nullptr)
+    {
+        return JobHandle();
+    }
+    JobHandle h = ji->Initialize(r, 0, args);
+    ji->SetPriority(priority);
+    if(!TryEnqueue(ji))
+    {
+        ji->Abandon();
+        return JobHandle();
+    }
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::TryInsertAfter(Core::Runnable r, const Core::Arguments * args, JobHandle * handle0, size_t handleCount, Priority priority)
+{
+    JobInstance * ji = TryAllocInstance();
+    if(ji == nullptr)
+    {
+        return JobHandle();
+    }
+    // One barrier of our own, so whatever enables the job here is us.
+    JobHandle h = ji->Initialize(r, handleCount + 1, args);
+    ji->SetPriority(priority);
+
+    size_t skippedCount = handleCount != 0 ? ji->AppendAntecedents(handle0, handleCount) : 0;
+    if(!TryReleaseInserted(ji, skippedCount + 1))
+    {
+        return JobHandle();
+    }
+    return h;
+}
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertPayload(
+    const detail::PayloadType * type,
+    void * object,
+    size_t barrierCount,
+    JobHandle * antecedentArray,
+    size_t arrayCount,
+    Priority priority)
+{
+    JobInstance * ji = AllocInstance();
+    JobHandleBlocked h (ji->Initialize(nullptr, barrierCount + arrayCount));
+    ji->SetPriority(priority);
+    ji->SetPayload(type, object);
+
+    if(arrayCount != 0)
+    {
+        size_t skippedCount = ji->AppendAntecedents(antecedentArray, arrayCount);
+        if(skippedCount != 0)
+        {
+            // Release the ones that were already completed.
+            h.ReleaseBarrier(skippedCount);
+        }
+    }
+    else if(barrierCount == 0)
+    {
+        Enqueue(ji);
+    }
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::TryInsertPayload(
+    const detail::PayloadType * type,
+    void * object,
+    JobHandle * antecedentArray,
+    size_t arrayCount,
+    Priority priority)
+{
+    JobInstance * ji = TryAllocInstance();
+    if(ji == nullptr)
+    {
+        return JobHandle();
+    }
+    // One barrier of our own, see TryInsertAfter.
+    JobHandle h = ji->Initialize(nullptr, arrayCount + 1);
+    ji->SetPriority(priority);
+    ji->SetPayload(type, object);
+
+    size_t skippedCount = arrayCount != 0 ? ji->AppendAntecedents(antecedentArray, arrayCount) : 0;
+    if(!TryReleaseInserted(ji, skippedCount + 1))
+    {
+        return JobHandle();
+    }
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::WhenAll(JobHandle * antecedentArray, size_t arrayCount)
+{
+    if(arrayCount == 0)
+    {
+        return GetCompletedHandle();
+    }
+
+    JobInstance * ji = AllocInstance();
+    JobHandleBlocked h (ji->Initialize(nullptr, arrayCount));
+    // Only forwards the notification, get it out of the way quickly.
+    ji->SetPriority(kPriorityHigh);
+
+    size_t skippedCount = ji->AppendAntecedents(antecedentArray, arrayCount);
+    if(skippedCount != 0)
+    {
+        // Release the ones that were already completed.
+        h.ReleaseBarrier(skippedCount);
+    }
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+PayloadArena::PayloadArena() : mChunks(nullptr)
+{
+    for(size_t i = 0; i < PayloadCache::kNumClasses; i++)
+    {
+        mShared[i] = nullptr;
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+PayloadArena::~PayloadArena()
+{
+    while(mChunks != nullptr)
+    {
+        void * next = *(void **)mChunks;
+        XR_FREE(mChunks);
+        mChunks = next;
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+PayloadBlock * PayloadArena::TakeLocked(size_t sizeClass, size_t * count)
+{
+    if(mShared[sizeClass] == nullptr)
+    {
+        const size_t blockSize = size_t(1) << (sizeClass + PayloadCache::kMinClassShift);
+        uint8_t * chunk = (uint8_t *)XR_ALLOC_ALIGN(kChunkSize, "Scheduler::Payloads", kChunkHeaderSize);
+        *(void **)chunk = mChunks;
+        mChunks = chunk;
+
+        for(size_t offset = kChunkHeaderSize; offset + blockSize <= kChunkSize; offset += blockSize)
+        {
+            PayloadBlock * block = (PayloadBlock *)(chunk + offset);
+            block->mClass = sizeClass;
+            block->mNext  = mShared[sizeClass];
+            mShared[sizeClass] = block;
+        }
+    }
+
+    PayloadBlock * first = mShared[sizeClass];
+    PayloadBlock * last  = first;
+    size_t taken = 1;
+    while(taken < *count && last->mNext != nullptr)
+    {
+        last = last->mNext;
+        ++taken;
+    }
+    mShared[sizeClass] = last->mNext;
+    last->mNext = nullptr;
+    *count = taken;
+    return first;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void * PayloadArena::Alloc(PayloadCache * cache, size_t size)
+{
+    const size_t total = size + PayloadBlock::kHeaderSize;
+    size_t sizeClass = 0;
+    while(sizeClass < PayloadCache::kNumClasses && (size_t(1) << (sizeClass + PayloadCache::kMinClassShift)) < total)
+    {
+        ++sizeClass;
+    }
+
+    PayloadBlock * block;
+    if(sizeClass == PayloadCache::kNumClasses)
+    {
+        // Too big to cache.
+        block = (PayloadBlock *)XR_ALLOC_ALIGN(total, "Scheduler::Payloads", 16);
+        block->mClass = sizeClass;
+    }
+    else if(cache != nullptr && cache->mFree[sizeClass] != nullptr)
+    {
+        block = cache->mFree[sizeClass];
+        cache->mFree[sizeClass] = block->mNext;
+        --cache->mCount[sizeClass];
+    }
+    else
+    {
+        size_t count = cache != nullptr ? kBatch : 1;
+        mMutex.Lock();
+        block = TakeLocked(sizeClass, &count);
+        mMutex.Unlock();
+
+        if(cache != nullptr)
+        {
+            cache->mFree[sizeClass]  = block->mNext;
+            cache->mCount[sizeClass] = count - 1;
+        }
+    }
+    return (uint8_t *)block + PayloadBlock::kHeaderSize;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void PayloadArena::Free(PayloadCache * cache, void * payload)
+{
+    PayloadBlock * block = (PayloadBlock *)((uint8_t *)payload - PayloadBlock::kHeaderSize);
+    const size_t sizeClass = block->mClass;
+    if(sizeClass == PayloadCache::kNumClasses)
+    {
+        XR_FREE(block);
+        return;
+    }
+
+    if(cache == nullptr)
+    {
+        mMutex.Lock();
+        block->mNext = mShared[sizeClass];
+        mShared[sizeClass] = block;
+        mMutex.Unlock();
+        return;
+    }
+
+    block->mNext = cache->mFree[sizeClass];
+    cache->mFree[sizeClass] = block;
+    if(++cache->mCount[sizeClass] < 2 * kBatch)
+    {
+        return;
+    }
+
+    // Blocks freed here may have been allocated elsewhere (typically a non
+    // worker thread inserting), hand a batch back so they can be reused.
+    PayloadBlock * first = cache->mFree[sizeClass];
+    PayloadBlock * last  = first;
+    for(size_t i = 1; i < kBatch; i++)
+    {
+        last = last->mNext;
+    }
+    cache->mFree[sizeClass]   = last->mNext;
+    cache->mCount[sizeClass] -= kBatch;
+
+    mMutex.Lock();
+    last->mNext = mShared[sizeClass];
+    mShared[sizeClass] = first;
+    mMutex.Unlock();
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstancePool::JobInstancePool() : mThreads(nullptr), mNumThreads(0), mWaiters(0), mPushEpoch(0), mSharedCount(0), mLowWater(0), mExhausted(0)
+{
+    mHead.mPtrs[0] = nullptr;
+    mHead.mInts[1] = 0;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstancePool::Initialize(JobInstance * instances, size_t count, JobThread * threads, size_t numThreads)
+{
+    XR_ASSERT_ALWAYS_EQ(((uintptr_t)&mHead) & (XR_ATOMIC_DOUBLE_POINTER_ALIGN-1), 0);
+    mThreads    = threads;
+    mNumThreads = numThreads;
+    mLowWater = count;
+    AddInstances(instances, count);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstancePool::AddInstances(JobInstance * instances, size_t count)
+{
+    if(count == 0)
+    {
+        return;
+    }
+    for(size_t i = 0; i + 1 < count; i++)
+    {
+        instances[i].mNextFree = &instances[i+1];
+    }
+    instances[count-1].mNextFree = nullptr;
+    PushShared(&instances[0], &instances[count-1], count);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobInstancePool::PopShared()
+{
+    Core::AtomicDoublePointer current, next, seen;
+    // May be torn, the CAS below catches that.
+    current.mInts[0] = mHead.mInts[0];
+    current.mInts[1] = mHead.mInts[1];
+
+    for(;;)
+    {
+        JobInstance * top = (JobInstance *)current.mPtrs[0];
+        if(top == nullptr)
+        {
+            return nullptr;
+        }
+        next.mPtrs[0] = top->mNextFree;
+        next.mInts[1] = current.mInts[1] + 1;
+
+        seen = Core::AtomicCompareAndSwap(&mHead, current, next);
+        if(seen.mInts[0] == current.mInts[0] && seen.mInts[1] == current.mInts[1])
+        {
+            top->mNextFree = nullptr;
+            const uintptr_t left = xr::Core::AtomicDecrement(&mSharedCount) - 1;
+            if(left < mLowWater)
+            {
+                mLowWater = left;
+            }
+            return top;
+        }
+        current = seen;
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstancePool::PushShared(JobInstance * first, JobInstance * last, size_t count)
+{
+    // Counted first so a pop of this chain never takes the count below zero.
+    xr::Core::AtomicAdd(&mSharedCount, uintptr_t(count));
+    Core::AtomicDoublePointer current, next, seen;
+    current.mInts[0] = mHead.mInts[0];
+    current.mInts[1] = mHead.mInts[1];
+
+    next.mPtrs[0] = first;
+    for(;;)
+    {
+        last->mNextFree = (JobInstance *)current.mPtrs[0];
+        next.mInts[1] = current.mInts[1] + 1;
+
+        seen = Core::AtomicCompareAndSwap(&mHead, current, next);
+        if(seen.mInts[0] == current.mInts[0] && seen.mInts[1] == current.mInts[1])
+        {
+            break;
+        }
+        current = seen;
+    }
+
+    // Same pattern as worker parking, publish then check for waiters.
+    xr::Core::AtomicFence();
+    if(mWaiters != 0)
+    {
+        mMutex.Lock();
+        mPushEpoch = mPushEpoch + 1;
+        mMonitor.Broadcast();
+        mMutex.Unlock();
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstancePool::DrainMagazine(JobMagazine * magazine)
+{
+    JobInstance * first = magazine->mHead;
+    for(;;)
+    {
+        if(first == nullptr)
+        {
+            return;
+        }
+        JobInstance * seen = Core::AtomicCompareAndSwap(&magazine->mHead, first, (JobInstance*)nullptr);
+        if(seen == first)
+        {
+            break;
+        }
+        first = seen;
+    }
+
+    // The list is ours now, nobody else can touch the links.
+    JobInstance * last = first;
+    size_t count = 1;
+    while(last->mNextFree != nullptr)
+    {
+        last = last->mNextFree;
+        ++count;
+    }
+    PushShared(first, last, count);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobInstancePool::PopStarved(bool wait)
+{
+    for(;;)
+    {
+        // Announce first, workers check mWaiters after filling a magazine.
+        xr::Core::AtomicIncrement(&mWaiters);
+        uintptr_t epoch = mPushEpoch;
+
+        JobInstance * ji = PopShared();
+        if(ji == nullptr)
+        {
+            // Anything cached by the workers is fair game.
+            for(size_t i = 0; i < mNumThreads; i++)
+            {
+                DrainMagazine(&mThreads[i].mMagazine);
+            }
+            ji = PopShared();
+        }
+
+        if(ji == nullptr)
+        {
+            xr::Core::AtomicIncrement(&mExhausted);
+            if(!wait)
+            {
+                xr::Core::AtomicDecrement(&mWaiters);
+                return nullptr;
+            }
+            mMutex.Lock();
+            while(mPushEpoch == epoch)
+            {
+                mMonitor.Wait(mMutex);
+            }
+            mMutex.Unlock();
+        }
+
+        xr::Core::AtomicDecrement(&mWaiters);
+        if(ji != nullptr)
+        {
+            return ji;
+        }
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobInstancePool::Pop(JobMagazine * magazine, bool wait)
+{
+    if(magazine == nullptr || magazine->mCapacity == 0)
+    {
+        JobInstance * ji = PopShared();
+        return ji != nullptr ? ji : PopStarved(wait);
+    }
+
+    // Only the owner pops single entries, so the head can only have been
+    // taken (set to nullptr) since we read it, never replaced (no ABA).
+    JobInstance * head = magazine->mHead;
+    if(head != nullptr && Core::AtomicCompareAndSwap(&magazine->mHead, head, head->mNextFree) == head)
+    {
+        --magazine->mCount;
+        head->mNextFree = nullptr;
+        return head;
+    }
+
+    // Empty (or drained by someone else). Take one for the caller and
+    // refill half way, which leaves room for frees without an early spill.
+    magazine->mCount = 0;
+    JobInstance * ji = PopShared();
+    if(ji == nullptr)
+    {
+        return PopStarved(wait);
+    }
+
+    const size_t refill = magazine->mCapacity / 2;
+    JobInstance * first = nullptr;
+    JobInstance * last  = nullptr;
+    size_t count = 0;
+    while(count < refill)
+    {
+        JobInstance * next = PopShared();
+        if(next == nullptr)
+        {
+            break;
+        }
+        next->mNextFree = first;
+        first = next;
+        last = (last == nullptr) ? next : last;
+        ++count;
+    }
+
+    if(first != nullptr)
+    {
+        // Magazine is empty and only we add to it.
+        last->mNextFree = nullptr;
+        magazine->mHead = first;
+        magazine->mCount = count;
+        AfterMagazineFill(magazine);
+    }
+    return ji;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstancePool::AfterMagazineFill(JobMagazine * magazine)
+{
+    // Pairs with PopStarved, either the waiter drains this magazine
+    // or we see the waiter and give the instances back ourselves.
+    xr::Core::AtomicFence();
+    if(mWaiters != 0)
+    {
+        DrainMagazine(magazine);
+        magazine->mCount = 0;
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstancePool::Push(JobMagazine * magazine, JobInstance * ji)
+{
+    if(magazine == nullptr || magazine->mCapacity == 0)
+    {
+        ji->mNextFree = nullptr;
+        PushShared(ji, ji, 1);
+        return;
+    }
+
+    if(magazine->mCount >= magazine->mCapacity)
+    {
+        DrainMagazine(magazine);
+        magazine->mCount = 0;
+    }
+
+    JobInstance * head = magazine->mHead;
+    for(;;)
+    {
+        ji->mNextFree = head;
+        JobInstance * seen = Core::AtomicCompareAndSwap(&magazine->mHead, head, ji);
+        if(seen == head)
+        {
+            break;
+        }
+        // Drained, head is now nullptr.
+        head = seen;
+        magazine->mCount = 0;
+    }
+    ++magazine->mCount;
+
+    AfterMagazineFill(magazine);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobInstancePool::Flush(JobMagazine * magazine)
+{
+    DrainMagazine(magazine);
+    magazine->mCount = 0;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobMagazine * ManagerInternal::GetMagazine()
+{
+    JobThread * thread = JobThread::GetCurrent();
+    return (thread != nullptr && thread->mManager == this) ? &thread->mMagazine : nullptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void * ManagerInternal::AllocPayload(size_t size)
+{
+    JobThread * thread = JobThread::GetCurrent();
+    return mPayloads.Alloc((thread != nullptr && thread->mManager == this) ? &thread->mPayloadCache : nullptr, size);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::FreePayload(void * payload)
+{
+    JobThread * thread = JobThread::GetCurrent();
+    mPayloads.Free((thread != nullptr && thread->mManager == this) ? &thread->mPayloadCache : nullptr, payload);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * ManagerInternal::AllocInstance()
+{
+    JobInstance * ji = TryAllocInstance();
+    return ji != nullptr ? ji : mFreeList.Pop(GetMagazine());
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * ManagerInternal::TryAllocInstance()
+{
+    JobMagazine * magazine = GetMagazine();
+    JobInstance * ji = mFreeList.Pop(magazine, false);
+    while(ji == nullptr)
+    {
+        NotifyBackpressure(kBackpressureFreeList);
+        if(!GrowFreeList())
+        {
+            return nullptr;
+        }
+        ji = mFreeList.Pop(magazine, false);
+    }
+    return ji;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::GrowFreeList()
+{
+    if(mOptions.mFreeListGrowSize == 0)
+    {
+        return false;
+    }
+
+    const uintptr_t seen = mInstanceCount;
+    mGrowMutex.Lock();
+    if(mInstanceCount != seen)
+    {
+        // Someone grew the pool while we waited, try that first.
+        mGrowMutex.Unlock();
+        return true;
+    }
+
+    size_t count = mOptions.mFreeListGrowSize;
+    if(mOptions.mFreeListMaxSize != 0)
+    {
+        const size_t room = mInstanceCount < mOptions.mFreeListMaxSize ? mOptions.mFreeListMaxSize - mInstanceCount : 0;
+        count = count < room ? count : room;
+    }
+    if(count == 0)
+    {
+        mGrowMutex.Unlock();
+        return false;
+    }
+
+    JobInstance * slab = XR_NEW_ALIGN("Scheduler::Instances", JobInstance::kAlignment) JobInstance[count];
+    for(size_t i = 0; i < count; i++)
+    {
+        slab[i].RunOnce(this);
+    }
+    mSlabs.Insert(slab);
+    mInstanceCount = mInstanceCount + count;
+    mGrowMutex.Unlock();
+
+    mFreeList.AddInstances(slab, count);
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::NotifyBackpressure(Backpressure what)
+{
+    if(mOptions.mBackpressure != nullptr)
+    {
+        mOptions.mBackpressure(mOptions.mBackpressureContext, what);
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::FreeInstance(JobInstance * ji)
+{
+    mFreeList.Push(GetMagazine(), ji);
+}
+// ***************************************************************************************** - TYPE
+/// Shared by the jobs of one ParallelFor.
+// ***************************************************************************************** - TYPE
+struct ParallelForState
+{
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Next index to hand out, chunks are claimed with AtomicAdd.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile size_t             mNext;
+    size_t                      mEnd;
+    size_t                      mGrainSize;
+    // ------------------------------------------------------------------------------------  MEMBER
+    /// Jobs still running, the last one out frees everything.
+    // ------------------------------------------------------------------------------------  MEMBER
+    volatile size_t             mActive;
+    detail::ParallelForBody   * mBody;
+};
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+static void ParallelForRunnable(const Core::Arguments * a)
+{
+    ParallelForState * state = (ParallelForState *)a->a0;
+    const size_t end   = state->mEnd;
+    const size_t grain = state->mGrainSize;
+
+    for(;;)
+    {
+        size_t chunkBegin = xr::Core::AtomicAdd(&state->mNext, grain);
+        if(chunkBegin >= end)
+        {
+            break;
+        }
+        size_t chunkEnd = (end - chunkBegin) > grain ? chunkBegin + grain : end;
+        state->mBody->Run(chunkBegin, chunkEnd);
+    }
+
+    if(xr::Core::AtomicDecrement(&state->mActive) == 1)
+    {
+        XR_DELETE(state->mBody);
+        XR_DELETE(state);
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::ParallelFor(size_t begin, size_t end, size_t grainSize, detail::ParallelForBody * body, Priority priority)
+{
+    grainSize = grainSize == 0 ? 1 : grainSize;
+
+    // Same shortcuts as the template: nothing to do, or too small to be
+    // worth a job.
+    if(end <= begin || end - begin <= grainSize)
+    {
+        if(begin < end)
+        {
+            body->Run(begin, end);
+        }
+        XR_DELETE(body);
+        return GetCompletedHandle();
+    }
+
+    // Chunks are claimed dynamically, so there is no point in more jobs
+    // than workers (or chunks).
+    const size_t numChunks = (end - begin - 1) / grainSize + 1;
+    const size_t numThreads = GetActiveThreads();
+    size_t numJobs = numThreads < numChunks ? numThreads : numChunks;
+    numJobs = numJobs == 0 ? 1 : numJobs;
+
+    // Claims overshoot end by at most one grain per job.
+    XR_ASSERT_ALWAYS_LE(end, XR_SIZE_MAX - (grainSize * numJobs));
+
+    ParallelForState * state = XR_NEW("ParallelFor") ParallelForState;
+    state->mNext      = begin;
+    state->mEnd       = end;
+    state->mGrainSize = grainSize;
+    state->mActive    = numJobs;
+    state->mBody      = body;
+
+    Core::Runnable * runnables = (Core::Runnable *)alloca( sizeof(Core::Runnable) * numJobs);
+    for(size_t i = 0; i < numJobs; i++)
+    {
+        runnables[i] = &ParallelForRunnable;
+    }
+    Core::Arguments args((uintptr_t)state, 0, 0, 0);
+
+    return InsertReady(numJobs, runnables, 1, &args, priority);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+FiberSlot * ManagerInternal::AllocFiber()
+{
+    // Unlocked peek, no need to take the mutex when there are no fibers.
+    if(mFreeFibers == nullptr)
+    {
+        return nullptr;
+    }
+    mFiberMutex.Lock();
+    FiberSlot * slot = mFreeFibers;
+    if(slot != nullptr)
+    {
+        mFreeFibers = slot->mNextFree;
+    }
+    mFiberMutex.Unlock();
+    return slot;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::FreeFiber(FiberSlot * slot)
+{
+    mFiberMutex.Lock();
+    slot->mNextFree = mFreeFibers;
+    mFreeFibers = slot;
+    mFiberMutex.Unlock();
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::ResumeAfter(FiberSlot * slot, JobInstance * ji, uint64_t xid, Priority priority)
+{
+    // Not InsertAfter, the job must not pick up the worker's token.
+    Core::Arguments args((uintptr_t)slot, 0, 0, 0);
+    JobHandleBlocked h (AllocInstance()->Initialize(&ResumeFiber, 2, &args));
+    h.mInstance->SetPriority(priority);
+    h.mInstance->SetResume();
+    // The rest of the job still counts against its group.
+    h.mInstance->SetGroup(slot->mJob->GetGroup());
+
+    JobHandle antecedent(xid, ji);
+    const size_t skippedCount = h.mInstance->AppendAntecedents(&antecedent, 1);
+    h.ReleaseBarrier(skippedCount + 1);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::ResumeFiber(const Core::Arguments * args)
+{
+    JobThread * thread = JobThread::GetCurrent();
+    XR_ASSERT_DEBUG_NE(thread, (JobThread *)nullptr);
+    JobInstance * next = thread->EnterFiber((FiberSlot *)args->a0);
+    if(next != nullptr)
+    {
+        thread->mManager->Enqueue(next);
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle IManager::GetCompletedHandle()
+{
+    // Never used as a job. Static storage is zero initialized, so mXID is 0
+    // and will never match the handle's XID: it always reads as complete.
+    static JobInstance sCompletedInstance;
+    return JobHandle(1, &sCompletedInstance);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+Core::LinearAllocator * GetJobScratch()
+{
+    JobThread * thread = JobThread::GetCurrent();
+    if(thread == nullptr)
+    {
+        return nullptr;
+    }
+    return thread->mFiber != nullptr ? thread->mFiber->mScratch : thread->mScratch;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+IManager * IManager::GetCurrent()
+{
+    JobThread * thread = JobThread::GetCurrent();
+    return thread != nullptr ? thread->mManager : nullptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t ManagerInternal::GetReadyCount(Priority priority) const
+{
+    XR_ASSERT_ALWAYS_LT(size_t(priority), size_t(kPriorityCount));
+    size_t count = mReadyLists[priority]->UnsafeGetAvailableCount();
+    for(size_t i = 0; i < mOptions.mMaxThreads; i++)
+    {
+        count += mThreads[i].mDeques[priority]->UnsafeGetCount();
+    }
+    const size_t numGroups = GetGroupCount();
+    for(size_t i = 0; i < numGroups; i++)
+    {
+        count += mGroups[i]->mQueues[priority]->UnsafeGetAvailableCount();
+    }
+    return count;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobGroup ManagerInternal::CreateGroup(const char * name, size_t weight, size_t maxConcurrency)
+{
+    mGroupMutex.Lock();
+    const size_t index = mGroupCount;
+    if(index == kMaxGroups)
+    {
+        mGroupMutex.Unlock();
+        return JobGroup();
+    }
+    JobGroupState * group = XR_NEW("Scheduler::Group") JobGroupState;
+    group->mManager        = this;
+    group->mIndex          = index + 1;
+    group->mName           = XR_STRDUP(name != nullptr ? name : "", "Scheduler::Group");
+    group->mWeight         = weight != 0 ? weight : 1;
+    group->mMaxConcurrency = maxConcurrency;
+    group->mQuantum        = Core::TimeStamp(double(group->mWeight * kGroupQuantumMicroSeconds) / (Core::TimeStampToSeconds(1) * 1000000.0));
+    group->mQuantum        = group->mQuantum < 1 ? 1 : group->mQuantum;
+    for(size_t lane = 0; lane < kPriorityCount; lane++)
+    {
+        group->mQueues[lane] = XR_NEW("Scheduler::GroupQueue") Core::BlockingQueue<JobInstance*>(mOptions.mReadyListSize, "Scheduler::GroupQueue");
+    }
+    mGroups[index] = group;
+    // Workers read the array up to the count without the lock.
+    xr::Core::AtomicStoreRelease(&mGroupCount, uintptr_t(index + 1));
+    mGroupMutex.Unlock();
+    return JobGroup(group);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::GetGroupStats(JobGroup handle, GroupStats * stats) const
+{
+    const JobGroupState * group = (const JobGroupState *)handle.mGroup;
+    if(group == nullptr || group->mManager != this || stats == nullptr)
+    {
+        return false;
+    }
+    stats->mName             = group->mName;
+    stats->mWeight           = group->mWeight;
+    stats->mMaxConcurrency   = group->mMaxConcurrency;
+    stats->mQueued           = group->GetQueued();
+    stats->mQueuedHighWater  = group->mQueuedHighWater;
+    stats->mRunning          = group->mRunning;
+    stats->mRunningHighWater = group->mRunningHighWater;
+
+    uint64_t jobsRun = 0;
+    Core::TimeStamp runTime = 0;
+    const size_t index = group->mIndex - 1;
+    for(size_t i = 0; i < mOptions.mMaxThreads; i++)
+    {
+        jobsRun += mThreads[i].mGroupJobs[index];
+        runTime += mThreads[i].mGroupTime[index];
+    }
+    stats->mJobsRun         = jobsRun;
+    stats->mRunMicroSeconds = Core::TimeStampToMicroSeconds(runTime);
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t ManagerInternal::GetStats(Stats * stats, WorkerStats * workers, size_t maxWorkers) const
+{
+    const size_t numThreads = mOptions.mMaxThreads;
+    if(stats != nullptr)
+    {
+        stats->mWorkerCount = numThreads;
+        for(size_t i = 0; i < kPriorityCount; i++)
+        {
+            stats->mReadyListHighWater[i] = mReadyListHighWater[i];
+        }
+        stats->mFreeListLowWater  = mFreeList.GetLowWater();
+        stats->mFreeListExhausted = mFreeList.GetExhaustedCount();
+        stats->mSuccessorChunks   = mSuccessorChunks;
+        stats->mWaitCalls         = mWaitCalls;
+        stats->mFreeListSize      = mInstanceCount;
+        stats->mBlockingThreads   = mBlocking.GetThreadCount();
+        stats->mBlockingThreadsHighWater = mBlocking.GetThreadHighWater();
+        stats->mBlockingJobsRun   = mBlocking.GetJobsRun();
+        stats->mFibersExhausted   = mFibersExhausted;
+        stats->mActiveWorkers     = mActiveThreads;
+        stats->mActiveWorkersHighWater = mActiveHighWater;
+        stats->mWorkersAdded      = mWorkersAdded;
+        stats->mWorkersRetired    = mWorkersRetired;
+    }
+
+    const size_t count = maxWorkers < numThreads ? maxWorkers : numThreads;
+    for(size_t i = 0; workers != nullptr && i < count; i++)
+    {
+        const WorkerCounters & counters = mThreads[i].mCounters;
+        WorkerStats & out = workers[i];
+        out.mJobsRun             = counters.mJobsRun;
+        out.mBusyMicroSeconds    = Core::TimeStampToMicroSeconds(counters.mBusy);
+        out.mIdleMicroSeconds    = Core::TimeStampToMicroSeconds(counters.mIdle);
+        out.mBlockedMicroSeconds = Core::TimeStampToMicroSeconds(counters.mBlocked);
+        out.mSteals              = counters.mSteals;
+        out.mParks               = counters.mParks;
+        out.mWaitCalls           = counters.mWaitCalls;
+        out.mDequeHighWater      = counters.mDequeHighWater;
+        out.mSpinHits            = counters.mSpinHits;
+        out.mJobsCancelled       = counters.mJobsCancelled;
+        out.mFiberWaits          = counters.mFiberWaits;
+    }
+    return numThreads;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::SetTracing(bool enable)
+{
+    mTracing = enable && mOptions.mTraceEventCount != 0;
+}
+// ***************************************************************************************** - TYPE
+/// A TraceRecord and the worker which recorded it, see WriteTrace.
+// ***************************************************************************************** - TYPE
+struct TraceEntry
+{
+    const TraceRecord * mRecord;
+    size_t              mWorker;
+};
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+static bool TraceEntryXidLess(const TraceEntry & a, const TraceEntry & b)
+{
+    return a.mRecord->mXID < b.mRecord->mXID;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Formats one piece of trace output into a line sized buffer.
+// --------------------------------------------------------------------------------------  FUNCTION
+static void TracePrintf(IManager::TraceWriter writer, void * context, const char * format, ...)
+{
+    char line[512];
+    va_list ap;
+    va_start(ap, format);
+    Core::VStringPrintf(line, sizeof(line), format, ap);
+    va_end(ap);
+    writer(context, line, Core::StringLengthWithNull(line) - 1);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+size_t ManagerInternal::WriteTrace(TraceWriter writer, void * context) const
+{
+    const size_t numThreads = mOptions.mMaxThreads;
+    const size_t capacity   = mOptions.mTraceEventCount;
+
+    //`````````````````````````````````````````````````````````````````
+    // Gather what is left in the rings, oldest first.
+    size_t total = 0;
+    for(size_t i = 0; i < numThreads && capacity != 0; i++)
+    {
+        const uintptr_t count = xr::Core::AtomicLoadAcquire(&mThreads[i].mTraceCount);
+        total += count < capacity ? count : capacity;
+    }
+
+    TraceEntry * entries = total != 0 ? (TraceEntry *)XR_ALLOC(sizeof(TraceEntry) * total * 2, "Scheduler::WriteTrace") : nullptr;
+    TraceEntry * byXid   = entries + total;
+    size_t numEntries = 0;
+    Core::TimeStamp base = 0;
+    for(size_t i = 0; i < numThreads && capacity != 0; i++)
+    {
+        const uintptr_t count = xr::Core::AtomicLoadAcquire(&mThreads[i].mTraceCount);
+        const uintptr_t first = count < capacity ? 0 : count - capacity;
+        for(uintptr_t r = first; r != count && numEntries != total; ++r)
+        {
+            const TraceRecord * record = &mThreads[i].mTrace[r & (capacity - 1)];
+            if(numEntries == 0 || record->mStart < base)
+            {
+                base = record->mStart;
+            }
+            entries[numEntries].mRecord = record;
+            entries[numEntries].mWorker = i;
+            ++numEntries;
+        }
+    }
+    for(size_t i = 0; i < numEntries; i++)
+    {
+        byXid[i] = entries[i];
+    }
+    std::sort(byXid, byXid + numEntries, &TraceEntryXidLess);
+
+    //`````````````````````````````````````````````````````````````````
+    // A lane per worker, a complete event per job, and a flow from each
+    // job to the successors it made ready.
+    TracePrintf(writer, context, "{\"traceEvents\":[" XR_EOL);
+    for(size_t i = 0; i < numThreads; i++)
+    {
+        TracePrintf(writer, context, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" XR_UINT64_PRINT ",\"args\":{\"name\":\"Worker %" XR_UINT64_PRINT "\"}}" XR_EOL,
+            i == 0 ? "" : ",", uint64_t(i), uint64_t(i));
+    }
+    for(size_t i = 0; i < numEntries; i++)
+    {
+        const TraceRecord & record = *entries[i].mRecord;
+        TracePrintf(writer, context, ",{\"name\":\"0x%" XR_UINTPTR_PRINTx "\",\"cat\":\"job\",\"ph\":\"X\",\"pid\":1,\"tid\":%" XR_UINT64_PRINT
+                                     ",\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"xid\":%" XR_UINT64_PRINT ",\"enabledBy\":%" XR_UINT64_PRINT "}}" XR_EOL,
+            uintptr_t(record.mRunnable), uint64_t(entries[i].mWorker),
+            Core::TimeStampToSeconds(record.mStart - base) * 1000000.0,
+            Core::TimeStampToSeconds(record.mEnd - record.mStart) * 1000000.0,
+            record.mXID, record.mEnabledBy);
+
+        if(record.mEnabledBy == 0)
+        {
+            continue;
+        }
+        TraceRecord key;
+        key.mXID = record.mEnabledBy;
+        TraceEntry keyEntry = { &key, 0 };
+        const TraceEntry * found = std::lower_bound(byXid, byXid + numEntries, keyEntry, &TraceEntryXidLess);
+        if(found == byXid + numEntries || found->mRecord->mXID != record.mEnabledBy)
+        {
+            // Its predecessor already left the ring.
+            continue;
+        }
+        // Flow ids are the successor's XID, a job is made ready only once.
+        TracePrintf(writer, context, ",{\"name\":\"ready\",\"cat\":\"dependency\",\"ph\":\"s\",\"id\":%" XR_UINT64_PRINT ",\"pid\":1,\"tid\":%" XR_UINT64_PRINT ",\"ts\":%.3f}" XR_EOL,
+            record.mXID, uint64_t(found->mWorker), Core::TimeStampToSeconds(found->mRecord->mStart - base) * 1000000.0);
+        TracePrintf(writer, context, ",{\"name\":\"ready\",\"cat\":\"dependency\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%" XR_UINT64_PRINT ",\"pid\":1,\"tid\":%" XR_UINT64_PRINT ",\"ts\":%.3f}" XR_EOL,
+            record.mXID, uint64_t(entries[i].mWorker), Core::TimeStampToSeconds(record.mStart - base) * 1000000.0);
+    }
+    TracePrintf(writer, context, "]}" XR_EOL);
+
+    if(entries != nullptr)
+    {
+        XR_FREE(entries);
+    }
+    return numEntries;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::Enqueue(JobInstance * ji)
+{
+    if(ji->GetPriority() == kBlockingLane)
+    {
+        mBlocking.Enqueue(ji);
+    }
+    else if(ji->GetGroup() != 0)
+    {
+        EnqueueGroup(ji, false);
+        WakeWorkers(1);
+    }
+    else if(!TryEnqueue(ji))
+    {
+        const size_t lane = ji->GetPriority();
+        mReadyLists[lane]->Enqueue(ji);
+        UpdateHighWater(&mReadyListHighWater[lane], mReadyLists[lane]->UnsafeGetAvailableCount());
+        WakeWorkers(1);
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::TryReleaseInserted(JobInstance * ji, size_t count)
+{
+    for(size_t i = 0; i < count; i++)
+    {
+        if(ji->NotifyReturnOnEnabled() != nullptr)
+        {
+            if(!TryEnqueue(ji))
+            {
+                ji->Abandon();
+                return false;
+            }
+            return true;
+        }
+    }
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::TryEnqueue(JobInstance * ji)
+{
+    const size_t lane = ji->GetPriority();
+    if(lane == kBlockingLane)
+    {
+        mBlocking.Enqueue(ji);
+        return true;
+    }
+    JobThread * thread = JobThread::GetCurrent();
+    if(ji->GetGroup() != 0)
+    {
+        if(!EnqueueGroup(ji, true))
+        {
+            NotifyBackpressure(kBackpressureReadyList);
+            return false;
+        }
+    }
+    else if(thread != nullptr && thread->mManager == this && thread->mDeques[lane]->Push(ji))
+    {
+        thread->UpdateDequeHighWater(lane);
+    }
+    else if(mReadyLists[lane]->TryEnqueue(ji))
+    {
+        UpdateHighWater(&mReadyListHighWater[lane], mReadyLists[lane]->UnsafeGetAvailableCount());
+    }
+    else
+    {
+        NotifyBackpressure(kBackpressureReadyList);
+        return false;
+    }
+    WakeWorkers(1);
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::Enqueue(JobInstance ** instances, size_t count)
+{
+    if(count == 0)
+    {
+        return;
+    }
+    const size_t lane = instances[0]->GetPriority();
+    if(lane == kBlockingLane)
+    {
+        for(size_t i = 0; i < count; ++i)
+        {
+            mBlocking.Enqueue(instances[i]);
+        }
+        return;
+    }
+    JobThread * thread = JobThread::GetCurrent();
+    size_t i = 0;
+    if(instances[0]->GetGroup() != 0)
+    {
+        // Inserted under one scope, so one group.
+        for(; i < count; ++i)
+        {
+            XR_ASSERT_DEBUG_EQ(instances[i]->GetGroup(), instances[0]->GetGroup());
+            EnqueueGroup(instances[i], false);
+        }
+    }
+    else if(thread != nullptr && thread->mManager == this)
+    {
+        for(; i < count; ++i)
+        {
+            XR_ASSERT_DEBUG_EQ(instances[i]->GetPriority(), lane);
+            if(!thread->mDeques[lane]->Push(instances[i]))
+            {
+                break;
+            }
+        }
+        thread->UpdateDequeHighWater(lane);
+    }
+
+    if(i < count)
+    {
+        if(mReadyLists[lane]->UnsafeGetFreeCount() < count - i)
+        {
+            NotifyBackpressure(kBackpressureReadyList);
+        }
+        mReadyLists[lane]->Enqueue(instances + i, count - i);
+        UpdateHighWater(&mReadyListHighWater[lane], mReadyLists[lane]->UnsafeGetAvailableCount());
+    }
+    WakeWorkers(count);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::EnqueueGroup(JobInstance * ji, bool tryOnly)
+{
+    JobGroupState * group = GetGroup(ji->GetGroup());
+    const size_t lane = ji->GetPriority();
+    Core::BlockingQueue<JobInstance *> * queue = group->mQueues[lane];
+    if(tryOnly)
+    {
+        if(!queue->TryEnqueue(ji))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if(queue->UnsafeGetFreeCount() == 0)
+        {
+            NotifyBackpressure(kBackpressureReadyList);
+        }
+        queue->Enqueue(ji);
+    }
+    UpdateHighWater(&group->mQueuedHighWater, queue->UnsafeGetAvailableCount());
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::WakeWorkers(size_t count)
+{
+    // Order the publish of the job(s) before the read of mIdleCount. Pairs
+    // with the increment in Park.
+    xr::Core::AtomicFence();
+    const uintptr_t idle     = mIdleCount;
+    const uintptr_t spinning = mSpinningCount;
+    if(idle == 0 || count <= spinning)
+    {
+        if(idle == 0 && count > spinning && mElastic)
+        {
+            CheckBacklog();
+        }
+        return;
+    }
+    // Spinning workers will pick up their share without a wake.
+    count -= spinning;
+
+    mIdleMutex.Lock();
+    mWakeEpoch = mWakeEpoch + 1;
+    if(count >= idle)
+    {
+        mIdleMonitor.Broadcast();
+        mTimerMonitor.Signal();
+    }
+    else
+    {
+        // One worker per job.
+        for(size_t i = 0; i < count; i++)
+        {
+            mIdleMonitor.Signal();
+        }
+    }
+    mIdleMutex.Unlock();
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::Park(JobThread * thread)
+{
+    // Announce first, then look one last time. Any push after this point
+    // will see the idle count and bump the epoch.
+    xr::Core::AtomicIncrement(&mIdleCount);
+    uintptr_t epoch = mWakeEpoch;
+
+    JobInstance * ji = thread->FindWork();
+    if(ji != nullptr)
+    {
+        xr::Core::AtomicDecrement(&mIdleCount);
+        // Put it back where it can be found (or stolen).
+        if(ji->GetGroup() != 0)
+        {
+            GetGroup(ji->GetGroup())->Release();
+        }
+        Enqueue(ji);
+        return false;
+    }
+
+    // Don't sit on free instances while idle, another thread may need them.
+    mFreeList.Flush(&thread->mMagazine);
+
+    WorkerCounters & counters = thread->mCounters;
+    counters.mParks = counters.mParks + 1;
+    const Core::TimeStamp parkedAt = Core::GetTimeStamp();
+
+    // One parked worker keeps the timers, see "Timers" at the top of the file.
+    bool keeper   = false;
+    bool timerDue = false;
+    bool retire   = false;
+    mIdleMutex.Lock();
+    while(mWakeEpoch == epoch && !thread->IsQuitRequested())
+    {
+        if(!keeper && !mTimerKeeper && mNextTimerDeadline != kNoTimer)
+        {
+            keeper       = true;
+            mTimerKeeper = true;
+        }
+        // Only the newest worker retires, see "Elastic pool".
+        if(!keeper && mElastic && thread->mIndex + 1 == mActiveThreads && mActiveThreads > mOptions.mMinThreads)
+        {
+            const Core::TimeStamp parked = Core::GetTimeStamp() - parkedAt;
+            if(parked >= mRetireIdle)
+            {
+                retire = true;
+                break;
+            }
+            mIdleMonitor.Wait(mIdleMutex, uint64_t(Core::TimeStampToMicroSeconds(mRetireIdle - parked)) + 1);
+            continue;
+        }
+        if(!keeper)
+        {
+            mIdleMonitor.Wait(mIdleMutex);
+            continue;
+        }
+        const Core::TimeStamp due = mNextTimerDeadline;
+        if(due == kNoTimer)
+        {
+            mTimerMonitor.Wait(mIdleMutex);
+            continue;
+        }
+        const Core::TimeStamp now = Core::GetTimeStamp();
+        if(now >= due)
+        {
+            timerDue = true;
+            break;
+        }
+        // Capped, far deadlines are just looked at again.
+        const uint64_t kMaxWait = 1000000;
+        const uint64_t wait = uint64_t(Core::TimeStampToMicroSeconds(due - now)) + 1;
+        mTimerMonitor.Wait(mIdleMutex, wait < kMaxWait ? wait : kMaxWait);
+    }
+    if(keeper)
+    {
+        mTimerKeeper = false;
+        if(!timerDue && mNextTimerDeadline != kNoTimer)
+        {
+            // Leaving for work, hand the timers to someone still parked.
+            mIdleMonitor.Signal();
+        }
+    }
+    mIdleMutex.Unlock();
+
+    counters.mIdle = counters.mIdle + (Core::GetTimeStamp() - parkedAt);
+    xr::Core::AtomicDecrement(&mIdleCount);
+    return retire;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::Retire(JobThread * thread)
+{
+    const size_t index = thread->mIndex;
+    mElasticMutex.Lock();
+    if(index + 1 != mActiveThreads || mActiveThreads <= mOptions.mMinThreads || thread->IsQuitRequested())
+    {
+        mElasticMutex.Unlock();
+        return;
+    }
+    xr::Core::AtomicStoreRelease(&mActiveThreads, uintptr_t(index));
+    mWorkersRetired = mWorkersRetired + 1;
+    mElasticMutex.Unlock();
+    // The worker below may already be parked without a deadline, let it
+    // see that it is the newest now.
+    mIdleMutex.Lock();
+    mIdleMonitor.Broadcast();
+    mIdleMutex.Unlock();
+    XR_LOG_DEBUG_FORMATTED(&sScedulerLogHandle, "Worker %" XR_UINT64_PRINT " retired" XR_EOL, uint64_t(index));
+    if(mOptions.mResize != nullptr)
+    {
+        mOptions.mResize(mOptions.mResizeContext, index, false);
+    }
+
+    const Core::TimeStamp retiredAt = Core::GetTimeStamp();
+    mElasticMutex.Lock();
+    while(index >= mActiveThreads && !thread->IsQuitRequested())
+    {
+        mElasticMonitor.Wait(mElasticMutex);
+    }
+    mElasticMutex.Unlock();
+    thread->mCounters.mIdle = thread->mCounters.mIdle + (Core::GetTimeStamp() - retiredAt);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::CheckBacklog()
+{
+    if(mActiveThreads >= mOptions.mMaxThreads)
+    {
+        return;
+    }
+    const Core::TimeStamp now   = Core::GetTimeStamp();
+    const Core::TimeStamp since = mBacklogSince;
+    if(since == 0)
+    {
+        mBacklogSince = now;
+        return;
+    }
+    // One pusher claims the decision, the next has to wait out the latency
+    // again. Only the claimer tries the lock, which is held only briefly
+    // by a retiring worker or Shutdown otherwise.
+    if(now - since < mGrowLatency || xr::Core::AtomicCompareAndSwap(&mBacklogSince, since, now) != since)
+    {
+        return;
+    }
+    if(!mElasticMutex.TryLock())
+    {
+        return;
+    }
+    const size_t index = mActiveThreads;
+    // A worker that ran out of work since the claim cleared the backlog.
+    if(!mElastic || index >= mOptions.mMaxThreads || mBacklogSince != now)
+    {
+        mElasticMutex.Unlock();
+        return;
+    }
+    xr::Core::AtomicStoreRelease(&mActiveThreads, uintptr_t(index + 1));
+    mWorkersAdded = mWorkersAdded + 1;
+    UpdateHighWater(&mActiveHighWater, index + 1);
+    if(index == mStartedThreads)
+    {
+        mStartedThreads = index + 1;
+        mThreads[index].Start();
+    }
+    else
+    {
+        mElasticMonitor.Broadcast();
+    }
+    mElasticMutex.Unlock();
+    XR_LOG_DEBUG_FORMATTED(&sScedulerLogHandle, "Worker %" XR_UINT64_PRINT " added" XR_EOL, uint64_t(index));
+    if(mOptions.mResize != nullptr)
+    {
+        mOptions.mResize(mOptions.mResizeContext, index + 1, true);
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+/// Chooses a processor (and node) for every worker, before they start.
+/// Returns the number of distinct nodes used.
+// --------------------------------------------------------------------------------------  FUNCTION
+static size_t PlaceWorkers(const IManager::InitializeOptions & options, JobThread * threads, size_t numThreads)
+{
+    const bool pin = options.mPinThreads || options.mProcessors != nullptr;
+    if(numThreads == 0 || (!pin && !options.mNumaAware))
+    {
+        return 1;
+    }
+
+    typedef Core::Thread::ProcessorInfo ProcessorInfo;
+    size_t numInfo = Core::Thread::GetProcessorInfo(nullptr, 0);
+    numInfo = numInfo == 0 ? 1 : numInfo;
+    size_t numCandidates = options.mProcessors != nullptr ? options.mProcessorCount : numInfo;
+    XR_ASSERT_ALWAYS_NE(numCandidates, 0);
+    ProcessorInfo * info       = (ProcessorInfo *)XR_ALLOC(sizeof(ProcessorInfo) * numInfo, "Scheduler::Placement");
+    ProcessorInfo * candidates = (ProcessorInfo *)XR_ALLOC(sizeof(ProcessorInfo) * numCandidates, "Scheduler::Placement");
+    size_t written = Core::Thread::GetProcessorInfo(info, numInfo);
+    numInfo = written < numInfo ? written : numInfo;
+
+    size_t count = 0;
+    if(options.mProcessors != nullptr)
+    {
+        for(size_t i = 0; i < options.mProcessorCount; ++i)
+        {
+            // Unknown processors are still honored, they just have no topology.
+            candidates[count].mProcessor = uint32_t(options.mProcessors[i]);
+            candidates[count].mCore      = uint32_t(options.mProcessors[i]);
+            candidates[count].mNode      = 0;
+            for(size_t j = 0; j < numInfo; ++j)
+            {
+                if(info[j].mProcessor == options.mProcessors[i])
+                {
+                    candidates[count] = info[j];
+                    break;
+                }
+            }
+            ++count;
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < numInfo; ++i)
+        {
+            bool sibling = false;
+            for(size_t j = 0; options.mSkipSmtSiblings && j < count; ++j)
+            {
+                sibling = sibling || candidates[j].mCore == info[i].mCore;
+            }
+            if(!sibling)
+            {
+                candidates[count++] = info[i];
+            }
+        }
+    }
+
+    if(options.mNumaAware)
+    {
+        // Stable insertion sort by node, keeps each node's workers together.
+        for(size_t i = 1; i < count; ++i)
+        {
+            ProcessorInfo temp = candidates[i];
+            size_t j = i;
+            for(; j > 0 && candidates[j-1].mNode > temp.mNode; --j)
+            {
+                candidates[j] = candidates[j-1];
+            }
+            candidates[j] = temp;
+        }
+    }
+
+    size_t numNodes = 0;
+    for(size_t i = 0; i < numThreads; ++i)
+    {
+        const ProcessorInfo & c = candidates[i % count];
+        if(pin)
+        {
+            threads[i].SetAffinity(c.mProcessor);
+        }
+        if(options.mNumaAware)
+        {
+            threads[i].mNode = c.mNode;
+            // Sorted, so a new node is always a change from the previous worker.
+            if(i < count && (i == 0 || c.mNode != candidates[i-1].mNode))
+            {
+                ++numNodes;
+            }
+        }
+    }
+
+    XR_FREE(candidates);
+    XR_FREE(info);
+    return numNodes == 0 ? 1 : numNodes;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+IManager * IManager::Initialize(InitializeOptions * options)
+{
+    // Aligned for the double pointer CAS in the free list.
+    ManagerInternal * p = XR_NEW_ALIGN("Manager", XR_ATOMIC_DOUBLE_POINTER_ALIGN) ManagerInternal();
+    p->mOptions = *options;
+    p->mIdleCount = 0;
+    p->mSpinningCount = 0;
+    p->mWakeEpoch = 0;
+    p->mSpinLimit = 0;
+    if(options->mSpinMicroSeconds != 0)
+    {
+        const double ticks = double(options->mSpinMicroSeconds) / (Core::TimeStampToSeconds(1) * 1000000.0);
+        p->mSpinLimit = ticks < 1.0 ? 1 : Core::TimeStamp(ticks);
+    }
+    for(size_t i = 0; i < kPriorityCount; i++)
+    {
+        p->mReadyListHighWater[i] = 0;
+    }
+    p->mSuccessorChunks = 0;
+    p->mWaitCalls = 0;
+    p->mTracing = false;
+    p->mInstanceCount = options->mFreeListSize;
+    XR_ASSERT_ALWAYS_NE(options->mTimerTickMicroSeconds, size_t(0));
+    p->mFreeTimers = nullptr;
+    p->mNextTimerID = 0;
+    p->mTimerBase = Core::GetTimeStamp();
+    p->mStampsPerTick = double(options->mTimerTickMicroSeconds) / (Core::TimeStampToSeconds(1) * 1000000.0);
+    p->mNextTimerDeadline = ManagerInternal::kNoTimer;
+    p->mTimerKeeper = false;
+    p->mFiberSlots = nullptr;
+    p->mFreeFibers = nullptr;
+    p->mFibersExhausted = 0;
+    p->mGroupCount = 0;
+    for(size_t i = 0; i < kMaxGroups; i++)
+    {
+        p->mGroups[i] = nullptr;
+    }
+
+    // Bounds around mNumThreads, see "Elastic Workers".
+    InitializeOptions & bounds = p->mOptions;
+    bounds.mMinThreads = (bounds.mMinThreads == 0 || bounds.mMinThreads > bounds.mNumThreads) ? bounds.mNumThreads : bounds.mMinThreads;
+    bounds.mMaxThreads = bounds.mMaxThreads < bounds.mNumThreads ? bounds.mNumThreads : bounds.mMaxThreads;
+    if(bounds.mMinThreads == 0 && bounds.mMaxThreads != 0)
+    {
+        // Someone has to be there to notice the backlog.
+        bounds.mMinThreads = 1;
+    }
+    const size_t maxThreads = bounds.mMaxThreads;
+    p->mElastic         = bounds.mMaxThreads != bounds.mMinThreads;
+    p->mActiveThreads   = options->mNumThreads;
+    p->mStartedThreads  = options->mNumThreads;
+    p->mActiveHighWater = options->mNumThreads;
+    p->mWorkersAdded    = 0;
+    p->mWorkersRetired  = 0;
+    p->mBacklogSince    = 0;
+    p->mGrowLatency     = Core::TimeStamp(double(options->mGrowLatencyMicroSeconds)  / (Core::TimeStampToSeconds(1) * 1000000.0));
+    p->mRetireIdle      = Core::TimeStamp(double(options->mRetireIdleMicroSeconds) / (Core::TimeStampToSeconds(1) * 1000000.0));
+
+    // Rings are indexed by masking the record count.
+    size_t traceCount = options->mTraceEventCount;
+    if(traceCount != 0)
+    {
+        size_t rounded = 1;
+        while(rounded < traceCount)
+        {
+            rounded <<= 1;
+        }
+        traceCount = rounded;
+    }
+    p->mOptions.mTraceEventCount = traceCount;
+
+    p->mInstances = XR_NEW_ALIGN("Scheduler::Instances", JobInstance::kAlignment) JobInstance[options->mFreeListSize];
+    p->mThreads   = XR_NEW("Scheduler::Threads")    JobThread[maxThreads];
+    for(size_t lane = 0; lane < kPriorityCount; lane++)
+    {
+        p->mReadyLists[lane] = XR_NEW("Scheduler::ReadyQueue") Core::BlockingQueue<JobInstance*>(options->mReadyListSize, "Scheduler::ReadyQueue");
+    }
+
+    for(size_t i = 0; i < options->mFreeListSize; i++)
+    {
+        p->mInstances[i].RunOnce(p);
+    }
+    // These are all free.
+    p->mFreeList.Initialize(p->mInstances, options->mFreeListSize, p->mThreads, maxThreads);
+
+    // Magazines hold at most a quarter of the pool between them (a starved
+    // thread drains them anyway), small pools go straight to the shared stack.
+    size_t magazineCapacity = maxThreads == 0 ? 0 : options->mFreeListSize / (4 * maxThreads);
+    magazineCapacity = magazineCapacity < JobMagazine::kMaxSize ? magazineCapacity : JobMagazine::kMaxSize;
+    magazineCapacity = magazineCapacity < 4 ? 0 : magazineCapacity;
+
+    // All deques must exist before any thread can try to steal. Workers the
+    // pool may grow into are set up now too, only their threads wait.
+    for(size_t i = 0; i < maxThreads; i++)
+    {
+        p->mThreads[i].mManager    = p;
+        p->mThreads[i].mIndex      = i;
+        p->mThreads[i].mStealSeed  = uint32_t(i * 2654435761u) | 1;
+        p->mThreads[i].mMagazine.mCapacity = magazineCapacity;
+        p->mThreads[i].mScratch    = CreateScratch(options->mJobScratchSize);
+        if(traceCount != 0)
+        {
+            p->mThreads[i].mTrace = (TraceRecord *)XR_ALLOC(sizeof(TraceRecord) * traceCount, "Scheduler::Trace");
+        }
+        for(size_t lane = 0; lane < kPriorityCount; lane++)
+        {
+            p->mThreads[i].mDeques[lane] = XR_NEW("Scheduler::Deque") Core::WorkStealingDeque<JobInstance*>(options->mReadyListSize, "Scheduler::Deque");
+        }
+    }
+
+    p->mNumNodes = PlaceWorkers(p->mOptions, p->mThreads, maxThreads);
+
+    // Workers attach their own stack when there are fibers, so before they start.
+    if(options->mFiberCount != 0)
+    {
+        p->mFiberSlots = XR_NEW("Scheduler::Fibers") FiberSlot[options->mFiberCount];
+        for(size_t i = 0; i < options->mFiberCount; i++)
+        {
+            FiberSlot & slot = p->mFiberSlots[i];
+            if(!slot.mFiber.Create(&FiberSlot::Main, &slot, options->mFiberStackSize))
+            {
+                XR_LOG_ERROR_FORMATTED(&sScedulerLogHandle, "Failed to create fiber %" XR_UINT64_PRINT XR_EOL, uint64_t(i));
+                continue;
+            }
+            slot.mScratch  = CreateScratch(options->mJobScratchSize);
+            slot.mNextFree = p->mFreeFibers;
+            p->mFreeFibers = &slot;
+        }
+    }
+
+    for(size_t i = 0; i < options->mNumThreads; i++)
+    {
+        // Start the Thread.
+        p->mThreads[i].Start();
+    }
+    p->mBlocking.Initialize(options->mBlockingThreads, options->mMaxBlockingThreads, options->mBlockingIdleMicroSeconds);
+
+    return p;
+}
+
+
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void IManager::Shutdown(IManager * m)
+{
+    ManagerInternal * sched = (ManagerInternal*)m;
+    // Blocking jobs still queued hand their successors to the workers.
+    sched->mBlocking.Shutdown();
+
+    // Workers exit once they are out of work and see the request. No more
+    // are started, retired ones are woken to see it.
+    sched->mElasticMutex.Lock();
+    sched->mElastic = false;
+    const size_t numStarted = sched->mStartedThreads;
+    for(size_t i = 0; i < numStarted; i++)
+    {
+        sched->mThreads[i].RequestQuit();
+    }
+    sched->mElasticMonitor.Broadcast();
+    sched->mElasticMutex.Unlock();
+
+    // Wake everyone that is parked so they see the request.
+    sched->mIdleMutex.Lock();
+    sched->mWakeEpoch = sched->mWakeEpoch + 1;
+    sched->mIdleMonitor.Broadcast();
+    sched->mTimerMonitor.Signal();
+    sched->mIdleMutex.Unlock();
+
+    for(size_t i = 0; i < numStarted; i++)
+    {
+        // Join the Threads.
+        sched->mThreads[i].Join();
+    }
+
+    for(size_t lane = 0; lane < kPriorityCount; lane++)
+    {
+        for(size_t i = 0; i < sched->mOptions.mMaxThreads; i++)
+        {
+            XR_DELETE(sched->mThreads[i].mDeques[lane]);
+        }
+        XR_DELETE(sched->mReadyLists[lane]);
+    }
+    for(size_t i = 0; i < sched->mGroupCount; i++)
+    {
+        JobGroupState * group = sched->mGroups[i];
+        for(size_t lane = 0; lane < kPriorityCount; lane++)
+        {
+            XR_DELETE(group->mQueues[lane]);
+        }
+        XR_FREE(group->mName);
+        XR_DELETE(group);
+    }
+    for(size_t i = 0; i < sched->mOptions.mMaxThreads; i++)
+    {
+        if(sched->mThreads[i].mTrace != nullptr)
+        {
+            XR_FREE(sched->mThreads[i].mTrace);
+        }
+        DestroyScratch(sched->mThreads[i].mScratch);
+    }
+    XR_DELETE_ARRAY(sched->mThreads);
+    // Every fiber job has completed, so every fiber is back on the free list.
+    if(sched->mFiberSlots != nullptr)
+    {
+        for(size_t i = 0; i < sched->mOptions.mFiberCount; i++)
+        {
+            DestroyScratch(sched->mFiberSlots[i].mScratch);
+        }
+        XR_DELETE_ARRAY(sched->mFiberSlots);
+    }
+    XR_DELETE_ARRAY(sched->mInstances);
+    for(JobInstance * slab : sched->mSlabs)
+    {
+        XR_DELETE_ARRAY(slab);
+    }
+    // Pending delayed jobs die with their instances, periodic ones still
+    // own a payload.
+    for(Timer * timer : sched->mTimers)
+    {
+        if(timer->mID != 0 && timer->mPayload != nullptr)
+        {
+            if(timer->mDestroy != nullptr)
+            {
+                timer->mDestroy(timer->mPayload);
+            }
+            sched->FreePayload(timer->mPayload);
+        }
+        XR_FREE(timer);
+    }
+    XR_DELETE(sched);
+}
+
+
+
+// ***************************************************************************************** - TYPE
+// Timer Functions.
+// ***************************************************************************************** - TYPE
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+TimerWheel::TimerWheel() : mCurrent(0)
+{
+    for(size_t level = 0; level < kLevels; ++level)
+    {
+        mLevelCount[level] = 0;
+        for(size_t slot = 0; slot < kSlots; ++slot)
+        {
+            mSlots[level][slot] = nullptr;
+        }
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void TimerWheel::Add(Timer * timer)
+{
+    // Placement only, mTick keeps the real deadline. Anything past the
+    // top level parks in its furthest slot and is placed again from there.
+    const uint64_t kRange = uint64_t(1) << (kSlotBits * kLevels);
+    uint64_t tick  = timer->mTick < mCurrent ? mCurrent : timer->mTick;
+    uint64_t delta = tick - mCurrent;
+    if(delta >= kRange)
+    {
+        delta = kRange - 1;
+        tick  = mCurrent + delta;
+    }
+    size_t level = 0;
+    while((delta >> (kSlotBits * (level + 1))) != 0)
+    {
+        ++level;
+    }
+
+    Timer ** slot = &mSlots[level][(tick >> (kSlotBits * level)) & (kSlots - 1)];
+    timer->mNext = *slot;
+    if(timer->mNext != nullptr)
+    {
+        timer->mNext->mLink = &timer->mNext;
+    }
+    *slot = timer;
+    timer->mLink  = slot;
+    timer->mLevel = uint8_t(level);
+    ++mLevelCount[level];
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void TimerWheel::Remove(Timer * timer)
+{
+    XR_ASSERT_DEBUG_NE(timer->mLink, (Timer**)nullptr);
+    *timer->mLink = timer->mNext;
+    if(timer->mNext != nullptr)
+    {
+        timer->mNext->mLink = timer->mLink;
+    }
+    timer->mLink = nullptr;
+    --mLevelCount[timer->mLevel];
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void TimerWheel::Cascade(size_t level, size_t slot)
+{
+    Timer * timer = mSlots[level][slot];
+    while(timer != nullptr)
+    {
+        Timer * next = timer->mNext;
+        Remove(timer);
+        Add(timer);
+        timer = next;
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+Timer * TimerWheel::Advance(uint64_t now)
+{
+    Timer * expired = nullptr;
+    while(mCurrent <= now)
+    {
+        size_t lowest = 0;
+        while(lowest < kLevels && mLevelCount[lowest] == 0)
+        {
+            ++lowest;
+        }
+        if(lowest == kLevels)
+        {
+            mCurrent = now + 1;
+            break;
+        }
+        if(lowest != 0)
+        {
+            // Nothing can expire before the lowest occupied level's next
+            // slot comes up.
+            const uint64_t mask = (uint64_t(1) << (kSlotBits * lowest)) - 1;
+            if((mCurrent & mask) != 0)
+            {
+                const uint64_t boundary = (mCurrent | mask) + 1;
+                mCurrent = boundary <= now ? boundary : now + 1;
+                continue;
+            }
+        }
+
+        // Highest first, a timer may drop through several levels at once.
+        for(size_t level = kLevels - 1; level != 0; --level)
+        {
+            const size_t shift = kSlotBits * level;
+            if((mCurrent & ((uint64_t(1) << shift) - 1)) == 0)
+            {
+                Cascade(level, size_t(mCurrent >> shift) & (kSlots - 1));
+            }
+        }
+
+        Timer ** slot = &mSlots[0][mCurrent & (kSlots - 1)];
+        while(*slot != nullptr)
+        {
+            Timer * timer = *slot;
+            Remove(timer);
+            timer->mNext = expired;
+            expired = timer;
+        }
+        ++mCurrent;
+    }
+    return expired;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+uint64_t TimerWheel::GetNextTick() const
+{
+    uint64_t next = kNever;
+    for(size_t level = 1; level < kLevels; ++level)
+    {
+        if(mLevelCount[level] != 0)
+        {
+            // Its next cascade, the timers themselves are later.
+            const uint64_t mask = (uint64_t(1) << (kSlotBits * level)) - 1;
+            next = (mCurrent & mask) == 0 ? mCurrent : (mCurrent | mask) + 1;
+            break;
+        }
+    }
+    if(mLevelCount[0] != 0)
+    {
+        // Level 0 only holds the next kSlots ticks.
+        for(uint64_t tick = mCurrent; tick < next; ++tick)
+        {
+            if(mSlots[0][tick & (kSlots - 1)] != nullptr)
+            {
+                return tick;
+            }
+        }
+    }
+    return next;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+uint64_t ManagerInternal::GetTimerMicroSeconds() const
+{
+    return uint64_t(Core::TimeStampToMicroSeconds(Core::GetTimeStamp() - mTimerBase));
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+Core::TimeStamp ManagerInternal::TickToTimeStamp(uint64_t tick) const
+{
+    if(tick == TimerWheel::kNever)
+    {
+        return kNoTimer;
+    }
+    // Rounded up, so a worker woken at the deadline finds the tick started.
+    const double stamps = double(tick) * mStampsPerTick + 1.0;
+    if(stamps >= double(kNoTimer - mTimerBase))
+    {
+        return kNoTimer - 1;
+    }
+    return mTimerBase + Core::TimeStamp(stamps);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+Timer * ManagerInternal::AllocTimer()
+{
+    mTimerMutex.Lock();
+    Timer * timer = mFreeTimers;
+    if(timer != nullptr)
+    {
+        mFreeTimers = timer->mNext;
+    }
+    else
+    {
+        timer = (Timer *)XR_ALLOC(sizeof(Timer), "Scheduler::Timer");
+        mTimers.Insert(timer);
+    }
+    mNextTimerID = mNextTimerID + 1;
+    const uint64_t id = mNextTimerID;
+    mTimerMutex.Unlock();
+
+    Core::MemClear8(timer, sizeof(Timer));
+    timer->mID = id;
+    return timer;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::FreeTimerLocked(Timer * timer)
+{
+    if(timer->mPayload != nullptr)
+    {
+        if(timer->mDestroy != nullptr)
+        {
+            timer->mDestroy(timer->mPayload);
+        }
+        FreePayload(timer->mPayload);
+        timer->mPayload = nullptr;
+    }
+    timer->mID   = 0;
+    timer->mNext = mFreeTimers;
+    mFreeTimers  = timer;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::AddTimerLocked(Timer * timer)
+{
+    mTimerWheel.Add(timer);
+    const Core::TimeStamp deadline = TickToTimeStamp(timer->mTick);
+    if(deadline >= mNextTimerDeadline)
+    {
+        return false;
+    }
+    mNextTimerDeadline = deadline;
+    return true;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::ArmTimer(Timer * timer)
+{
+    mTimerMutex.Lock();
+    const bool earlier = AddTimerLocked(timer);
+    mTimerMutex.Unlock();
+    if(earlier)
+    {
+        WakeTimerKeeper();
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::WakeTimerKeeper()
+{
+    // Order the deadline write before the read of mIdleCount, pairs with
+    // the increment in Park. Busy workers poll between jobs.
+    xr::Core::AtomicFence();
+    if(mIdleCount == 0)
+    {
+        return;
+    }
+    // A parked worker without the role takes it on its way back to sleep.
+    mIdleMutex.Lock();
+    if(mTimerKeeper)
+    {
+        mTimerMonitor.Signal();
+    }
+    else
+    {
+        mIdleMonitor.Signal();
+    }
+    mIdleMutex.Unlock();
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-JobHandle  JobInstance::Initialize(Core::Runnable r, size_t antecedentCount)
+uint64_t ManagerInternal::DeadlineToTick(uint64_t microSeconds) const
 {
-    mRemainingAntecedents  = (uintptr_t)antecedentCount;
-    mRunnable              = r;
-    mXID                   = xr::Core::AtomicIncrement(&sGlobalXID);;
-    mEventListCount        = 0;
-
-    // A memset might be faster...
-    for(size_t i = 0; i < kEventListNumAllocated; i++)
-    {
-        mEventList[i] = nullptr;
-    }
-    return JobHandle(mXID, this);
+    // Next tick to start after the deadline, so nothing fires early.
+    return microSeconds / mOptions.mTimerTickMicroSeconds + 1;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-void JobInstance::Release()
+void ManagerInternal::PollTimers()
 {
-    XR_ASSERT_DEBUG_EQ(mXID, JobHandle::kJobInstanceHandleInvalid);
-    mFreeList->Push(this);
+    const Core::TimeStamp deadline = mNextTimerDeadline;
+    if(deadline != kNoTimer && Core::GetTimeStamp() >= deadline)
+    {
+        ServiceTimers();
+    }
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-JobInstance * JobInstance::Run()
+void ManagerInternal::ServiceTimers()
 {
-    XR_ASSERT_ALWAYS_EQ(mRemainingAntecedents, 0);
-
-    uint64_t xid = mXID;
-    XR_UNUSED(xid);
-    XR_ASSERT_ALWAYS_NE(xid, JobHandle::kJobInstanceHandleInvalid);
-
-    // Run the job.
-    if(mRunnable != nullptr)
+    // Someone else is on it (or inserting, and we will be back).
+    if(!mTimerMutex.TryLock())
     {
-#if (XR_PLATFORM_PTR_SIZE == 4) && defined(XR_COMPILER_MICROSOFT)
-
-        // Need to handle both _cdecl (1 arg) and _thiscall (at least for 0 arguments)
-        // Call convention differences make this simple as putting the argument into both
-        // ecx (_thiscall) and pushing it onto the stack (cdecl). Differences in stack 
-        // cleanup are safe because the function takes no arguments so the stack cleanup is 
-        // benign.
-        __asm mov  ecx, dword ptr[this];
-        __asm add  ecx, mArguments;
-        __asm mov  edx, dword ptr[this];
-        __asm mov  edx, dword ptr[edx + mRunnable];;
-        __asm push ecx;
-        __asm call edx;
-        __asm add  esp,4;
-
-#elif (XR_PLATFORM_PTR_SIZE == 4) && defined(XR_COMPILER_GCC)
-
-        // Lambda expects ecx to have pointer to captures...
-        // normal functions expect it on stack. Here we place it in both.
-        // I can't find any documentation on this but it is clear based on disasm
-        // at least as of gcc 4.7 and things like this rarely change for fear of 
-        // breaking compatibility across compiler versions.
-        asm(
-            "movl %0, %%ecx ;"
-            "movl %1, %%edx ;"
-            "push %%ecx ;"
-            "call *%%edx ;"
-            "pop %%ecx ;"
-            : : "r"(&mArguments), "r"(mRunnable) : "eax", "ecx", "edx"
-            );
-
-#else
-        // X64's (and most other arch's) ABI is less complicated
-        // no need for assembly to call function.
-        mRunnable(&mArguments);
-#endif
-
+        return;
     }
+    const uint64_t now = GetTimerMicroSeconds() / mOptions.mTimerTickMicroSeconds;
+    Timer * expired = mTimerWheel.Advance(now);
+    mNextTimerDeadline = TickToTimeStamp(mTimerWheel.GetNextTick());
+    for(Timer * timer = expired; timer != nullptr; timer = timer->mNext)
+    {
+        if(timer->mPeriod == 0)
+        {
+            timer->mJob->ClearDelayTimer();
+        }
+    }
+    mTimerMutex.Unlock();
 
-    //`````````````````````````````````````````````````````````````````
-    // Now do post run processing.
-    sMutex.Lock();
-
-    // Clear the XID, this signals the job as done.
-    mXID                       = JobHandle::kJobInstanceHandleInvalid;
-
-    sMutex.Unlock();
-    sMonitor.Broadcast();
-
-    //`````````````````````````````````````````````````````````````````
-    // Now process the event list. (Outside of the monitor lock!)
-    size_t count = (size_t)mEventListCount;
-    XR_ASSERT_ALWAYS_LE(count, kEventListNumAllocated);
-
-    // Optimization: Often a job will enable other jobs, in this case
-    // just run the newly enabled job, it is probably related.
-    JobInstance * first = nullptr;
-    uintptr_t i = 0;
-    for(; i < count; i++)
+    // Jobs are released outside the lock, they may insert timers.
+    Timer * spent = nullptr;
+    while(expired != nullptr)
     {
-        first = mEventList[i]->NotifyReturnOnEnabled();
-        if(first != nullptr)
+        Timer * timer = expired;
+        expired = timer->mNext;
+        if(timer->mPeriod == 0)
         {
-            ++i;
-            break;
+            timer->mJob->Notify();
+            timer->mNext = spent;
+            spent = timer;
+        }
+        else
+        {
+            Core::Arguments args((uintptr_t)timer, (uintptr_t)this);
+            InsertReady(&RunPeriodic, &args, Priority(timer->mPriority));
         }
     }
-    // Schedule any additional jobs.
-    for(; i < count; i++)
+    if(spent != nullptr)
     {
-        mEventList[i]->Notify();
+        mTimerMutex.Lock();
+        while(spent != nullptr)
+        {
+            Timer * timer = spent;
+            spent = timer->mNext;
+            FreeTimerLocked(timer);
+        }
+        mTimerMutex.Unlock();
     }
-
-    Release();
-
-    return first;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-bool JobInstance::IsComplete(uint64_t xid)
+void ManagerInternal::RunPeriodic(const Core::Arguments * args)
 {
-    if(mXID != xid)
+    Timer * timer = (Timer *)args->a0;
+    ManagerInternal * manager = (ManagerInternal *)args->a1;
+    if(!timer->mCancelled)
     {
-        // Definitely done. XID is invalidated after the job is complete.
-        return true;
+        timer->mRunnable(&timer->mArguments);
     }
-
-    return false;
+    manager->RearmPeriodic(timer);
 }
-
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-void JobInstance::AddNotificationLocked(JobInstance * source, JobInstance * notifies)
+void ManagerInternal::RearmPeriodic(Timer * timer)
 {
-    //`````````````````````````````````````````````````````````````````
-    // Job Not done yet, Add it to the list.
-    uintptr_t tempCount = source->mEventListCount;
+    const uint64_t now = GetTimerMicroSeconds();
 
-    //`````````````````````````````````````````````````````````````````
-    // Normal case, we can insert into the current job instance's memory
-    if(tempCount < kEventListMaxUsable )
+    mTimerMutex.Lock();
+    if(timer->mCancelled)
     {
-        XR_ASSERT_ALWAYS_NE(notifies, source);
-        source->mEventList[tempCount] = notifies;
-        source->mEventListCount = tempCount + 1;
+        FreeTimerLocked(timer);
+        mTimerMutex.Unlock();
         return;
     }
-
-    //`````````````````````````````````````````````````````````````````
-    // Job instance is already full of events... Need to create a dummy
-    // event to put this new one in. Generally this case should not
-    // happen. If it happens often perhaps one should increase
-    // kEventListMaxUsable.
-    else if(tempCount == kEventListMaxUsable)
+    // Deadlines missed while this run was queued or running are skipped.
+    timer->mDue += timer->mPeriod;
+    if(timer->mDue <= now)
     {
-        source->mEventListCount = tempCount + 1;
-
-        JobInstance * dummy = source->mFreeList->Pop();
-
-        dummy->Initialize(nullptr);
-
-        // This JobInstance is not linked in yet and is not
-        // in contention. Nor is it full, so insertion is trivial
-        // as long as we do it before it is linked.
-        dummy->mRemainingAntecedents = 1;
-        dummy->mEventListCount       = 1;
-        dummy->mEventList[0]         = notifies;
-
-        // Link in the Dummy.
-        source->mEventList[tempCount]        = dummy;
-        return;
+        timer->mDue += ((now - timer->mDue) / timer->mPeriod + 1) * timer->mPeriod;
     }
+    timer->mTick = DeadlineToTick(timer->mDue);
+    const bool earlier = AddTimerLocked(timer);
+    mTimerMutex.Unlock();
 
-    //`````````````````````````````````````````````````````````````````
-    // Find and update the existing dummy instance (or chain)
-    else if(tempCount > kEventListMaxUsable)
+    if(earlier)
     {
-        AddNotificationLocked(source->mEventList[kEventListMaxUsable],  notifies);
-        return;
+        WakeTimerKeeper();
     }
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-void JobInstance::AppendAntecedent(JobInstance * source, uint64_t source_xid)
+void ManagerInternal::ArmDelayed(JobInstance * ji, uint64_t delayMicroSeconds)
 {
-    bool added = true;
-    sMutex.Lock();
-    //`````````````````````````````````````````````````````````````````
-    // If the job is done, just notify already.
-    if(source->IsComplete(source_xid))
+    if(delayMicroSeconds == 0)
     {
-        added = false;
+        ji->Notify();
+        return;
     }
-    else
+    // Clamped well clear of overflow, a few thousand years is still never.
+    const uint64_t kMaxDelay = XR_UINT64_MAX / 4;
+    delayMicroSeconds = delayMicroSeconds < kMaxDelay ? delayMicroSeconds : kMaxDelay;
+
+    Timer * timer = AllocTimer();
+    timer->mJob  = ji;
+    timer->mTick = DeadlineToTick(GetTimerMicroSeconds() + delayMicroSeconds);
+
+    mTimerMutex.Lock();
+    ji->SetDelayTimer(timer);
+    const bool earlier = AddTimerLocked(timer);
+    mTimerMutex.Unlock();
+    if(earlier)
+    {
+        WakeTimerKeeper();
+    }
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void ManagerInternal::CancelDelayed(JobInstance * ji, uint64_t xid)
+{
+    mTimerMutex.Lock();
+    Timer * timer = ji->GetDelayTimer();
+    // Once the job completes the union is reused, but mXID changes first:
+    // checking it after the read catches a stale value.
+    xr::Core::AtomicFence();
+    if(timer == nullptr || ji->GetXid() != xid)
     {
-        AddNotificationLocked(source, this);
+        mTimerMutex.Unlock();
+        return;
     }
-    sMutex.Unlock();
+    XR_ASSERT_DEBUG_EQ(timer->mJob, ji);
+    mTimerWheel.Remove(timer);
+    ji->ClearDelayTimer();
+    FreeTimerLocked(timer);
+    mTimerMutex.Unlock();
 
-    // The job was already done.
-    if(!added)
+    ji->Notify();
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertDelayed(
+    uint64_t delayMicroSeconds,
+    Core::Runnable r,
+    const Core::Arguments *args,
+    Priority priority)
+{
+    JobHandleBlocked h = InsertBlocked(r, args, priority);
+    ArmDelayed(h.mInstance, delayMicroSeconds);
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle ManagerInternal::InsertDelayedPayload(
+    uint64_t delayMicroSeconds,
+    const detail::PayloadType * type,
+    void * object,
+    Priority priority)
+{
+    JobHandle h = InsertPayload(type, object, 1, nullptr, 0, priority);
+    ArmDelayed(h.mInstance, delayMicroSeconds);
+    return h;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+PeriodicHandle ManagerInternal::InsertPeriodic(
+    uint64_t periodMicroSeconds,
+    Core::Runnable r,
+    const Core::Arguments *args,
+    Priority priority)
+{
+    XR_ASSERT_ALWAYS_NE(periodMicroSeconds, uint64_t(0));
+
+    Timer * timer = AllocTimer();
+    timer->mPeriod   = periodMicroSeconds;
+    timer->mRunnable = r;
+    timer->mPriority = uint16_t(priority);
+    if(args != nullptr)
     {
-        Notify();
+        timer->mArguments = *args;
     }
+    timer->mDue  = GetTimerMicroSeconds() + periodMicroSeconds;
+    timer->mTick = DeadlineToTick(timer->mDue);
+
+    const PeriodicHandle handle(timer, timer->mID);
+    ArmTimer(timer);
+    return handle;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-size_t JobInstance::AppendAntecedents(JobHandle * handles, size_t antecedentCount)
+PeriodicHandle ManagerInternal::InsertPeriodicPayload(
+    uint64_t periodMicroSeconds,
+    const detail::PayloadType * type,
+    void * object,
+    Priority priority)
 {
-    size_t numAlreadyCompleted = 0;
-    sMutex.Lock();
-    for(size_t i = 0; i < antecedentCount; ++i)
+    XR_ASSERT_ALWAYS_NE(periodMicroSeconds, uint64_t(0));
+
+    // Kept until the timer is freed, each run calls it in place.
+    void * payload = AllocPayload(type->mSize);
+    type->mMove(payload, object);
+    Core::Arguments args((uintptr_t)payload);
+
+    Timer * timer = AllocTimer();
+    timer->mPeriod    = periodMicroSeconds;
+    timer->mRunnable  = type->mRunIndirect;
+    timer->mArguments = args;
+    timer->mPriority  = uint16_t(priority);
+    timer->mPayload   = payload;
+    timer->mDestroy   = type->mDestroy;
+    timer->mDue       = GetTimerMicroSeconds() + periodMicroSeconds;
+    timer->mTick      = DeadlineToTick(timer->mDue);
+
+    const PeriodicHandle handle(timer, timer->mID);
+    ArmTimer(timer);
+    return handle;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool ManagerInternal::CancelPeriodic(PeriodicHandle handle)
+{
+    Timer * timer = (Timer *)handle.mTimer;
+    if(timer == nullptr)
+    {
+        return false;
+    }
+
+    bool cancelled = false;
+    mTimerMutex.Lock();
+    if(timer->mID == handle.mID && timer->mPeriod != 0 && !timer->mCancelled)
     {
-        //`````````````````````````````````````````````````````````````````
-        // If the job is done, just notify already.
-        if(handles[i].IsDone())
+        cancelled = true;
+        if(timer->mLink != nullptr)
         {
-            ++numAlreadyCompleted;
+            mTimerWheel.Remove(timer);
+            FreeTimerLocked(timer);
         }
         else
         {
-            AddNotificationLocked(handles[i].mInstance, this);
+            // Queued or running, RearmPeriodic frees it.
+            timer->mCancelled = true;
         }
     }
-    sMutex.Unlock();
+    mTimerMutex.Unlock();
+    return cancelled;
+}
 
-    return numAlreadyCompleted;
+// ***************************************************************************************** - TYPE
+// BlockingPool Functions.
+// ***************************************************************************************** - TYPE
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+BlockingPool::BlockingPool()
+    : mRing(nullptr)
+    , mCapacity(0)
+    , mHead(0)
+    , mCount(0)
+    , mIdleCount(0)
+    , mMinThreads(0)
+    , mMaxThreads(0)
+    , mIdleMicroSeconds(0)
+    , mQuit(false)
+    , mThreadCount(0)
+    , mThreadHighWater(0)
+    , mJobsRun(0)
+{
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-void JobInstance::AppendAntecedent_NotStarted_NoLock(JobInstance * source)
+void BlockingPool::Initialize(size_t minThreads, size_t maxThreads, uint64_t idleMicroSeconds)
 {
-    AddNotificationLocked(source, this);
+    XR_ASSERT_ALWAYS_NE(maxThreads, size_t(0));
+    mMinThreads       = minThreads < maxThreads ? minThreads : maxThreads;
+    mMaxThreads       = maxThreads;
+    mIdleMicroSeconds = idleMicroSeconds;
+    mCapacity         = 16;
+    mRing             = (JobInstance **)XR_ALLOC(sizeof(JobInstance *) * mCapacity, "Scheduler::BlockingRing");
+
+    mMutex.Lock();
+    for(size_t i = 0; i < mMinThreads; ++i)
+    {
+        StartThreadLocked();
+    }
+    mMutex.Unlock();
 }
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void BlockingPool::Shutdown()
+{
+    mMutex.Lock();
+    mQuit = true;
+    mMonitor.Broadcast();
+    // Threads still running remove nothing from mThreads once mQuit is set.
+    for(BlockingThread * thread : mThreads)
+    {
+        mMutex.Unlock();
+        thread->Join();
+        mMutex.Lock();
+        XR_DELETE(thread);
+    }
+    mThreads.Clear();
+    JoinRetiredLocked();
+    mThreadCount = 0;
+    mMutex.Unlock();
 
+    XR_ASSERT_ALWAYS_EQ(mCount, size_t(0));
+    XR_FREE(mRing);
+    mRing = nullptr;
+}
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-void JobInstance::Notify()
+void BlockingPool::Enqueue(JobInstance * ji)
 {
-    uintptr_t initialValue;
-    do
+    mMutex.Lock();
+    XR_ASSERT_ALWAYS_EQ_M(mRing != nullptr, true, "Blocking job readied after the blocking pool shut down");
+    if(mCount == mCapacity)
     {
-        initialValue = mRemainingAntecedents;
-        // If the counter is 1, there is no contention. Just run it. 
-        if(initialValue == 1)
+        JobInstance ** ring = (JobInstance **)XR_ALLOC(sizeof(JobInstance *) * mCapacity * 2, "Scheduler::BlockingRing");
+        for(size_t i = 0; i < mCount; ++i)
         {
-            mRemainingAntecedents = 0;
-            mReadyList->Enqueue(this);
-            return;
+            ring[i] = mRing[(mHead + i) & (mCapacity - 1)];
         }
+        XR_FREE(mRing);
+        mRing      = ring;
+        mHead      = 0;
+        mCapacity *= 2;
+    }
+    mRing[(mHead + mCount) & (mCapacity - 1)] = ji;
+    ++mCount;
 
-        // Can move to "NoFence" version
-    } while( xr::Core::AtomicCompareAndSwap(&mRemainingAntecedents, initialValue, initialValue-1) != initialValue);
-
-    XR_ASSERT_ALWAYS_NE_M(initialValue, 0, "Job has invalid antecedents count!");
-    return;
+    // Everyone idle already has a job to take, so this one needs a thread.
+    if(mCount > mIdleCount && mThreadCount < mMaxThreads && !mQuit)
+    {
+        StartThreadLocked();
+    }
+    if(mIdleCount != 0)
+    {
+        mMonitor.Signal();
+    }
+    mMutex.Unlock();
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-JobInstance * JobInstance::NotifyReturnOnEnabled()
+JobInstance * BlockingPool::Pop(BlockingThread * self)
 {
-    uintptr_t initialValue;
-    do
+    mMutex.Lock();
+    while(mCount == 0)
     {
-        initialValue = mRemainingAntecedents;
-        // If the counter is 1, there is no contention. Just run it. 
-        if(initialValue == 1)
+        if(mQuit)
         {
-            mRemainingAntecedents = 0;
-            return this;
+            mMutex.Unlock();
+            return nullptr;
         }
-
-        // Can move to "NoFence" version
-    } while( xr::Core::AtomicCompareAndSwap(&mRemainingAntecedents, initialValue, initialValue-1) != initialValue);
-
-    XR_ASSERT_ALWAYS_NE_M(initialValue, 0, "Job has invalid antecedents count!");
-    return nullptr;
+        ++mIdleCount;
+        const bool signaled = mMonitor.Wait(mMutex, mIdleMicroSeconds);
+        --mIdleCount;
+        if(!signaled && mCount == 0 && !mQuit && mThreadCount > mMinThreads)
+        {
+            // Idle too long, leave. Joined by whoever starts the next one.
+            for(BlockingThread *& thread : mThreads)
+            {
+                if(thread == self)
+                {
+                    mThreads.Remove(&thread);
+                    break;
+                }
+            }
+            mRetired.Insert(self);
+            mThreadCount = mThreadCount - 1;
+            mMutex.Unlock();
+            return nullptr;
+        }
+    }
+    JobInstance * ji = mRing[mHead];
+    mHead = (mHead + 1) & (mCapacity - 1);
+    --mCount;
+    mJobsRun = mJobsRun + 1;
+    mMutex.Unlock();
+    return ji;
 }
-/*-----------------------------------------------------------------------*/
-/*-----------------------------------------------------------------------*/
-void JobInstance::WaitOn(uint64_t xid)
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void BlockingPool::StartThreadLocked()
 {
-    sMutex.Lock();
+    JoinRetiredLocked();
 
-    // Test predicate:
-    while(!IsComplete(xid))
+    BlockingThread * thread = XR_NEW("Scheduler::BlockingThread") BlockingThread();
+    thread->mPool = this;
+    mThreads.Insert(thread);
+    mThreadCount = mThreadCount + 1;
+    if(mThreadCount > mThreadHighWater)
     {
-        sMonitor.Wait(sMutex);
+        mThreadHighWater = mThreadCount;
     }
-
-    sMutex.Unlock();
-
+    thread->Start();
 }
-/*-----------------------------------------------------------------------*/
-/*-----------------------------------------------------------------------*/
-uint64_t JobInstance::GetXid() const
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void BlockingPool::JoinRetiredLocked()
 {
-    return mXID;
+    // They have left Pop, so joining can not wait on the lock we hold.
+    for(BlockingThread * thread : mRetired)
+    {
+        thread->Join();
+        XR_DELETE(thread);
+    }
+    mRetired.Clear();
 }
-/*-----------------------------------------------------------------------*/
-/*-----------------------------------------------------------------------*/
-void JobInstance::AppendBarrier( size_t count )
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+uintptr_t BlockingThread::Run()
 {
-    xr::Core::AtomicAdd(&mRemainingAntecedents , count);
-}
-
-
-class ManagerInternal : public IManager{
-public:
-
-    // ------------------------------------------------------------------------------------  MEMBER
-    // ------------------------------------------------------------------------------------  MEMBER
-    JobHandle InsertReady(
-        Core::Runnable r,
-        const Core::Arguments *args = nullptr) XR_OVERRIDE;
-    // ------------------------------------------------------------------------------------  MEMBER
-    // ------------------------------------------------------------------------------------  MEMBER
-    JobHandle InsertReady(
-        size_t runnableCount,
-        Core::Runnable * runnableArray,
-        size_t argumentsCount,
-        const Core::Arguments * argsArray) XR_OVERRIDE;
-    // ------------------------------------------------------------------------------------  MEMBER
-    // ------------------------------------------------------------------------------------  MEMBER
-    JobHandleBlocked InsertBlocked(
-        Core::Runnable r,
-        const Core::Arguments *args = nullptr) XR_OVERRIDE;
-    // ------------------------------------------------------------------------------------  MEMBER
-    // ------------------------------------------------------------------------------------  MEMBER
-    JobHandleBlocked InsertBlocked(
-        size_t runnableCount,
-        Core::Runnable * runnableArray,
-        size_t argumentsCount,
-        const Core::Arguments * argsArray) XR_OVERRIDE;
-    // ------------------------------------------------------------------------------------  MEMBER
-    // ------------------------------------------------------------------------------------  MEMBER
-    JobHandle InsertAfter(
-        Core::Runnable r,
-        const Core::Arguments *args,
-        JobHandle * handle0,
-        size_t handleCount) XR_OVERRIDE;
-
-private:
-
-    InitializeOptions                mOptions;
-    JobInstance                    * mInstances;
-    JobThread                      * mThreads;
-    xr::Core::BlockingQueue<JobInstance *> * mReadyList;
-    xr::Core::BlockingStack<JobInstance *> * mFreeList;
-
-    friend class IManager;
-};
+    for(;;)
+    {
+        JobInstance * ji = mPool->Pop(this);
+        if(ji == nullptr)
+        {
+            break;
+        }
+        while(ji != nullptr)
+        {
+            ji = ji->Run();
+            // A compute job it enabled goes to the workers.
+            if(ji != nullptr && ji->GetPriority() != kBlockingLane)
+            {
+                ji->GetManager()->Enqueue(ji);
+                ji = nullptr;
+            }
+        }
+    }
+    return 0;
+}
 
 // ***************************************************************************************** - TYPE
+// JobRunner Functions.
 // ***************************************************************************************** - TYPE
-JobHandle ManagerInternal::InsertReady(Core::Runnable r, const Core::Arguments *args)
+
+xr::Core::ThreadLocalStorage<JobThread*> JobThread::sCurrent;
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobThread * JobThread::GetCurrent()
 {
-    JobHandle h = mFreeList->Pop()->Initialize(r, 0, args);
-    mReadyList->Enqueue(h.mInstance);
-    return h;
+    return sCurrent.GetValue();
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-JobHandle ManagerInternal::InsertReady(
-    size_t runnableCount,
-    Core::Runnable *runnableArray,
-    size_t argumentsCount,
-    const Core::Arguments * argsArray)
+Core::TimeStamp JobThread::GetSpinBudget() const
 {
-    // Need an extra instance to wrap the collection.
-    JobInstance ** instances = (JobInstance **)alloca( sizeof(JobInstance*) * (runnableCount+1));
-    mFreeList->Pop(instances, (runnableCount+1));
+    // Cover most gaps of the recent past. When work usually takes longer
+    // than the limit to show up, just take a short look (which also lets
+    // the average come back down once it does not).
+    const Core::TimeStamp limit = mManager->mSpinLimit;
+    const Core::TimeStamp least = limit / 8;
+    if(mIdleGap > limit)
+    {
+        return least;
+    }
+    const Core::TimeStamp budget = mIdleGap * 2;
+    return budget < least ? least : (budget > limit ? limit : budget);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobThread::SpinForWork(Core::TimeStamp idleSince)
+{
+    const Core::TimeStamp budget = GetSpinBudget();
+    const size_t yieldCount = mManager->mOptions.mYieldCount;
+    if(budget == 0 && yieldCount == 0)
+    {
+        return nullptr;
+    }
 
-    // Make the last one the wrapper job.
-    JobHandle hWrap = instances[runnableCount]->Initialize(nullptr);
+    // Pauses between looks, a look touches every other worker's deques.
+    static const size_t kPausesPerLook = 32;
 
-    if(argumentsCount == 0)
+    xr::Core::AtomicIncrement(&mManager->mSpinningCount);
+    JobInstance * ji = nullptr;
+    while(budget != 0 && !IsQuitRequested())
     {
-        // This can be optimized.
-        for(size_t i = 0; i < runnableCount; i++)
+        for(size_t i = 0; i < kPausesPerLook; i++)
         {
-            instances[i]->Initialize(runnableArray[i], 0);
-            hWrap.mInstance->AppendAntecedent_NotStarted_NoLock(instances[i]);
+            SpinPause();
         }
-    }
-    else if(argumentsCount == 1)
-    {
-        // This can be optimized.
-        for(size_t i = 0; i < runnableCount; i++)
+        ji = FindWork();
+        if(ji != nullptr || Core::GetTimeStamp() - idleSince >= budget)
         {
-            instances[i]->Initialize(runnableArray[i], 0, &argsArray[0]);
-            hWrap.mInstance->AppendAntecedent_NotStarted_NoLock(instances[i]);
+            break;
         }
     }
-    else 
+    for(size_t i = 0; ji == nullptr && i < yieldCount && !IsQuitRequested(); i++)
     {
-        XR_ASSERT_ALWAYS_EQ(runnableCount, argumentsCount);
+        Core::Thread::YieldCurrentThread();
+        ji = FindWork();
+    }
+    // Before parking, see "Spinning" at the top of the file.
+    xr::Core::AtomicDecrement(&mManager->mSpinningCount);
+    return ji;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobThread::RunJob(JobInstance * ji)
+{
+    // Read before Run recycles ji.
+    const size_t group = ji->GetGroup();
+    const size_t lane = ji->GetPriority();
+    const size_t outerGroup = mRunningGroup;
+    const bool charge = ji != mUncharged;
+    const Core::TimeStamp start = group != 0 ? Core::GetTimeStamp() : 0;
+    mRunningGroup = group;
+    mUncharged = nullptr;
 
-        // This can be optimized.
-        for(size_t i = 0; i < runnableCount; i++)
+    const Core::LinearAllocator::Marker scratch = mScratch->GetMarker();
+    JobInstance * next = ji->IsFiber() ? RunFiber(ji) : (mManager->mTracing ? RunTraced(ji) : ji->Run());
+    mScratch->Rollback(scratch);
+    mCounters.mJobsRun = mCounters.mJobsRun + 1;
+
+    mRunningGroup = outerGroup;
+    if(group != 0)
+    {
+        // Gives back the slot FindGroupWork claimed.
+        const Core::TimeStamp elapsed = Core::GetTimeStamp() - start;
+        const size_t index = group - 1;
+        mGroupJobs[index] = mGroupJobs[index] + 1;
+        mGroupTime[index] = mGroupTime[index] + elapsed;
+        if(charge)
         {
-#if defined(XR_COMPILER_MICROSOFT)
-			// Supress bogus overflow warning.
-#pragma warning(disable: 6385)
-#endif
-            instances[i]->Initialize(runnableArray[i], 0, &argsArray[i]);
-            hWrap.mInstance->AppendAntecedent_NotStarted_NoLock(instances[i]);
+            mGroupDeficit[lane][index] -= elapsed;
         }
+        mManager->GetGroup(group)->Release();
     }
+    mManager->PollTimers();
+    return next;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobThread::RunTraced(JobInstance * ji)
+{
+    // Everything but the end time has to be read before Run recycles ji.
+    TraceRecord & record = mTrace[mTraceCount & (mManager->mOptions.mTraceEventCount - 1)];
+    record.mXID       = ji->GetXid();
+    record.mEnabledBy = ji->GetEnabledBy();
+    record.mRunnable  = ji->GetRunnable();
+    record.mStart     = Core::GetTimeStamp();
 
-    mReadyList->Enqueue(instances, runnableCount);
+    JobInstance * next = ji->Run();
 
-    return hWrap;
+    record.mEnd = Core::GetTimeStamp();
+    xr::Core::AtomicStoreRelease(&mTraceCount, mTraceCount + 1);
+    return next;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-JobHandleBlocked ManagerInternal::InsertBlocked(
-    size_t runnableCount,
-    Core::Runnable *runnableArray,
-    size_t argumentsCount,
-    const Core::Arguments * argsArray)
+JobInstance * JobThread::RunFiber(JobInstance * ji)
 {
-    
+    // Jobs only run on a worker's own stack, a fiber job never runs another.
+    XR_ASSERT_DEBUG_EQ(mFiber, (FiberSlot *)nullptr);
+    FiberSlot * slot = mManager->AllocFiber();
+    if(slot == nullptr)
+    {
+        xr::Core::AtomicIncrement(&mManager->mFibersExhausted);
+        return mManager->mTracing ? RunTraced(ji) : ji->Run();
+    }
+    slot->mJob   = ji;
+    slot->mToken = nullptr;
+    slot->mGroup = nullptr;
+    return EnterFiber(slot);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobThread::EnterFiber(FiberSlot * slot)
+{
+    slot->mThread = this;
+    mFiber = slot;
+    CancellationToken * threadToken = sCurrentToken.GetValue();
+    JobGroupState     * threadGroup = sCurrentGroup.GetValue();
+    sCurrentToken.SetValue(slot->mToken);
+    sCurrentGroup.SetValue(slot->mGroup);
 
-    JobInstance ** instances = (JobInstance **)alloca( sizeof(JobInstance*) * (runnableCount+1));
-    mFreeList->Pop(instances, (runnableCount+1));
+    Core::Fiber::Switch(mThreadFiber, slot->mFiber);
 
-    JobHandle hWrap = instances[runnableCount]->Initialize(nullptr, 1);
+    slot->mToken = sCurrentToken.GetValue();
+    slot->mGroup = sCurrentGroup.GetValue();
+    sCurrentToken.SetValue(threadToken);
+    sCurrentGroup.SetValue(threadGroup);
+    mFiber = nullptr;
 
-    if(argumentsCount == 0)
+    if(slot->mJob == nullptr)
     {
-        // This can be optimized.
-        for(size_t i = 0; i < runnableCount; i++)
-        {
-            instances[i]->Initialize(runnableArray[i], 0);
-            instances[i]->AppendAntecedent_NotStarted_NoLock(hWrap.mInstance);
-        }
+        JobInstance * next = slot->mNext;
+        mManager->FreeFiber(slot);
+        return next;
     }
-    else if(argumentsCount == 1)
+
+    // Switched out in SuspendFiber. Its context is saved now, so it is
+    // safe to let another worker resume it (possibly before this returns).
+    JobInstance * waitOn = slot->mWaitOn;
+    const uint64_t xid   = slot->mWaitXid;
+    slot->mWaitOn = nullptr;
+    mManager->ResumeAfter(slot, waitOn, xid, Priority(slot->mJob->GetPriority()));
+    return nullptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobThread::SuspendFiber(JobInstance * waitOn, uint64_t xid)
+{
+    FiberSlot * slot = mFiber;
+    mCounters.mFiberWaits = mCounters.mFiberWaits + 1;
+    slot->mWaitOn  = waitOn;
+    slot->mWaitXid = xid;
+    Core::Fiber::Switch(slot->mFiber, mThreadFiber);
+    // Resumed by ResumeFiber, maybe on another worker: this is stale.
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void FiberSlot::Main(void * context)
+{
+    FiberSlot * slot = (FiberSlot *)context;
+    for(;;)
     {
-        // This can be optimized.
-        for(size_t i = 0; i < runnableCount; i++)
-        {
-            instances[i]->Initialize(runnableArray[i], 0, &argsArray[0]);
-            instances[i]->AppendAntecedent_NotStarted_NoLock(hWrap.mInstance);
-        }
+        slot->mNext = slot->mJob->Run();
+        slot->mJob  = nullptr;
+        slot->mScratch->Clear();
+        // Back to the worker which resumed us last, EnterFiber frees us.
+        Core::Fiber::Switch(slot->mFiber, slot->mThread->mThreadFiber);
     }
-    else 
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobInstance * JobThread::StealWork(size_t lane)
+{
+    const size_t numThreads = mManager->GetActiveThreads();
+    if(numThreads < 2)
     {
-        XR_ASSERT_ALWAYS_EQ(runnableCount, argumentsCount);
+        return nullptr;
+    }
 
-        // This can be optimized.
-        for(size_t i = 0; i < runnableCount; i++)
+    // xorshift32
+    uint32_t x = mStealSeed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    mStealSeed = x;
+
+    JobInstance * ji = nullptr;
+    size_t victim = size_t(x) % numThreads;
+    // Local node on the first pass, remote nodes on the second.
+    const size_t numPasses = mManager->mNumNodes > 1 ? 2 : 1;
+    for(size_t pass = 0; pass < numPasses; ++pass)
+    {
+        for(size_t i = 0; i < numThreads; ++i)
         {
-            instances[i]->Initialize(runnableArray[i], 0, &argsArray[i]);
-            instances[i]->AppendAntecedent_NotStarted_NoLock(hWrap.mInstance);
+            JobThread & other = mManager->mThreads[victim];
+            bool inPass = numPasses == 1 || ((other.mNode == mNode) == (pass == 0));
+            if(victim != mIndex && inPass)
+            {
+                if(other.mDeques[lane]->UnsafeGetCount() != 0 && other.mDeques[lane]->Steal(&ji))
+                {
+                    mCounters.mSteals = mCounters.mSteals + 1;
+                    return ji;
+                }
+            }
+            victim = (victim + 1 == numThreads) ? 0 : victim + 1;
         }
     }
-
-    return JobHandleBlocked(hWrap);
+    return nullptr;
 }
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-xr::Scheduling::JobHandleBlocked ManagerInternal::InsertBlocked( Core::Runnable r, const Core::Arguments *args )
-{
-    JobHandle hWrap = mFreeList->Pop()->Initialize(r, 1, args);
-    return JobHandleBlocked(hWrap);
-}
-/*-----------------------------------------------------------------------*/
-/*-----------------------------------------------------------------------*/
-JobHandle ManagerInternal::InsertAfter(Core::Runnable r, const Core::Arguments * args, JobHandle * handle0, size_t handleCount)
+JobInstance * JobThread::FindWork(size_t lane)
 {
-    JobHandleBlocked h (mFreeList->Pop()->Initialize(r, handleCount, args));
+    JobInstance * ji = nullptr;
+    if(mDeques[lane]->Pop(&ji))
+    {
+        return ji;
+    }
 
-    size_t skippedCount = h.mInstance->AppendAntecedents(handle0, handleCount);
+    if(mManager->mGroupCount != 0)
+    {
+        ji = FindGroupWork(lane);
+        if(ji != nullptr)
+        {
+            return ji;
+        }
+    }
 
-    if(skippedCount != 0)
+    // Unlocked peek, no need to touch the queue's mutex when it is empty.
+    Core::BlockingQueue<JobInstance *> * shared = mManager->mReadyLists[lane];
+    if(shared->UnsafeGetAvailableCount() != 0 && shared->TryDequeue(&ji))
     {
-        // Release the ones that were already completed.
-        h.ReleaseBarrier(skippedCount);
+        return ji;
     }
 
-    return h;
+    return StealWork(lane);
 }
-
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-IManager * IManager::Initialize(InitializeOptions * options)
+JobInstance * JobThread::FindGroupWork(size_t lane)
 {
-    ManagerInternal * p = XR_NEW("Manager") ManagerInternal();
-    p->mOptions = *options;
+    const size_t count = mManager->GetGroupCount();
+    JobGroupState * const * groups = mManager->mGroups;
+    size_t & cursor = mGroupCursor[lane];
+    Core::TimeStamp * deficits = mGroupDeficit[lane];
 
-    p->mInstances = XR_NEW_ALIGN("Scheduler::Instances", 16)  JobInstance[options->mFreeListSize];
-    p->mThreads   = XR_NEW("Scheduler::Threads")    JobThread[options->mNumThreads];
-    p->mReadyList = XR_NEW("Scheduler::ReadyQueue") Core::BlockingQueue<JobInstance*>(options->mReadyListSize, "Scheduler::ReadyQueue");
-    p->mFreeList  = XR_NEW("Scheduler::FreeList")   Core::BlockingStack<JobInstance*>(options->mFreeListSize, "Scheduler::FreeList");
-
-    for(size_t i = 0; i < options->mNumThreads; i++)
+    // Deficit round robin, each lane on its own. The group whose turn it
+    // is runs while it has time left, then the next one gets a turn: its
+    // quantum is added to what it still owes, time it did not use is
+    // dropped. One round visits every group once and the current one twice.
+    for(size_t i = 0; i <= count; ++i)
     {
-        p->mThreads[i].mManager = p;
-        p->mThreads[i].mReadyQueue = p->mReadyList;
-        // Start the Thread.
-        p->mThreads[i].Start();
+        const size_t index = cursor;
+        if(deficits[index] > 0)
+        {
+            JobInstance * ji = groups[index]->TryTake(lane);
+            if(ji != nullptr)
+            {
+                return ji;
+            }
+        }
+        cursor = index + 1 < count ? index + 1 : 0;
+        const Core::TimeStamp deficit = deficits[cursor];
+        deficits[cursor] = (deficit < 0 ? deficit : 0) + groups[cursor]->mQuantum;
     }
 
-    for(size_t i = 0; i < options->mFreeListSize; i++)
+    // Nobody with a turn has work: rather than idle, run whatever there is
+    // and do not charge it.
+    for(size_t i = 0; i < count; ++i)
     {
-        p->mInstances[i].RunOnce(p->mFreeList, p->mReadyList);
-        // These are all free.
-        p->mFreeList->Push(&p->mInstances[i]);
+        const size_t index = (cursor + i) % count;
+        JobInstance * ji = groups[index]->TryTake(lane);
+        if(ji != nullptr)
+        {
+            mUncharged = ji;
+            return ji;
+        }
     }
-
-    return p;
+    return nullptr;
 }
-
-
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
-void IManager::Shutdown(IManager * m)
+JobInstance * JobThread::FindWork()
 {
-    ManagerInternal * sched = (ManagerInternal*)m;
-    // This is mainly used as a flag to ensure we intent to shut down
-    // (and that a nullptr was not accidentally placed in the queue)
-    for(size_t i = 0; i < sched->mOptions.mNumThreads; i++)
+    JobInstance * ji = nullptr;
+    const size_t interval = mManager->mOptions.mStarvationInterval;
+    if(interval != 0 && mPickCount >= interval)
     {
-        sched->mThreads[i].RequestQuit();
+        // Starvation guard, lowest priority first for this one pick.
+        for(size_t lane = kPriorityCount; lane-- != 0; )
+        {
+            ji = FindWork(lane);
+            if(ji != nullptr)
+            {
+                mPickCount = 0;
+                return ji;
+            }
+        }
+        return nullptr;
     }
 
-    for(size_t i = 0; i < sched->mOptions.mNumThreads; i++)
+    for(size_t lane = 0; lane < kPriorityCount; lane++)
     {
-        sched->mReadyList->Enqueue(nullptr);
+        ji = FindWork(lane);
+        if(ji != nullptr)
+        {
+            ++mPickCount;
+            return ji;
+        }
     }
-
-    for(size_t i = 0; i < sched->mOptions.mNumThreads; i++)
+    return nullptr;
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+void JobThread::HelpUntilComplete(JobInstance * waitOn, uint64_t xid)
+{
+    // Our job's group slot is given back meanwhile, what we wait on may be
+    // in the same group (and held by its cap).
+    const size_t group = mRunningGroup;
+    if(group != 0)
     {
-        // Join the Threads.
-        sched->mThreads[i].Join();
+        mManager->GetGroup(group)->Release();
     }
 
-    XR_DELETE(sched->mFreeList);
-    XR_DELETE(sched->mReadyList);
-    XR_DELETE_ARRAY(sched->mThreads);
-    XR_DELETE_ARRAY(sched->mInstances);
-    XR_DELETE(sched);
-}
-
-
+    // Local work first, it is LIFO so the most recently forked jobs (usually
+    // what we are waiting for, or its antecedents) come out first.
+    size_t idleCount = 0;
+    while(!waitOn->IsComplete(xid))
+    {
+        JobInstance * ji = FindWork();
+        if(ji != nullptr)
+        {
+            idleCount = 0;
+            while(ji != nullptr)
+            {
+                ji = RunJob(ji);
+            }
+            continue;
+        }
 
-// ***************************************************************************************** - TYPE
-// JobRunner Functions.
-// ***************************************************************************************** - TYPE
+        // Nothing to run, the job is on another worker. Yield for a while,
+        // then sleep as one of its waiters: its completion wakes us at
+        // once. The timeout only bounds how long work queued meanwhile
+        // (which wakes parked workers, not us) waits for another look.
+        const Core::TimeStamp blockedAt = Core::GetTimeStamp();
+        if(++idleCount < 64)
+        {
+            Core::Thread::YieldCurrentThread();
+        }
+        else
+        {
+            waitOn->SleepUntilComplete(xid, kHelpRecheckMicroSeconds);
+        }
+        mCounters.mBlocked = mCounters.mBlocked + (Core::GetTimeStamp() - blockedAt);
+    }
 
+    // Back in our job, even if that puts the group over its cap for a while.
+    if(group != 0)
+    {
+        xr::Core::AtomicIncrement(&mManager->GetGroup(group)->mRunning);
+    }
+}
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 uintptr_t JobThread::Run()
 {
-    uint64_t jobCount = 0;
+    sCurrent.SetValue(this);
+    if(mManager->mFiberSlots != nullptr)
+    {
+        mThreadFiber.AttachToThread();
+    }
+
+    // Start of the current busy spell, 0 while idle.
+    Core::TimeStamp busySince = 0;
+    // End of the last busy spell, 0 before the first.
+    Core::TimeStamp idleSince = 0;
     // This is basically it.
     for(;;)
     {
-        JobInstance * ji = mReadyQueue->Dequeue();
-        if(ji != nullptr)
+        mManager->PollTimers();
+        JobInstance * ji = FindWork();
+        if(ji == nullptr)
         {
-            while(ji != nullptr)
+            if(busySince != 0)
+            {
+                idleSince = Core::GetTimeStamp();
+                mCounters.mBusy = mCounters.mBusy + (idleSince - busySince);
+                busySince = 0;
+            }
+            if(IsQuitRequested())
+            {
+                break;
+            }
+            mManager->ClearBacklog();
+            ji = SpinForWork(idleSince);
+            if(ji != nullptr)
+            {
+                mCounters.mSpinHits = mCounters.mSpinHits + 1;
+            }
+            else if(mManager->Park(this))
+            {
+                // Idle long enough to retire. One last look first, a wake
+                // may have been meant for us, see "Elastic pool".
+                ji = FindWork();
+                if(ji == nullptr)
+                {
+                    mManager->Retire(this);
+                    continue;
+                }
+            }
+            else
             {
-                XR_LOG_TRACE_FORMATTED(&sScedulerLogHandle, "Thread:0x%" XR_UINTPTR_PRINTx " Starting JobInstance:0x%p" XR_EOL , this->GetID(), ji);
-                ji = ji->Run();
-                ++jobCount;
+                continue;
             }
         }
-        else
+
+        if(busySince == 0)
         {
-            // This nullptr should be intentionally present.
-            XR_ASSERT_ALWAYS_EQ(IsQuitRequested(), true);
-            break;
+            busySince = Core::GetTimeStamp();
+            if(idleSince != 0)
+            {
+                // Moving average over about 8 gaps. One long gap should not
+                // stop spinning for long, so it counts as twice the limit.
+                const Core::TimeStamp cap = mManager->mSpinLimit * 2;
+                const Core::TimeStamp gap = busySince - idleSince;
+                mIdleGap += ((gap < cap ? gap : cap) - mIdleGap) / 8;
+            }
+        }
+        while(ji != nullptr)
+        {
+            XR_LOG_TRACE_FORMATTED(&sScedulerLogHandle, "Thread:0x%" XR_UINTPTR_PRINTx " Starting JobInstance:0x%p" XR_EOL , this->GetID(), ji);
+            ji = RunJob(ji);
         }
     }
 
+    if(mManager->mFiberSlots != nullptr)
+    {
+        mThreadFiber.DetachFromThread();
+    }
+    sCurrent.SetValue(nullptr);
 
-    XR_LOG_DEBUG_FORMATTED(&sScedulerLogHandle, "Thread:0x%" XR_UINTPTR_PRINTx " ran %" XR_UINT64_PRINT " Jobs" XR_EOL , this->GetID(), jobCount);
+    XR_LOG_DEBUG_FORMATTED(&sScedulerLogHandle, "Thread:0x%" XR_UINTPTR_PRINTx " ran %" XR_UINT64_PRINT " Jobs" XR_EOL , this->GetID(), uint64_t(mCounters.mJobsRun));
     return 0;
 }
 // ***************************************************************************************** - TYPE
@@ -827,6 +5580,25 @@ bool           JobHandle::IsDone() const  { return mInstance->IsComplete(mXID);
 // --------------------------------------------------------------------------------------  FUNCTION
 // --------------------------------------------------------------------------------------  FUNCTION
 void           JobHandle::WaitOn() const  { mInstance->WaitOn(mXID); }
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+bool JobHandle::Cancel(CancelPolicy policy) const
+{
+    return mInstance->Cancel(mXID, policy);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobHandle JobHandle::ThenPayload(const detail::PayloadType * type, void * object, Priority priority) const
+{
+    ManagerInternal * manager = mInstance->GetManager();
+    if(manager == nullptr)
+    {
+        // IManager::GetCompletedHandle(), no scheduler to queue it on.
+        type->mRun((const Core::Arguments *)object);
+        return IManager::GetCompletedHandle();
+    }
+    return manager->InsertPayload(type, object, 0, const_cast<JobHandle *>(this), 1, priority);
+}
 
 
 static const uintptr_t kJobBarrierReleaser_Checkword = 0x9719661d;
@@ -867,6 +5639,38 @@ void JobHandleBlocked::ReleaseBarrier( size_t count /*= 1*/ )
     }
 }
 
+// ***************************************************************************************** - TYPE
+// CancellationScope Functions.
+// ***************************************************************************************** - TYPE
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+CancellationScope::CancellationScope(CancellationToken * token)
+{
+    mPrevious = EnterTokenScope(token);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+CancellationScope::~CancellationScope()
+{
+    LeaveTokenScope(mPrevious);
+}
+
+// ***************************************************************************************** - TYPE
+// JobGroupScope Functions.
+// ***************************************************************************************** - TYPE
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobGroupScope::JobGroupScope(JobGroup group)
+{
+    mPrevious = EnterGroupScope((JobGroupState *)group.mGroup);
+}
+// --------------------------------------------------------------------------------------  FUNCTION
+// --------------------------------------------------------------------------------------  FUNCTION
+JobGroupScope::~JobGroupScope()
+{
+    LeaveGroupScope((JobGroupState *)mPrevious);
+}
+
 }}//namespace xr
 
 // ######################################################################################### - FILE